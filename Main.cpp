@@ -10,9 +10,38 @@
 // Included libraries:
 #include <iostream>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
+#include <limits.h>
 #include <fstream>
 #include <time.h>
+#include <coroutine>
+#include <vector>
+#include <queue>
+#include <random>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <map>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/inotify.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/eventfd.h>
+#include <sys/vfs.h>
+#include <linux/magic.h>
+#include <ftw.h>
 
 using namespace std;
 
@@ -24,17 +53,57 @@ const char* GPIO_UNEXPORT =                     // Name of the file for
 	"sys/class/gpio/unexport";                  // deactivating a GPIO pin
 const char* GPIO_DIRECTORY =                    // Prefix for the directory for
 	"sys/class/gpio/gpio";                      // controlling a GPIO pin
-
+const char* GPIO_ROOT =                         // Directory holding the
+	"sys/class/gpio";                           // directories of the pins
+
+const char SNAPSHOT_FILE[] =                    // Name of the file a warm
+	"deltaT.snapshot";                          // restart resumes from
+const char SNAPSHOT_TEMP_FILE[] =               // Name of the file written
+	"deltaT.snapshot.tmp";                      // before replacing the
+	                                            // snapshot file
+const char BOOT_ID_FILE[] =                     // Name of the file which
+	"/proc/sys/kernel/random/boot_id";          // identifies the boot
 const char STAT_FILE[] =                        // Name of the statistics file
 	"deltaT.stat";
+const char STAT_TEMP_FILE[] =                   // Name of the file written
+	"deltaT.stat.tmp";                          // before replacing the
+	                                            // statistics file
+const char JOURNAL_FILE[] =                     // Name of the statistics
+	"deltaT.journal";                           // journal file
+const char LEADERBOARD_FILE[] =                 // Name of the leaderboard
+	"deltaT.board";                             // file
+const char SKETCH_FILE[] =                      // Name of the press timing
+	"deltaT.sketch";                            // sketch file
+const char HISTORY_FILE[] =                     // Name of the session
+	"deltaT.history";                           // history file
+const char SHARED_STATE_NAME[] =                // Name of the shared memory
+	"/deltaT.state";                            // segment mirroring the game
+const char SHARED_STATE_BENCHMARK_NAME[] =      // Name of the segment used
+	"/deltaT.state.benchmark";                  // by the shared state
+	                                            // benchmark
+const char EVENT_RING_NAME[] =                  // Name of the shared memory
+	"/deltaT.events";                           // segment of game events
+const char EVENT_RING_BENCHMARK_NAME[] =        // Name of the segment used
+	"/deltaT.events.benchmark";                 // by the event stream
+	                                            // benchmark
+const char CONTROL_SOCKET[] =                   // Name of the socket which
+	"deltaT.sock";                              // controls a daemon
+const char DEFAULT_PLAYER_NAME[] =              // Name recorded for players
+	"anonymous";                                // who did not give one
 const char LOG_FILE[] =                         // Name of the log file
 	"deltaT.log";
+const char TOOL_LOG_FILE[] =                    // Name of the log file of
+	"deltaT.tools.log";                         // modes which run instead
+	                                            // of the game
+const char STAND_IN_TREE_TEMPLATE[] =           // Template of the directory
+	"/tmp/deltaT.gpio.XXXXXX";                  // a stand-in GPIO tree is
+	                                            // built in
 
 const float TIME_PER_LEVEL = 60;                // Time per level in seconds
 const float INITIAL_TIME_PER_LIGHT = 0.4;       // Time per light in seconds
 const float SCALING_TIME_PER_LIGHT = 0.50;      // Multiplier for the duration
                                                 // a light is on
-const float DEFAULT_PAUSE_TIME = 0.5;           // Time the game will pause for
+constexpr float DEFAULT_PAUSE_TIME = 0.5;       // Time the game will pause for
                                                 // at the end of a level
 const float MAX_IDLE_TIME = 15;                 // Time for which the game will
                                                 // idle before exiting
@@ -43,16 +112,240 @@ const int TOTAL_NUM_LIGHTS = 9;                 // The total number of lights
 const int TARGET_INDEX = 4;                     // Index of the target light
 const int INITIAL_NUM_LIVES = 3;                // Initial number of lives
 const int MAX_LINE_LENGTH = 100;                // Length of a line in a file
+const double LOG_LIMIT_RATE = 10;               // Messages per second a
+                                                // limited call site may log
+const int LOG_LIMIT_BURST = 20;                 // Messages a limited call
+                                                // site may log at once
+const double GPIO_READY_TIMEOUT = 5;            // Time in seconds to wait for
+                                                // exported pins to be usable
+const double GPIO_RECHECK_INTERVAL = 0.05;      // Time in seconds between
+                                                // checks of pins which have
+                                                // not reported a change
+const unsigned int SNAPSHOT_MAGIC = 0x57544C44; // Marks a snapshot file
+const unsigned int SNAPSHOT_VERSION = 2;        // Snapshot file layout
+const int OUTPUT_RING_ENTRIES = 16;             // Number of writes which fit
+                                                // in the output io_uring
+const int MAX_JOURNAL_RECORDS = 1024;           // Number of journal records
+                                                // which triggers compaction
+const unsigned int LEADERBOARD_MAGIC =          // Marks a leaderboard file
+	0x42544C44;
+const unsigned int LEADERBOARD_VERSION = 1;     // Leaderboard file layout
+const int LEADERBOARD_LEVELS = 12;              // Number of levels in the
+                                                // leaderboard skip list
+const int INITIAL_LEADERBOARD_CAPACITY = 1024;  // Number of records in a new
+                                                // leaderboard file
+const int MAX_PLAYER_NAME_LENGTH = 16;          // Length of a player name
+                                                // including the terminator
+const int SKETCH_CAPACITY = 128;                // Number of values at which a
+                                                // sketch compactor is halved
+const int MAX_SKETCH_HEIGHT = 48;               // Number of compactors a
+                                                // sketch may stack
+const int MAX_SKETCH_LEVELS = 16;               // Number of levels with their
+                                                // own press timing sketch
+const unsigned int HISTORY_MAGIC = 0x48544C44;  // Marks a history block
+const int HISTORY_BLOCK_ROWS = 512;             // Number of sessions in each
+                                                // session history block
+const int MAX_HISTORY_LEVELS = 16;              // Number of levels whose time
+                                                // per light is kept
+const unsigned int SHARED_STATE_MAGIC =         // Marks a shared memory
+	0x53544C44;                                 // segment which is set up
+const int SHARED_TOP_SCORES = 5;                // Number of leaderboard scores
+                                                // mirrored to shared memory
+const unsigned int EVENT_RING_MAGIC =           // Marks an event ring which
+	0x45544C44;                                 // is set up
+const int EVENT_RING_CAPACITY = 1024;           // Number of events kept for
+                                                // subscribers
+const unsigned int RECORDING_MAGIC =            // Marks an input recording
+	0x52544C44;
+const unsigned int RECORDING_VERSION = 1;       // Input recording layout
+const double REPLAY_PRESS_MARGIN = 1e-6;        // Time a replayed press is
+                                                // kept before the deadlines
+const int CONTROL_BACKLOG = 4;                  // Number of control clients
+                                                // which may wait to connect
+const int CONTROL_CLIENT_TIMEOUT = 5;           // Time in seconds a control
+                                                // client may stay silent
+const int PWM_SLOTS = 16;                       // Number of slots in a period
+                                                // of the software PWM
+const float PWM_TRAIL_TIME = 0.15;              // Time in seconds a light
+                                                // takes to fade once it is
+                                                // turned off
+const int BUTTON_RECHECK_INTERVAL = 10;         // Time in milliseconds between
+                                                // checks of the button when
+                                                // it cannot wake on an edge
+const float MIN_TIME_PER_LIGHT =                // Shortest time in seconds a
+	BUTTON_RECHECK_INTERVAL / 1000.0f;          // light is on
+const double MAX_INPUT_OUTAGE = 1;              // Time in seconds the button
+                                                // may fail to be read before
+                                                // the game gives up
 const int TOTAL_NUM_PINS = 10;                  // Total number of available
                                                 // pins on the SoC
 const int PIN_IDS[10] = {                       // IDs of the pins that will be
 	0, 18, 6, 4, 5, 2, 3, 11, 45, 1             // used
 };
+const double TIMER_RESOLUTION = 0.0001;         // Length of a timer wheel
+                                                // tick in seconds
+const int SHIFT_REGISTER_PIN_IDS[3] = {         // IDs of the data, clock and
+	12, 13, 14                                  // latch pins of a shift
+};                                              // register chain
+const int DEFAULT_SHIFT_REGISTER_LIGHTS = 64;   // Number of outputs in a
+                                                // shift register chain
+const int MAX_SHIFT_REGISTER_LIGHTS = 256;      // Most outputs a chain may
+                                                // have
+const int NUM_SEGMENTS = 7;                      // Segments in a display digit
+const int DISPLAY_NUM_DIGITS = 4;               // Digits in the score display
+const int SEGMENT_PIN_IDS[NUM_SEGMENTS] = {     // IDs of the pins of segments
+	15, 16, 17, 19, 20, 21, 22                  // a to g of the display
+};
+const int DIGIT_PIN_IDS[DISPLAY_NUM_DIGITS] = { // IDs of the pins enabling
+	23, 24, 25, 26                              // each digit of the display
+};
+const int DISPLAY_REFRESH_RATE = 1000;          // Digits lit per second
+const int DISPLAY_JITTER_BUCKETS = 100;         // Number of buckets counting
+                                                // late display refreshes
+const double DISPLAY_JITTER_BUCKET_TIME = 1e-5; // Width of a bucket in seconds
+const int NUM_PLAYERS = 2;                      // Players in a head-to-head
+                                                // game
+const int SECOND_BUTTON_PIN_ID = 27;            // ID of the pin of the second
+                                                // player's button
+const int HEAD_TO_HEAD_ROUNDS = 5;              // Rounds a player must win to
+                                                // win a head-to-head game
+const double PERFECT_PRESS_TIME = 0.015;        // Most time in seconds after
+                                                // the light enters the
+                                                // passing position for a
+                                                // perfect press
+const double GREAT_PRESS_TIME = 0.04;           // Most time in seconds for a
+                                                // great press
+const float PERFECT_PRESS_FRACTION = 0.25;      // Most fraction of the time
+                                                // per light for a perfect
+                                                // press, if that is shorter
+const float GREAT_PRESS_FRACTION = 0.5;         // Most fraction of the time
+                                                // per light for a great press
+const double HEAD_TO_HEAD_FRAME_TIME = 0.002;   // Time in seconds after a
+                                                // press in which the other
+                                                // player's press is judged
+                                                // with it
+const int TIMER_WHEEL_LEVELS = 4;               // Number of levels in the
+                                                // timer wheel
+const int TIMER_WHEEL_SLOT_BITS = 8;            // Number of bits of a tick
+                                                // used per level
+const int TIMER_WHEEL_SLOTS =                   // Number of slots per level
+	1 << TIMER_WHEEL_SLOT_BITS;
+const int SIMULATION_LANES = 4;                 // Number of games simulated
+                                                // by each vector operation
+const int MAX_SIMULATED_LEVELS = 10000;         // Level at which a simulated
+                                                // or replayed game is stopped
+const int MAX_TRACKED_EXPIRIES = 16;            // Largest number of timers
+                                                // expiring in one tick which
+                                                // is counted separately
 
 // -------------- [Global constant declarations end here] -------------- //
 
 
 
+// ------------------ [Timer wheel class begins here] ------------------ //
+
+/*************************************************************************
+	This class holds every pending deadline in a hierarchical timing
+	wheel. Adding and cancelling a timer takes constant time, and the
+	earliest time at which any timer may expire can be found without
+	looking at every timer, so the main loop can block until then.
+ *************************************************************************/
+
+// Function called when a timer expires
+typedef void (*TimerCallback)(void* context, int value);
+
+// Identifier for a timer in a timer wheel
+struct TimerId {
+	int      index;             // Index of the timer's entry, or -1
+	unsigned generation;        // Generation of the entry when it was added
+};
+
+class TimerWheel {
+	private:
+		// Pending timer
+		struct TimerEntry {
+			double        time;     // Time at which the timer expires
+			long long     tick;     // Tick in which the timer expires
+			unsigned long long sequence;  // Orders timers expiring together
+			TimerCallback callback; // Function called on expiry
+			void*         context;  // Arguments for the callback
+			int           value;
+			unsigned      generation;  // Invalidates stale identifiers
+			int           level;    // Level holding the timer, or one of
+			                        // TIMER_DUE and TIMER_FREE
+			int           slot;     // Slot holding the timer
+			int           previous; // Neighbours in the slot's list, or
+			int           next;     // the next free entry
+		};
+
+		// Timer whose tick has been reached, waiting for its exact time
+		struct DueTimer {
+			double             time;
+			unsigned long long sequence;
+			int                index;
+			unsigned           generation;
+
+			bool operator> (const DueTimer& other) const {
+				if (time != other.time) {
+					return time > other.time;
+				}
+
+				return sequence > other.sequence;
+			}
+		};
+
+		static const int TIMER_DUE  = -1;
+		static const int TIMER_FREE = -2;
+
+		double    resolution;       // Length of a tick in seconds
+		double    originTime;       // Time at which tick 0 starts
+		long long currentTick;      // Next tick to be processed
+		unsigned long long nextSequence;
+		int       freeList;         // First unused entry, or -1
+		int       numActive;        // Number of pending timers
+
+		vector<TimerEntry> entries;
+		int heads[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+		unsigned long long occupied[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS / 64];
+		priority_queue<DueTimer, vector<DueTimer>, greater<DueTimer> > due;
+
+		// Monitoring of how many timers expire in each tick
+		long long tickExpiryCounts[MAX_TRACKED_EXPIRIES + 1];
+		long long countingTick;
+		int       countingExpiries;
+		long long totalExpired;
+		int       maxExpiriesPerTick;
+
+		long long tickFromTime(double time);
+		double    timeFromTick(long long tick);
+		void      link(int index);
+		void      unlink(int index);
+		void      release(int index);
+		void      cascade(int level);
+		void      processTick();
+		int       findOccupied(int level, int fromSlot, int toSlot);
+		void      recordExpiry(long long tick);
+		void      flushExpiryCount();
+
+	public:
+		TimerWheel(double resolution, double originTime);
+		TimerId   add(double time, TimerCallback callback, void* context,
+			int value);
+		bool      cancel(TimerId& id);
+		void      advance(double now);
+		double    nextExpiry();
+		bool      isEmpty();
+		int       getNumActive();
+		long long getTickExpiryCount(int numExpired);
+		long long getTotalExpired();
+		int       getMaxExpiriesPerTick();
+		void      logStatistics(const char* owner);
+};
+
+// ------------------- [Timer wheel class ends here] ------------------- //
+
+
+
 // --------------------- [Timer class begins here] --------------------- //
 
 /*************************************************************************
@@ -61,19 +354,26 @@ const int PIN_IDS[10] = {                       // IDs of the pins that will be
 
 class Timer {
 	private:
-		// The designated ending time
-		clock_t stopTime;
+		// The timer in the system timer wheel
+		TimerId timerID;
+
+		// Whether the designated ending time has passed
+		bool hasFinished;
+
+		static void onExpire(void* context, int value);
 
 	public:
 		// Constructor
 		Timer () {
 
-			// Initialize stop time to an invalid value
-			stopTime = -1;
+			// Initialize timer to an invalid value
+			timerID.index = -1;
+			timerID.generation = 0;
+			hasFinished = false;
 		}
 
 		// Deconstructor
-		~Timer () {}
+		~Timer ();
 
 		// Set timer for some number of seconds in the future
 		bool setStopTime (float seconds);
@@ -93,17 +393,45 @@ class Timer {
  *************************************************************************/
 
 class Logger {
+	private:
+		const char* fileName;   // Name of the log file, once opened
+
 	public:
 		std::ofstream sysLog;
 
 		// Constructor
 		Logger () {
-			// Create log file
-			sysLog.open(LOG_FILE);
+			// The log file is only created by open(), so that modes which
+			// follow a running game leave the game's log alone
+			fileName = NULL;
+		}
+
+		// Create log file, replacing the log of the last run
+		bool open (const char* fileName) {
+			this->fileName = fileName;
+			sysLog.open(fileName);
 
 			// Check if file could be opened
 			if (!sysLog.is_open()) {
 				cerr << "[Logger] ERROR: Log file could not be created." << endl;
+
+				return false;
+			}
+
+			return true;
+		}
+
+		// Get the name of the log file
+		const char* getFileName () {
+			return fileName;
+		}
+
+		// Enable or disable writing to the log file
+		void setEnabled (bool isEnabled) {
+			if (isEnabled) {
+				sysLog.clear();
+			} else {
+				sysLog.setstate(ios::badbit);
 			}
 		}
 };
@@ -112,6 +440,49 @@ class Logger {
 
 
 
+// ------------------- [Log limit class begins here] -------------------- //
+
+/*************************************************************************
+	This class limits how often one call site writes to the log, for
+	messages which would otherwise be written on every poll or step. A
+	site keeps a static LogLimit and only logs when allow() says so. The
+	limit is a token bucket kept as the time it will next be full, in
+	the generic cell rate form, so a check is one clock read and one
+	compare-and-swap. Only the counters are atomic and the log is not,
+	so limited sites, like every other site which logs, may only be
+	reached from the game thread. Worker threads use the functions which
+	do not log, such as GPIOHandler::writeState(). Messages over
+	the limit are counted and written as "N more <description>
+	message(s) suppressed" before the site's next message, as they need
+	not match the message which is let through. Every site links itself
+	into a list so that the counts can be reported at shutdown.
+ *************************************************************************/
+
+class LogLimit {
+	private:
+		const char* site;           // Prefix of the site's messages
+		const char* description;    // What the site's messages report
+		long long interval;         // Nanoseconds per message
+		long long tolerance;        // Nanoseconds of burst allowed
+		std::atomic<long long> fullTime;   // Time the bucket would have
+		                                   // its last token back
+		std::atomic<unsigned long long> numRepeats;    // Dropped since
+		                                               // the last message
+		std::atomic<unsigned long long> numSuppressed; // Dropped in total
+		LogLimit* next;             // Next site in the list
+
+		static std::atomic<LogLimit*> sites;   // First site in the list
+
+	public:
+		LogLimit(const char* site, const char* description);
+		bool allow();
+		static void reportAll();
+};
+
+// -------------------- [Log limit class ends here] --------------------- //
+
+
+
 // ------------------ [GPIO Handler class begins here] ----------------- //
 
 /*************************************************************************
@@ -123,6 +494,9 @@ class GPIOHandler {
 		char* directoryName;    // Directory for controlling a GPIO pin
 		int   pinID;            // Identifier for addressing pin
 		char* valueFileName;    // Name of the file for controlling a GPIO pin
+		int   valueFileDescriptor;  // Value file kept open for writing
+		char* directionFileName;    // Name of the file for setting the
+		                            // direction of a GPIO pin
 
 		ifstream inFile;        // File for generic file reading
 		ofstream outFile;       // File for generic file writing
@@ -132,6 +506,7 @@ class GPIOHandler {
 		bool concatenate(
 			const char* string1, const char* string2, char*& output
 		);
+		bool buildValueFileName();
 
 	public:
 		GPIOHandler(int pinID);
@@ -141,32 +516,571 @@ class GPIOHandler {
 		bool deactivate();
 		bool setType(bool isInput);
 		bool getState(bool& state);
+		bool readState(bool& isOn);
 		bool setState(bool isOn);
+		bool writeState(bool isOn);
+		int  getValueFileDescriptor();
+		bool isActivated();
+		bool isReady(bool isInput);
+		int  configure(bool isInput);
+		int  getPinID();
+		const char* getDirectoryName();
+		const char* getValueFileName();
+		bool setEdge(const char* edge);
 };
 
 // ------------------- [GPIO Handler class ends here] ------------------ //
 
 
 
+// ----------------- [Fault injector class begins here] ----------------- //
+
+/*************************************************************************
+	This class degrades the GPIO pins the way real boards do, so that the
+	game's timing and error handling can be tried without hardware. It
+	is loaded from a file of lines such as
+
+		read  delay uniform 0 0.0002    # Delay of each access
+		write delay exponential 0.0001
+		write spike 0.01 0.005          # Chance of a long stall, and its
+		                                # length
+		read  error 0.001               # Chance of failing with EIO
+		stuck 1 0 2.5 0.5               # Pin 1 holds 0 from 2.5 s after
+		                                # injection starts, for 0.5 s
+		seed  42
+
+	Delays are "fixed <s>", "uniform <min> <max>" or "exponential
+	<mean>". Reads and writes of GPIOHandler and the frames of every
+	LightOutput backend pass through it. It is called from the threads
+	driving the pins, so it never logs while injecting.
+ *************************************************************************/
+
+// Kinds of access to a pin
+enum FaultAccess {
+	FAULT_READ,
+	FAULT_WRITE,
+	NUM_FAULT_ACCESSES
+};
+
+// Distributions a delay is drawn from
+enum DelayKind {
+	DELAY_NONE,
+	DELAY_FIXED,                // Always the first parameter
+	DELAY_UNIFORM,              // Between the two parameters
+	DELAY_EXPONENTIAL           // With the first parameter as its mean
+};
+
+// Faults injected into one kind of access
+struct FaultProfile {
+	DelayKind delayKind;        // Distribution of the delay of each access
+	double delayParameters[2];  // Parameters of the distribution
+	double spikeRate;           // Chance an access stalls for spikeTime
+	double spikeTime;           // Length of a stall in seconds
+	double errorRate;           // Chance an access fails with EIO
+	std::atomic<unsigned long long> numAccesses;
+	std::atomic<unsigned long long> numSpikes;
+	std::atomic<unsigned long long> numErrors;
+	std::atomic<double> totalDelay;
+};
+
+// Pin holding a value for a while, whatever is written to or read from it
+struct StuckPin {
+	int pinID;                  // Identifier of the pin
+	bool isOn;                  // Value the pin holds
+	double startTime;           // Time it sticks, after injection starts
+	double endTime;             // Time it comes free
+};
+
+class FaultInjector {
+	private:
+		bool hasFaults;             // Whether faults have been loaded
+		std::atomic<bool> isEnabled;        // Whether faults are being
+		                                    // injected, switched while
+		                                    // worker threads read it
+		std::atomic<double> startTime;      // Time injection started
+		FaultProfile profiles[NUM_FAULT_ACCESSES];
+		vector<StuckPin> stuckPins;
+		std::mt19937 generator;     // Draws delays and faults
+		std::mutex generatorLock;   // Lets pins on other threads draw
+		std::atomic<unsigned long long> numStuckAccesses;
+
+		bool parseLine(const char* line);
+		double drawUniform();
+
+	public:
+		FaultInjector();
+		bool load(const char* fileName);
+		void setEnabled(bool isEnabled);
+		bool isLoaded();
+		bool inject(FaultAccess access);
+		bool holdsValue(int pinID, bool& isOn);
+		void report(ostream& output, const char* prefix);
+};
+
+// ------------------ [Fault injector class ends here] ------------------ //
+
+
+
+// Global faults injected into the GPIO pins
+FaultInjector gpioFaults;
+
+
+
+// ----------------- [Stand-in tree class begins here] ------------------ //
+
+/*************************************************************************
+	This class builds a temporary copy of the GPIO directory tree for
+	the hardware benchmarks to run in when the pins are not the
+	kernel's. Every pin the game can use gets a directory with a
+	direction and a value file, and the process works inside the copy
+	until it leaves, when the copy is removed. The log stays in the
+	directory it was opened in.
+ *************************************************************************/
+
+class StandInTree {
+	private:
+		char directoryName[sizeof(STAND_IN_TREE_TEMPLATE)]; // Temporary
+		                            // directory, or empty if the real
+		                            // pins are used
+		int  previousDirectory;     // Working directory to return to, or -1
+
+		bool makePin(int pinID);
+
+	public:
+		StandInTree();
+		~StandInTree();
+		bool enter();
+		void leave();
+};
+
+// ------------------ [Stand-in tree class ends here] ------------------- //
+
+
+
+// ---------------- [Shift register class begins here] ----------------- //
+
+/*************************************************************************
+	This class drives a strip through daisy-chained 74HC595 shift
+	registers, so three pins (data, clock and latch) can light any number
+	of LEDs. A frame is shifted in bit by bit and shown all at once when
+	the latch pin pulses. Since shifting moves every bit already in the
+	chain along by one, a frame which is the last one moved along by k
+	lights, such as a light stepping away from the first register, only
+	needs its first k bits sent. The data pin is only written when the
+	next bit differs from the last.
+ *************************************************************************/
+
+// Pins of the shift register chain
+enum ShiftRegisterPin {
+	SHIFT_DATA,                 // Serial data input (DS)
+	SHIFT_CLOCK,                // Shift clock (SHCP)
+	SHIFT_LATCH,                // Storage register clock (STCP)
+	NUM_SHIFT_REGISTER_PINS
+};
+
+class ShiftRegisterOutput {
+	private:
+		GPIOHandler* pins[NUM_SHIFT_REGISTER_PINS]; // Pins of the chain
+		bool  pinStates[NUM_SHIFT_REGISTER_PINS];   // Levels last written
+		int   numLights;            // Number of outputs in the chain
+		bool* latchedStates;        // States shown by the chain
+		bool  hasLatched;           // Whether latchedStates is known
+		unsigned long long numFrames;       // Frames latched
+		unsigned long long numBitsShifted;  // Bits sent down the chain
+		unsigned long long numToggles;      // Pin writes issued
+		bool  isQuiet;              // Whether pins are written without
+		                            // logging
+
+		bool setPin(ShiftRegisterPin pin, bool isOn);
+		int  findShift(const bool* lightStates);
+
+	public:
+		ShiftRegisterOutput();
+		~ShiftRegisterOutput();
+		bool open(const int pinIDs[], int numLights);
+		void close();
+		bool commit(const bool* lightStates);
+		void setQuiet(bool isQuiet);
+		int  getNumLights();
+		unsigned long long getNumFrames();
+		unsigned long long getNumBitsShifted();
+		unsigned long long getNumToggles();
+};
+
+// ----------------- [Shift register class ends here] ------------------ //
+
+
+
+// ------------------ [Light output class begins here] ------------------ //
+
+/*************************************************************************
+	This class writes frames of light states to the GPIO pins. It keeps
+	the states it last wrote and only writes the pins which changed.
+	With the io_uring backend, all the writes of a frame go to the kernel
+	in a single io_uring_enter, using the value files and the "0"/"1"
+	buffer registered with the ring. Where io_uring is not available it
+	falls back to one write per changed pin.
+ *************************************************************************/
+
+// Ways of writing a frame to the pins
+enum OutputBackend {
+	OUTPUT_PLAIN_WRITES,        // One pwrite per changed pin
+	OUTPUT_IO_URING,            // All changed pins in one io_uring_enter
+	OUTPUT_SHIFT_REGISTER       // The changed bits of a frame shifted out
+	                            // through a shift register chain
+};
+
+class LightOutput {
+	private:
+		OutputBackend backend;      // Backend in use
+		bool  isOpen;               // Whether the output has been set up
+		int   ringFileDescriptor;   // io_uring instance, or -1
+		void* submissionRing;       // Mapping of the submission ring
+		size_t submissionRingLength;
+		void* completionRing;       // Mapping of the completion ring
+		size_t completionRingLength;
+		io_uring_sqe* submissions;  // Mapping of the submission entries
+		size_t submissionsLength;
+		atomic<unsigned>* submissionTail;
+		unsigned* submissionMask;
+		unsigned* submissionArray;
+		atomic<unsigned>* completionHead;
+		atomic<unsigned>* completionTail;
+		unsigned* completionMask;
+		io_uring_cqe* completions;
+		bool  usesRegisteredFiles;  // Whether the value files and buffer
+		                            // are registered with the ring
+		char  stateBuffers[2];      // "0" and "1", written from directly
+		bool  committedStates[TOTAL_NUM_LIGHTS]; // States last written
+		bool  chainStates[MAX_SHIFT_REGISTER_LIGHTS]; // Frame of the shift
+		                                              // register chain
+		bool  hasCommitted;         // Whether committedStates is known
+		unsigned long long numCommits;  // Number of frames committed
+		unsigned long long numWrites;   // Number of pin writes issued
+		bool  isQuiet;              // Whether frames are written without
+		                            // logging
+
+		bool setUpRing();
+		void tearDownRing();
+		bool writePlain(const int pins[], int numPins, const bool* states);
+		bool writeRing(const int pins[], int numPins, const bool* states);
+		bool writeShiftRegister(const bool* states);
+
+	public:
+		LightOutput();
+		~LightOutput();
+		bool open(OutputBackend backend);
+		void close();
+		bool commit(const bool* lightStates);
+		bool commitMask(unsigned int lights);
+		void setQuiet(bool isQuiet);
+		void invalidate();
+		OutputBackend getBackend();
+		unsigned long long getNumCommits();
+		unsigned long long getNumWrites();
+};
+
+// ------------------- [Light output class ends here] ------------------- //
+
+
+// ----------------- [Button waiter class begins here] ----------------- //
+
+/*************************************************************************
+	This class puts the process to sleep until the button goes high, a
+	deadline passes or another file becomes readable. On the kernel's
+	GPIO interface it asks for an interrupt on the rising edge and
+	waits for POLLPRI on the value file. Where edges are not available,
+	as in a stand-in directory tree, it waits for inotify to report a
+	write to the pin directory, and failing that checks the button on a
+	short interval.
+ *************************************************************************/
+
+// Ways of finding out that the button changed
+enum ButtonWakeMode {
+	WAKE_ON_EDGE,               // POLLPRI on the value file
+	WAKE_ON_INOTIFY,            // inotify on the pin directory
+	WAKE_ON_INTERVAL            // Checking every BUTTON_RECHECK_INTERVAL
+};
+
+// Reasons for a wait to end
+enum WakeReason {
+	WAKE_DEADLINE,              // The deadline passed
+	WAKE_PRESS,                 // The button is pressed
+	WAKE_COMMAND,               // The other file became readable
+	WAKE_ERROR                  // The button could not be read
+};
+
+class ButtonWaiter {
+	private:
+		GPIOHandler* button;        // Pin of the button
+		ButtonWakeMode mode;        // Way of finding out about changes
+		int fileDescriptor;         // Value file or inotify instance, or
+		                            // -1 when checking on an interval
+
+		void drain();
+
+	public:
+		ButtonWaiter();
+		~ButtonWaiter();
+		bool open(GPIOHandler* button);
+		void close();
+		ButtonWakeMode getMode();
+		WakeReason wait(double deadline, int commandFileDescriptor);
+};
+
+// ------------------ [Button waiter class ends here] ------------------ //
+
+
+// -------------- [Dual button input class begins here] ---------------- //
+
+/*************************************************************************
+	This class listens to the buttons of two players at once. Each
+	button has a thread of its own sleeping in a ButtonWaiter, which
+	stamps a rising edge with the monotonic clock as soon as it wakes.
+	Both buttons share one timestamp domain and neither waits for the
+	other to be read, so presses collected in the same frame can be
+	ordered by when they happened rather than by the order in which the
+	buttons were looked at. The listeners read the buttons with
+	readState, which opens the value file for each read and never logs,
+	so they share no stream with the game reading the first button.
+ *************************************************************************/
+
+// Rising edge of a player's button
+struct ButtonEdge {
+	int    player;              // Index of the player who pressed
+	double time;                // Monotonic time at which it was stamped
+};
+
+class DualButtonInput {
+	private:
+		GPIOHandler* buttons[NUM_PLAYERS];  // Pins of the buttons
+		GPIOHandler* exportedButton;        // Pin exported by this class
+		ButtonWaiter waiters[NUM_PLAYERS];  // Sleep until each is pressed
+		std::thread listeners[NUM_PLAYERS]; // Threads stamping the edges
+		int stopFileDescriptor;     // Becomes readable to stop listening
+		int edgeFileDescriptor;     // Readable while edges are waiting
+		std::mutex edgeLock;        // Guards the waiting edges
+		ButtonEdge waitingEdges[NUM_PLAYERS];   // Latest edge of each
+		bool hasWaitingEdge[NUM_PLAYERS];       // button not collected yet
+		std::atomic<bool> isRunning;
+		std::atomic<unsigned long long> numEdges[NUM_PLAYERS];
+		std::atomic<unsigned long long> numErrors;
+
+		void listen(int player);
+
+	public:
+		DualButtonInput();
+		~DualButtonInput();
+		bool open(GPIOHandler* firstButton, int secondPinID);
+		void close();
+		bool isOpen();
+		GPIOHandler* getButton(int player);
+		int getEdgeFileDescriptor();
+		int collect(ButtonEdge edges[]);
+		void logStatistics();
+};
+
+// --------------- [Dual button input class ends here] ----------------- //
+
+
+// ------------------ [Software PWM class begins here] ----------------- //
+
+/*************************************************************************
+	This class dims the lights by switching them on and off faster than
+	the eye can follow. Each carrier period is split into PWM_SLOTS
+	slots, and a light with a duty of d slots is on for the first d. The
+	schedule of slots is worked out only when a duty changes, as a list
+	of bitmasks with the slot each one starts at, so a period costs one
+	committed frame per distinct bitmask and nothing else. A thread of
+	its own plays the schedule against absolute deadlines, letting lights
+	which were turned off fade out as a trail.
+ *************************************************************************/
+
+// Run of slots in which the same lights are on
+struct PWMRun {
+	unsigned int lights;        // Bitmask of the lights which are on
+	int startSlot;              // Slot at which the run starts
+};
+
+class SoftwarePWM {
+	private:
+		LightOutput* output;        // Output the frames go to
+		int    carrierFrequency;    // Periods per second
+		float  trailDecay;          // Brightness kept each period by lights
+		                            // which were turned off
+		std::thread worker;         // Thread playing the schedule
+		atomic<bool> isRunning;     // Whether the worker should keep going
+		atomic<unsigned int> targetLights; // Bitmask of the lights the game
+		                                   // has turned on
+		float  brightness[TOTAL_NUM_LIGHTS]; // Brightness of each light,
+		                                     // from 0 to 1
+		int    duties[TOTAL_NUM_LIGHTS];     // Slots each light is on for
+		PWMRun schedule[PWM_SLOTS + 1];      // Runs making up a period
+		int    numRuns;             // Number of runs in the schedule
+		atomic<unsigned long long> numPeriods;     // Periods played
+		atomic<unsigned long long> numLatePeriods; // Periods cut short by
+		                                           // falling behind
+		atomic<unsigned long long> numRebuilds;    // Schedules worked out
+		atomic<unsigned long long> numErrors;      // Frames not committed
+
+		void run();
+		void updateDuties();
+		void buildSchedule();
+
+	public:
+		SoftwarePWM();
+		~SoftwarePWM();
+		bool start(LightOutput* output, int carrierFrequency,
+			float trailTime);
+		void stop();
+		bool isStarted();
+		void setLights(const bool* lightStates);
+		int  getCarrierFrequency();
+		unsigned long long getNumPeriods();
+		unsigned long long getNumLatePeriods();
+		unsigned long long getNumRebuilds();
+		unsigned long long getNumErrors();
+};
+
+// ------------------- [Software PWM class ends here] ------------------ //
+
+
+// ---------------- [Segment display class begins here] ---------------- //
+
+/*************************************************************************
+	This class shows the current level and the high score on a
+	multiplexed 7-segment display. The digits share their segment pins
+	and only one digit is lit at a time, so a thread of its own moves to
+	the next digit DISPLAY_REFRESH_RATE times a second against absolute
+	deadlines, fast enough for every digit to look steady. The thread
+	only touches the display's pins, so the strip keeps its own timing,
+	and how late each refresh was is kept to report the jitter.
+ *************************************************************************/
+
+// Segments lit for each character, with segment a in bit 0 through
+// segment g in bit 6
+constexpr unsigned char SEGMENT_PATTERNS[] = {
+	0x3F, 0x06, 0x5B, 0x4F, 0x66,   // 0 to 4
+	0x6D, 0x7D, 0x07, 0x7F, 0x6F    // 5 to 9
+};
+constexpr unsigned char SEGMENT_BLANK = 0x00;   // Nothing lit
+constexpr unsigned char SEGMENT_DASH  = 0x40;   // Segment g only
+
+static_assert(sizeof(SEGMENT_PATTERNS) == 10,
+	"There must be a pattern for every decimal digit");
+static_assert(DISPLAY_NUM_DIGITS <= 4,
+	"The patterns of every digit must fit in a single word");
+
+class SegmentDisplay {
+	private:
+		GPIOHandler* segmentPins[NUM_SEGMENTS];       // Pins of segments a-g
+		GPIOHandler* digitPins[DISPLAY_NUM_DIGITS];   // Pins enabling digits
+		bool   segmentStates[NUM_SEGMENTS];           // Levels last written
+		std::thread worker;         // Thread refreshing the digits
+		atomic<bool> isRunning;     // Whether the worker should keep going
+		atomic<unsigned int> patterns; // Pattern of each digit, the first
+		                               // digit in the lowest byte
+		unsigned long long numRefreshes;    // Digits shown
+		unsigned long long numSkipped;      // Refreshes missed entirely
+		unsigned long long numErrors;       // Pin writes which failed
+		double totalLateness;       // Sum of the lateness of refreshes
+		double maxLateness;         // Latest a refresh has been
+		unsigned long long latenessCounts[DISPLAY_JITTER_BUCKETS + 1];
+		                            // Refreshes by lateness, in buckets of
+		                            // DISPLAY_JITTER_BUCKET_TIME
+
+		void run();
+		void showDigit(int digit, unsigned char pattern);
+
+	public:
+		SegmentDisplay();
+		~SegmentDisplay();
+		bool open(const int segmentPinIDs[], const int digitPinIDs[]);
+		void close();
+		bool isOpen();
+		void showScores(int level, int highScore);
+		void logJitter();
+		double getMeanLateness();
+		double getMaxLateness();
+		double getLatenessPercentile(double fraction);
+		unsigned long long getNumRefreshes();
+		unsigned long long getNumSkipped();
+};
+
+// ----------------- [Segment display class ends here] ----------------- //
+
+
+
 // Global log object
 Logger sysLog;
 
 // Global GPIOHandlers
 GPIOHandler* systemPins[TOTAL_NUM_PINS];
 
+// Global shift register chain, and its number of outputs
+ShiftRegisterOutput shiftRegister;
+int shiftRegisterLength = DEFAULT_SHIFT_REGISTER_LIGHTS;
+
+// Global output for writing frames to the lights
+LightOutput lightOutput;
+OutputBackend lightBackend = OUTPUT_PLAIN_WRITES;
+
+// Global waiter which sleeps until the button is pressed
+ButtonWaiter buttonWaiter;
+
+// Global software PWM, and its carrier frequency or 0 to leave the lights
+// fully on or off
+SoftwarePWM softwarePWM;
+int pwmFrequency = 0;
+
+// Global display of the level and high score, and whether it is used
+SegmentDisplay segmentDisplay;
+bool showsScores = false;
+
+// Global input of both buttons in a head-to-head game, and whether such
+// games are played
+DualButtonInput dualButtons;
+bool playsHeadToHead = false;
+
+// Whether presses are graded by their timing
+bool scoresPrecision = false;
+
+// Whether pins are left set up at exit for a fast restart
+bool warmRestart = false;
+
+// Global timer wheel holding every real-time deadline
+double monotonicTime();
+TimerWheel systemTimers(TIMER_RESOLUTION, monotonicTime());
+
 
 
 // ----------------- [Structure definitions begin here] ---------------- //
 
+// Grades of a press in precision mode, from worst to best
+enum PressGrade {
+	GRADE_MISS,                 // The light was not in the passing position
+	GRADE_OK,                   // Passed, but later than a great press
+	GRADE_GREAT,                // Passed soon after the light arrived
+	GRADE_PERFECT,              // Passed just as the light arrived
+	NUM_PRESS_GRADES
+};
+
+// Points scored and name shown for each grade of press
+const int PRESS_GRADE_POINTS[NUM_PRESS_GRADES] = {0, 1, 2, 3};
+const char* const PRESS_GRADE_NAMES[NUM_PRESS_GRADES] = {
+	"Missed", "OK", "Great", "Perfect"
+};
+
 // Structure for holding data about the game
 struct GameData {
 	float timePerLevel;         // This is the duration in seconds for which a
 	                            // level lasts
 	float timePerLight;         // This is the duration in seconds for which a
 								// light should be on
-	Timer* levelTimer;          // This is the timer for the length of a level
-	Timer* lightTimer;          // This is the timer for the duration a light
-	                            // is on
+	double levelDeadline;       // This is the time at which the current level
+	                            // runs out
+	double lightDeadline;       // This is the time at which the light moves
+	                            // to its next position
 	int currentLevel;           // This counts the number of times the button
 								// was pressed at the right time during the
 								// current game
@@ -174,12 +1088,31 @@ struct GameData {
 	int currentLightPosition;   // This is the index of the current light that
 	                            // is turned on
 	bool* lightStates;          // This holds the states of all the lights
+	int leaderboardRecord;      // This is the leaderboard record of the
+	                            // current session, or -1 if there is none
+	int precisionScore;         // This is the number of points scored for
+	                            // the timing of presses in precision mode
+	unsigned int randomState;   // This is the state of the generator which
+	                            // picks the direction of each level
 	bool isMovingRight;         // Whether or not the light is moving to the
 	                            // right
 };
 
 
 
+// Structure for holding the settings which make the game harder or easier
+struct DifficultyConfig {
+	float timePerLevel;         // This is the duration in seconds for which a
+	                            // level lasts
+	float initialTimePerLight;  // This is the duration in seconds for which a
+	                            // light is on in the first level
+	float scalingTimePerLight;  // This is the multiplier for the duration a
+	                            // light is on after each level
+	int initialNumLives;        // This is the number of lives in a new game
+};
+
+
+
 // Structure for holding statistics about the game
 struct Statistics {
 	int highScore;              // This is the highest level reached
@@ -189,1394 +1122,12147 @@ struct Statistics {
 	                            // has been pressed
 	int totalLivesLost;         // This is the total number of times the button
 	                            // was pressed incorrectly
+	unsigned long long journalSequence;  // This is the last journal record
+	                                     // included in the statistics
+	int precisionHighScore;     // This is the highest score reached in
+	                            // precision mode
 };
 
-// ------------------ [Structure definitions end here] ----------------- //
 
+// Structure for holding what a warm restart resumes from
+struct WarmSnapshot {
+	unsigned int checksum;      // CRC-32 of the rest of the snapshot
+	unsigned int magic;         // Identifies the file as a snapshot
+	unsigned int version;       // Layout of the snapshot
+	int ownerProcess;           // Process which owned the pins
+	char bootID[40];            // Boot during which the pins were exported
+	int pinIDs[TOTAL_NUM_PINS]; // Pins left exported
+	bool pinIsInput[TOTAL_NUM_PINS]; // Directions the pins were left in
+	Statistics stats;           // Statistics at exit
+	float timePerLevel;         // Game data at exit
+	float timePerLight;
+	int currentLevel;
+	int numLivesRemaining;
+	int currentLightPosition;
+	bool isMovingRight;
+};
 
+// ------------------ [Structure definitions end here] ----------------- //
 
-// ---------------- [Function declarations begin here] ----------------- //
 
-// Functions for hardware interfacing
-bool initialize();
-void deinitialize();
-bool updateLightStrip(bool* lightStates);
-int  buttonIsPressed();
 
-// Functions for file input/output
-bool readStats(const char* fileName, Statistics* stats);
-bool writeStats(const char* fileName, Statistics* stats);
-void parseline(char line[], Statistics* stats, int tracker);
+// Global difficulty of new games
+DifficultyConfig gameDifficulty = {TIME_PER_LEVEL, INITIAL_TIME_PER_LIGHT,
+	SCALING_TIME_PER_LIGHT, INITIAL_NUM_LIVES};
 
-// Functions for calculating stats
-bool highScoreFunc(Statistics* stats, GameData* game);
-bool playTime(Statistics* stats);
+// Global statistics of each player in head-to-head games
+Statistics playerStats[NUM_PLAYERS];
 
-// Functions for changing game data
-bool updateLightPosition(GameData* game);
-bool updateLightDuration(GameData* game);
-bool setRandomDirection (GameData* game);
 
-//Functions for handling game logic
-void sleep(float seconds);
-bool gameLoopIdle(Statistics* stats);
-bool gameLoopPlay(Statistics* stats, GameData* game);
+// ------------------- [Animation tables begin here] ------------------- //
 
-// ----------------- [Function declarations end here] ------------------ //
+/*************************************************************************
+	Animations are tables of frames worked out by the compiler. Each
+	frame holds the state of every light and how long it is shown, so
+	playing an animation only hands frames to the light output, and a
+	new effect costs no computation or allocation at run time.
+ *************************************************************************/
 
+// Frame of an animation
+struct AnimationFrame {
+	bool  lights[TOTAL_NUM_LIGHTS]; // State of each light
+	float duration;                 // Time in seconds the frame is shown
+};
 
+// Fixed number of frames built at compile time
+template <int N>
+struct AnimationTable {
+	AnimationFrame frames[N];
 
-// ------------- [Functions for the Timer class begin here] ------------ //
+	// Get the number of frames
+	constexpr int size () const {
+		return N;
+	}
 
-// Set timer for some number of seconds in the future
-bool Timer::setStopTime (float seconds) {
+	// Get the time in seconds the frames take to play
+	constexpr float totalDuration () const {
+		float total = 0;
 
-	// Check for a valid time to add
-	if (seconds >= 0) {
-		sysLog.sysLog <<
-			"[Timer::setStopTime] Setting timer for " <<
-			seconds << " second(s) in the future" << endl;
+		for (int i = 0; i < N; i++) {
+			total += frames[i].duration;
+		}
 
-		stopTime = clock() + seconds * CLOCKS_PER_SEC;
+		return total;
 	}
+};
 
-	return seconds >= 0;
-}
+// Animation as seen by an AnimationPlayer
+struct Animation {
+	const char* name;               // Name for the log
+	const AnimationFrame* frames;   // Frames in the order they are shown
+	int   numFrames;                // Number of frames
+	float totalDuration;            // Time in seconds the frames take
+};
 
-// Determine whether the timer has finished
-bool Timer::isFinished () {
-	// Check for a valid stop time
-	if (stopTime >= 0) {
-		// Return whether the current time has passed the
-		// designated stop time
-		return clock() >= stopTime;
+// Bitmask with every light on
+constexpr unsigned int ALL_LIGHTS = (1u << TOTAL_NUM_LIGHTS) - 1;
 
-	// Handle invalid stop times
-	} else {
-		sysLog.sysLog <<
-			"[Timer::isFinished] ERROR: Negative stopTime" << endl;
+// Build a frame from a bitmask of the lights which are on
+constexpr AnimationFrame makeFrame (unsigned int lights, float duration) {
+	AnimationFrame frame = {};
 
-		return false;
+	for (int i = 0; i < TOTAL_NUM_LIGHTS; i++) {
+		frame.lights[i] = (lights >> i) & 1;
 	}
+
+	frame.duration = duration;
+
+	return frame;
 }
 
-// -------------- [Functions for the Timer class end here] ------------- //
+// Turn some lights on and off numFlashes times
+template <int NUM_FLASHES>
+constexpr AnimationTable<2 * NUM_FLASHES> makeFlash (unsigned int lights,
+		float onTime, float offTime) {
+	AnimationTable<2 * NUM_FLASHES> table = {};
 
+	for (int i = 0; i < NUM_FLASHES; i++) {
+		table.frames[2 * i]     = makeFrame(lights, onTime);
+		table.frames[2 * i + 1] = makeFrame(0, offTime);
+	}
 
+	return table;
+}
 
-// --------- [Functions for the GPIOHandler class begin here] ---------- //
+// Bounce a single light from one end of the strip to the other and back,
+// keeping the lights of keptLights on
+constexpr AnimationTable<2 * (TOTAL_NUM_LIGHTS - 1)> makeSweep (
+		unsigned int keptLights, float frameTime) {
+	AnimationTable<2 * (TOTAL_NUM_LIGHTS - 1)> table = {};
 
-// Helper function for GPIOHandler constructor
-// Get string representation of int
-bool GPIOHandler::stringFromInt (int num, char*& output) {
-	sysLog.sysLog << "[GPIOHandler::stringFromInt] " <<
-		"Entered function" << endl;
+	for (int i = 0; i < table.size(); i++) {
+		int position = (i < TOTAL_NUM_LIGHTS) ? (i) : (table.size() - i);
 
-	// Reject negative numbers
-	if (num < 0) {
-		sysLog.sysLog << "[GPIOHandler::stringFromInt] " <<
-			"ERROR: Received negative number" << endl;
+		table.frames[i] = makeFrame((1u << position) | keptLights, frameTime);
+	}
 
-		return false;
+	return table;
+}
 
-	// Handle the 0 case
-	} else if (num == 0) {
-		output = new char[2];
-		output[0] = '0';
-		output[1] = 0;
-	} else {
-		int length = floor(log10(num) + 1) + 1;
-		output = new char[length];
+// Move every SPACING-th light along the strip, NUM_STEPS frames in all
+template <int SPACING, int NUM_STEPS>
+constexpr AnimationTable<NUM_STEPS> makeChase (float frameTime) {
+	AnimationTable<NUM_STEPS> table = {};
 
-		// Null-terminate the string
-		output[length - 1] = 0;
+	for (int step = 0; step < NUM_STEPS; step++) {
+		unsigned int lights = 0;
 
-		// Add each digit to the string
-		for (int i = 1; i <= length; i++) {
+		for (int i = step % SPACING; i < TOTAL_NUM_LIGHTS; i += SPACING) {
+			lights |= 1u << i;
+		}
+
+		table.frames[step] = makeFrame(lights, frameTime);
+	}
+
+	return table;
+}
+
+// Grow the lit part of the strip outwards from the target light, then
+// turn every light off
+constexpr AnimationTable<TARGET_INDEX + 2> makeExpand (float frameTime) {
+	AnimationTable<TARGET_INDEX + 2> table = {};
+
+	for (int radius = 0; radius <= TARGET_INDEX; radius++) {
+		unsigned int lights = 0;
+
+		for (int i = 0; i < TOTAL_NUM_LIGHTS; i++) {
+			if (i >= TARGET_INDEX - radius && i <= TARGET_INDEX + radius) {
+				lights |= 1u << i;
+			}
+		}
+
+		table.frames[radius] = makeFrame(lights, frameTime);
+	}
+
+	table.frames[TARGET_INDEX + 1] = makeFrame(0, 0);
+
+	return table;
+}
+
+// Play one table and then another
+template <int N, int M>
+constexpr AnimationTable<N + M> joinFrames (const AnimationTable<N>& first,
+		const AnimationTable<M>& second) {
+	AnimationTable<N + M> table = {};
+
+	for (int i = 0; i < N; i++) {
+		table.frames[i] = first.frames[i];
+	}
+
+	for (int i = 0; i < M; i++) {
+		table.frames[N + i] = second.frames[i];
+	}
+
+	return table;
+}
+
+// Frame tables
+constexpr auto FLASH_FRAMES =                   // Every light on, then off
+	makeFlash<1>(ALL_LIGHTS, DEFAULT_PAUSE_TIME, 0);
+constexpr auto LEVEL_UP_FRAMES =                // Lights growing out from
+	makeExpand(DEFAULT_PAUSE_TIME / (TARGET_INDEX + 1)); // the target
+constexpr auto LOSE_FRAMES =                    // Target light blinking
+	makeFlash<2>(1u << TARGET_INDEX, DEFAULT_PAUSE_TIME / 4,
+		DEFAULT_PAUSE_TIME / 4);
+constexpr auto WIN_FRAMES =                     // Every light flashing, then
+	joinFrames(makeFlash<3>(ALL_LIGHTS, 0.15, 0.1), // a chase
+		makeChase<3, 12>(0.06));
+constexpr auto SWEEP_FRAMES =                   // Light bouncing around the
+	makeSweep(1u << TARGET_INDEX, 0.08);        // lit target
+constexpr auto CHASE_FRAMES =                   // Every third light moving
+	makeChase<3, 15>(0.1);                      // along the strip
+constexpr auto ATTRACT_FRAMES =                 // Sweeps and chases while
+	joinFrames(joinFrames(SWEEP_FRAMES, SWEEP_FRAMES), CHASE_FRAMES); // idle
+
+// Animations which stand in for a pause must take exactly as long, since
+// the batch simulator assumes they do
+static_assert(LEVEL_UP_FRAMES.totalDuration() == DEFAULT_PAUSE_TIME,
+	"The level-up animation must last DEFAULT_PAUSE_TIME");
+static_assert(LOSE_FRAMES.totalDuration() == DEFAULT_PAUSE_TIME,
+	"The lose animation must last DEFAULT_PAUSE_TIME");
+
+// Animations
+constexpr Animation FLASH_ANIMATION = {"flash", FLASH_FRAMES.frames,
+	FLASH_FRAMES.size(), FLASH_FRAMES.totalDuration()};
+constexpr Animation LEVEL_UP_ANIMATION = {"level up", LEVEL_UP_FRAMES.frames,
+	LEVEL_UP_FRAMES.size(), LEVEL_UP_FRAMES.totalDuration()};
+constexpr Animation LOSE_ANIMATION = {"lose", LOSE_FRAMES.frames,
+	LOSE_FRAMES.size(), LOSE_FRAMES.totalDuration()};
+constexpr Animation WIN_ANIMATION = {"win", WIN_FRAMES.frames,
+	WIN_FRAMES.size(), WIN_FRAMES.totalDuration()};
+constexpr Animation ATTRACT_ANIMATION = {"attract", ATTRACT_FRAMES.frames,
+	ATTRACT_FRAMES.size(), ATTRACT_FRAMES.totalDuration()};
+
+// -------------------- [Animation tables end here] -------------------- //
+
+
+
+// ---------------- [Animation player class begins here] --------------- //
+
+/*************************************************************************
+	This class plays an animation against absolute deadlines. Each frame
+	is due a fixed time after the animation started, so slow callers
+	skip late frames instead of stretching the animation.
+ *************************************************************************/
+
+class AnimationPlayer {
+	private:
+		const Animation* animation; // Animation being played, or NULL
+		bool   isLooping;           // Whether to start over at the end
+		bool   showsFrames;         // Whether frames go to the lights
+		int    nextFrame;           // Index of the next frame to show
+		double nextFrameTime;       // Time at which the next frame is due
+		int    numFramesShown;      // Frames shown since starting
+		int    numFramesSkipped;    // Frames skipped for being late
+
+	public:
+		AnimationPlayer();
+		void   start(const Animation* animation, double startTime,
+			bool isLooping, bool showsFrames);
+		int    step(double currentTime);
+		double getDeadline();
+		int    getNumFramesShown();
+		int    getNumFramesSkipped();
+};
+
+// ----------------- [Animation player class ends here] ---------------- //
+
+
+
+// ----------------- [Stats journal class begins here] ----------------- //
+
+/*************************************************************************
+	This class makes the statistics survive crashes. Each change is
+	appended to a journal as a checksummed record when it happens, and
+	the journal is compacted into the statistics file once it grows, so
+	startup only reads the statistics file and a short journal tail.
+ *************************************************************************/
+
+// Kinds of changes recorded in the journal
+enum JournalRecordType {
+	JOURNAL_PRESS = 1,          // The button was pressed
+	JOURNAL_LIFE_LOST,          // A life was lost
+	JOURNAL_HIGH_SCORE,         // A new high score was reached
+	JOURNAL_PLAY_TIME,          // A game lasted some number of seconds
+	JOURNAL_PRECISION_HIGH_SCORE // A new precision high score was reached
+};
+
+// Record stored in the journal file
+struct JournalRecord {
+	unsigned int       checksum;    // CRC-32 of the rest of the record
+	unsigned int       type;        // Kind of change
+	unsigned long long sequence;    // Number of the record
+	float              value;       // New high score or seconds played
+	unsigned int       padding;
+};
+
+class StatsJournal {
+	private:
+		int fileDescriptor;             // Journal file opened for appending
+		unsigned long long nextSequence;// Number of the next record
+		int numRecords;                 // Number of records in the file
+		bool needsSync;                 // Whether records have been written
+		                                // since the last sync
+
+		static unsigned int checksum(const JournalRecord& record);
+		bool append(JournalRecordType type, float value);
+		bool replay(Statistics* stats);
+
+	public:
+		StatsJournal();
+		~StatsJournal();
+		bool open(Statistics* stats, bool hasStats);
+		void close();
+		bool recordPress();
+		bool recordLifeLost();
+		bool recordHighScore(int highScore);
+		bool recordPlayTime(float seconds);
+		bool recordPrecisionHighScore(int highScore);
+		bool sync();
+		bool needsCompaction();
+		bool compact(Statistics* stats);
+};
+
+// ------------------ [Stats journal class ends here] ------------------ //
+
+
+
+// Global statistics journal
+StatsJournal statsJournal;
+
+
+
+// ------------------ [Leaderboard class begins here] ------------------ //
+
+/*************************************************************************
+	This class keeps the score of every play session in a file of
+	fixed-size records which is memory-mapped rather than read. The
+	records are linked into a skip list ordered by score, so a score can
+	be inserted or changed in O(log n) and the top K scores are read by
+	following K links from the front. Only the header is checked when the
+	file is opened. Links are checked as they are followed, and a bad
+	one, as left by a crash in the middle of an insert, makes the index
+	be rebuilt from the records.
+ *************************************************************************/
+
+// Header at the start of the leaderboard file
+struct LeaderboardHeader {
+	unsigned int magic;         // Identifies the file as a leaderboard
+	unsigned int version;       // Layout of the file
+	int numRecords;             // Number of records in use
+	int capacity;               // Number of records the file has room for
+	int numLevels;              // Number of skip list levels in use
+	int head[LEADERBOARD_LEVELS];  // First record in each level, or -1
+};
+
+// Record of a single play session
+struct LeaderboardRecord {
+	char playerName[MAX_PLAYER_NAME_LENGTH];  // Null-terminated name
+	int score;                  // Highest level reached in the session
+	int numLevels;              // Number of skip list levels the record
+	                            // is linked into
+	long long startTime;        // Time the session started (Unix time)
+	int next[LEADERBOARD_LEVELS];  // Next record in each level, or -1
+};
+
+class Leaderboard {
+	private:
+		int    fileDescriptor;      // Leaderboard file
+		bool   isReadOnly;          // Whether the file is only read
+		size_t mappedLength;        // Length of the mapping in bytes
+		LeaderboardHeader* header;  // Start of the mapping
+		LeaderboardRecord* records; // Records following the header
+		std::mt19937 generator;     // Picks the levels of new records
+
+		bool   map(size_t length);
+		bool   hasValidHeader(off_t fileSize);
+		bool   grow();
+		bool   ranksBefore(int first, int second);
+		bool   isValidLink(int from, int next, int level);
+		bool   findPredecessors(int index, int predecessors[]);
+		bool   link(int index);
+		bool   unlink(int index);
+		void   rebuild();
+		int    scanTopScores(int numScores, LeaderboardRecord* output);
+
+	public:
+		Leaderboard();
+		~Leaderboard();
+		bool open(const char* fileName);
+		bool openReadOnly(const char* fileName);
+		void close();
+		bool isOpen();
+		int  addSession(const char* playerName, long long startTime);
+		bool updateScore(int index, int score);
+		int  getScore(int index);
+		int  getTopScores(int numScores, LeaderboardRecord* output);
+		void sync();
+		int  getNumRecords();
+};
+
+// ------------------- [Leaderboard class ends here] ------------------- //
+
+
+
+// Global leaderboard
+Leaderboard leaderboard;
+
+// Name of the player recorded in the leaderboard
+const char* playerName = DEFAULT_PLAYER_NAME;
+
+
+
+// ---------------- [Quantile sketch classes begin here] ---------------- //
+
+/*************************************************************************
+	These classes summarize how early or late presses are without
+	keeping every press. Each sketch is a stack of compactors: once a
+	compactor fills up, it is sorted and every other value is promoted
+	to the compactor above, where it stands for twice as many presses.
+	A sketch of n presses holds at most SKETCH_CAPACITY values for each
+	of about log2(n / SKETCH_CAPACITY) compactors, and two sketches are
+	merged by merging their compactors.
+ *************************************************************************/
+
+class QuantileSketch {
+	private:
+		vector< vector<float> > compactors; // Values kept at each height,
+		                                    // each standing for 2^height
+		                                    // presses
+		unsigned long long count;           // Number of values added
+		unsigned int randomState;           // Picks which half to promote
+
+		void compact(int height);
+
+	public:
+		QuantileSketch();
+		void add(float value);
+		void merge(const QuantileSketch& other);
+		float quantile(double fraction) const;
+		unsigned long long getCount() const;
+		bool write(ostream& output, int level, int direction) const;
+		bool readCompactor(istream& input, int height, int numValues);
+};
+
+class ReactionSketches {
+	private:
+		QuantileSketch sketches[MAX_SKETCH_LEVELS][2]; // By level and
+		                                               // direction
+
+	public:
+		void recordPress(int level, bool isMovingRight, float error);
+		void merge(const ReactionSketches& other);
+		bool read(const char* fileName);
+		bool write(const char* fileName);
+		void report(ostream& output);
+};
+
+// ----------------- [Quantile sketch classes end here] ----------------- //
+
+
+
+// Global press timing sketches
+ReactionSketches reactionSketches;
+
+
+
+// --------------- [Session history class begins here] ---------------- //
+
+/*************************************************************************
+	This class keeps a record of every session in a columnar file. The
+	file is a sequence of fixed-size blocks, each holding up to
+	HISTORY_BLOCK_ROWS sessions with the values of each column stored
+	together. Every block starts with the minimum and maximum of each of
+	its columns, so a query reads only the columns it needs and skips
+	blocks whose ranges cannot match.
+ *************************************************************************/
+
+// Columns of the session history
+enum HistoryColumn {
+	HISTORY_START_TIME,         // Time the session started (Unix time)
+	HISTORY_DURATION,           // Length of the session in seconds
+	HISTORY_LEVEL,              // Level reached
+	HISTORY_PRESSES,            // Number of button presses
+	HISTORY_LIVES_LOST,         // Number of lives lost
+	HISTORY_TIME_PER_LIGHT,     // Time per light on each level in
+	                            // seconds, or NAN if it was not reached
+	NUM_HISTORY_COLUMNS = HISTORY_TIME_PER_LIGHT + MAX_HISTORY_LEVELS
+};
+
+// Structure for holding the record of a single session
+struct SessionRecord {
+	double startTime;           // Time the session started (Unix time)
+	float duration;             // Length of the session in seconds
+	int level;                  // Level reached
+	int presses;                // Number of button presses
+	int livesLost;              // Number of lives lost
+	float timePerLight[MAX_HISTORY_LEVELS]; // Time per light on each level
+};
+
+// Header at the start of each block of the session history
+struct HistoryBlockHeader {
+	unsigned int magic;         // Identifies the start of a block
+	unsigned int numRows;       // Number of sessions in the block
+	double minimum[NUM_HISTORY_COLUMNS]; // Smallest value in each column
+	double maximum[NUM_HISTORY_COLUMNS]; // Largest value in each column
+};
+
+class SessionHistory {
+	private:
+		int fileDescriptor;         // History file
+		int numBlocks;              // Number of blocks in the file
+		HistoryBlockHeader tail;    // Header of the last block
+
+		off_t blockOffset(int block);
+		off_t valueOffset(int block, int column, int row);
+		bool  startBlock();
+
+	public:
+		SessionHistory();
+		~SessionHistory();
+		bool open(const char* fileName, bool isWritable);
+		void close();
+		bool append(const SessionRecord& record);
+		int  getNumBlocks();
+		bool readHeader(int block, HistoryBlockHeader* header);
+		bool readColumn(int block, int column, int numRows, double* values);
+};
+
+// ---------------- [Session history class ends here] ----------------- //
+
+
+
+// Global session history
+SessionHistory sessionHistory;
+
+
+
+// ----------------- [Shared state class begins here] ------------------ //
+
+/*************************************************************************
+	This class mirrors the state of the game and the statistics into a
+	POSIX shared memory segment, so that displays running as separate
+	processes can follow the game without reading the log. The segment
+	is guarded by a sequence lock: the game makes the sequence odd while
+	it writes and even once it is done, and a reader retries any copy
+	during which the sequence was odd or changed. Neither side takes a
+	lock or makes a system call.
+ *************************************************************************/
+
+// Entry of the leaderboard in the shared segment
+struct SharedScore {
+	atomic<char> playerName[MAX_PLAYER_NAME_LENGTH];
+	atomic<int> score;
+};
+
+// Layout of the shared segment
+struct SharedGameState {
+	atomic<unsigned int> magic;     // Marks a segment which is set up
+	atomic<unsigned int> sequence;  // Odd while the game is writing
+	atomic<int> isPlaying;
+	atomic<int> currentLevel;
+	atomic<int> numLivesRemaining;
+	atomic<int> currentLightPosition;
+	atomic<int> isMovingRight;
+	atomic<int> highScore;
+	atomic<int> timesPressed;
+	atomic<int> totalLivesLost;
+	atomic<float> totalTimePlayed;
+	atomic<int> numTopScores;
+	SharedScore topScores[SHARED_TOP_SCORES];
+};
+
+// Consistent copy of the shared segment taken by a reader
+struct SharedGameSnapshot {
+	unsigned int sequence;
+	bool isPlaying;
+	int currentLevel;
+	int numLivesRemaining;
+	int currentLightPosition;
+	bool isMovingRight;
+	int highScore;
+	int timesPressed;
+	int totalLivesLost;
+	float totalTimePlayed;
+	int numTopScores;
+	char topPlayerNames[SHARED_TOP_SCORES][MAX_PLAYER_NAME_LENGTH];
+	int topScores[SHARED_TOP_SCORES];
+};
+
+class SharedState {
+	private:
+		SharedGameState* state;     // Mapping of the shared segment
+		bool isWriter;              // Whether this process owns the segment
+
+		void beginWrite();
+		void endWrite();
+
+	public:
+		SharedState();
+		~SharedState();
+		bool create(const char* name);
+		bool attach(const char* name);
+		void close();
+		void publish(Statistics* stats, GameData* game, bool isPlaying);
+		void publishLeaderboard(Leaderboard* board);
+		bool snapshot(SharedGameSnapshot* output);
+};
+
+// Structure shared by the shared state benchmark and the thread checking
+// the snapshots it takes
+struct SnapshotCheck {
+	SharedState reader;         // Reader attached to the benchmark segment
+	std::atomic<bool> isRunning;    // Whether the writer is still publishing
+	long long numSnapshots;     // Snapshots taken
+	long long numChanged;       // Snapshots of a publish not seen before
+	long long numTorn;          // Snapshots mixing two publishes
+};
+
+// ------------------ [Shared state class ends here] ------------------- //
+
+
+
+// Global shared state
+SharedState sharedState;
+
+
+
+// ------------------ [Event stream classes begin here] ----------------- //
+
+/*************************************************************************
+	These classes broadcast game events to any number of subscribers
+	through a ring buffer in POSIX shared memory. The game is the only
+	writer and never waits for subscribers: each event overwrites the
+	oldest slot, and each slot carries a sequence number which is odd
+	while the slot is being written. A subscriber keeps its own cursor
+	and counts the events it fell behind by and the events it lost
+	because the game lapped it.
+ *************************************************************************/
+
+// Types of event in the stream
+enum StreamEventType {
+	STREAM_GAME_STARTED,        // A game started
+	STREAM_LIGHT_STEP,          // The light moved (value: position)
+	STREAM_PRESS,               // The button was pressed (value: position)
+	STREAM_LEVEL_PASSED,        // A level was passed (value: new level)
+	STREAM_LIFE_LOST,           // A life was lost (value: lives remaining)
+	STREAM_HIGH_SCORE,          // The high score rose (value: high score)
+	STREAM_GAME_ENDED,          // A game ended (value: level reached)
+	NUM_STREAM_EVENT_TYPES
+};
+
+// Event as seen by a subscriber
+struct StreamEvent {
+	unsigned long long sequence;  // Position of the event in the stream
+	StreamEventType type;         // What happened
+	int value;                    // Detail depending on the type
+	double time;                  // Monotonic time of the event
+};
+
+// Slot of the ring buffer
+struct EventSlot {
+	atomic<unsigned long long> sequence;  // 2 * (event + 1), minus one
+	                                      // while the event is written
+	atomic<unsigned long long> detail;    // Type and value of the event
+	atomic<double> time;                  // Monotonic time of the event
+};
+
+// Layout of the shared segment
+struct EventRingState {
+	atomic<unsigned int> magic;           // Marks a segment which is set up
+	atomic<unsigned long long> head;      // Number of events published
+	EventSlot slots[EVENT_RING_CAPACITY];
+};
+
+class EventRing {
+	private:
+		EventRingState* ring;       // Mapping of the shared segment
+		bool isWriter;              // Whether this process publishes
+
+	public:
+		EventRing();
+		~EventRing();
+		bool create(const char* name);
+		bool attach(const char* name);
+		void close();
+		void publish(StreamEventType type, int value, double time);
+		unsigned long long getHead();
+		int  read(unsigned long long sequence, StreamEvent* output);
+};
+
+class EventSubscriber {
+	private:
+		EventRing* ring;            // Ring the subscriber follows
+		unsigned long long cursor;  // Next event to read
+		unsigned long long maxLag;  // Most events ever waiting
+		unsigned long long numOverrun; // Events lost to being lapped
+
+	public:
+		EventSubscriber(EventRing* ring, bool startsAtOldest);
+		bool poll(StreamEvent* output);
+		unsigned long long getLag();
+		unsigned long long getMaxLag();
+		unsigned long long getNumOverrun();
+};
+
+// Structure shared by the event stream benchmark and each thread
+// subscribing to the benchmark segment
+struct EventCheck {
+	EventSubscriber* subscriber;    // Subscriber which started before the
+	                                // first event
+	long long numEvents;        // Number of events the benchmark publishes
+	bool isSlow;                // Whether the subscriber pauses while
+	                            // reading, so it gets lapped
+	long long numRead;          // Events read
+	long long numOverrun;       // Events lost to being lapped
+	long long numTorn;          // Events read with the wrong contents or
+	                            // out of order
+	unsigned long long maxLag;  // Most events ever waiting
+};
+
+// ------------------- [Event stream classes end here] ------------------ //
+
+
+
+// Global game event stream
+EventRing gameEvents;
+
+
+// ----------------- [Control server class begins here] ----------------- //
+
+/*************************************************************************
+	This class lets local tools control a long-running game through a
+	Unix domain socket. A thread of its own accepts connections and
+	answers one command per line, so a slow client never holds up the
+	game. Commands only set flags and a pending difficulty, which the
+	game thread picks up between frames or between games.
+ *************************************************************************/
+
+class ControlServer {
+	private:
+		int listenSocket;           // Socket accepting connections
+		string socketPath;          // Name of the socket in the file system
+		int wakeFileDescriptor;     // Event counter which wakes the game
+		                            // thread when a command arrives
+		int stopFileDescriptor;     // Event counter which stops the
+		                            // server thread
+		std::thread server;         // Thread answering clients
+		atomic<bool> isStartRequested;
+		atomic<bool> isStopRequested;
+		atomic<bool> isShutdownRequested;
+		std::mutex difficultyLock;  // Guards the pending difficulty
+		DifficultyConfig pendingDifficulty;
+		bool hasPendingDifficulty;
+		SharedState* state;         // State reported by the stats command
+
+		void   serve();
+		void   serveClient(int client);
+		string handleCommand(const char* command);
+		void   wake();
+
+	public:
+		ControlServer();
+		~ControlServer();
+		bool open(const char* path, SharedState* state);
+		void close();
+		int  getWakeFileDescriptor();
+		void clearWake();
+		bool takeStartRequest();
+		bool stopRequested();
+		void clearStopRequest();
+		bool shutdownRequested();
+		bool takeDifficulty(DifficultyConfig* output);
+};
+
+// ------------------ [Control server class ends here] ------------------ //
+
+
+
+// Global control socket of a daemon
+ControlServer controlServer;
+
+
+
+// ---------------- [Game scheduler classes begin here] ---------------- //
+
+/*************************************************************************
+	These classes allow games to run as coroutines. A game suspends
+	itself until a deadline passes or the button is pressed, and the
+	scheduler resumes it when that happens, so any number of games can
+	share a single thread.
+ *************************************************************************/
+
+// Events which can resume a suspended game
+enum GameEvent {
+	EVENT_DEADLINE,             // The requested deadline has passed
+	EVENT_PRESS,                // The button was pressed
+	EVENT_INPUT_ERROR           // The button state could not be read
+};
+
+// Coroutine for a single game
+class GameTask {
+	public:
+		struct promise_type {
+			bool result;        // Whether the game ended without error
+
+			GameTask get_return_object () {
+				return GameTask(
+					std::coroutine_handle<promise_type>::from_promise(*this));
+			}
+
+			// Games only run once the scheduler resumes them, and are
+			// kept around after finishing so the result can be read
+			std::suspend_always initial_suspend () noexcept { return {}; }
+			std::suspend_always final_suspend () noexcept { return {}; }
+
+			void return_value (bool value) { result = value; }
+			void unhandled_exception () { result = false; }
+		};
+
+		// Constructors
+		GameTask (std::coroutine_handle<promise_type> handle) {
+			this->handle = handle;
+		}
+
+		GameTask (GameTask&& other) {
+			handle = other.handle;
+			other.handle = NULL;
+		}
+
+		// Deconstructor
+		~GameTask () {
+			if (handle) {
+				handle.destroy();
+			}
+		}
+
+		// Hand the coroutine over to its new owner
+		std::coroutine_handle<promise_type> release () {
+			std::coroutine_handle<promise_type> released = handle;
+			handle = NULL;
+
+			return released;
+		}
+
+	private:
+		std::coroutine_handle<promise_type> handle;
+};
+
+class GameScheduler {
+	private:
+		// State kept for each game
+		struct GameSlot {
+			std::coroutine_handle<GameTask::promise_type> handle;
+			TimerId   deadlineTimer; // Timer which resumes the game
+			bool      wantsPress;    // Whether a press resumes the game
+			bool      isWaiting;     // Whether the game is suspended
+			GameEvent event;         // Event which last resumed the game
+			double    pressTime;     // Time at which the last press was
+			                         // stamped
+		};
+
+		bool   usesVirtualTime;     // Whether time jumps between events
+		double virtualTime;         // Current time when using virtual time
+		int    hardwareSlot;        // Game whose presses come from the
+		                            // button, or -1 if there is none
+		int    numRunning;          // Number of games which have not ended
+		int    numFailed;           // Number of games which ended in error
+
+		TimerWheel  virtualTimers;  // Deadlines when using virtual time
+		TimerWheel* timers;         // Wheel holding the games' deadlines
+
+		vector<GameSlot> slots;
+
+		void resume(int slot, GameEvent event);
+		static void onDeadline(void* context, int slot);
+		static void onPress(void* context, int slot);
+
+	public:
+		GameScheduler(bool usesVirtualTime);
+		~GameScheduler();
+		double      now();
+		int         spawn(GameTask task);
+		void        setHardwareSlot(int slot);
+		void        suspend(int slot, double deadline, bool wantsPress);
+		GameEvent   lastEvent(int slot);
+		double      lastPressTime(int slot);
+		bool        schedulePress(int slot, double time);
+		bool        run();
+		int         getNumFailed();
+		TimerWheel* getTimers();
+};
+
+// Awaitable which suspends a game until a deadline or a press
+struct GameAwaiter {
+	GameScheduler* scheduler;
+	int    slot;
+	double deadline;
+	bool   wantsPress;
+
+	bool await_ready () { return false; }
+
+	void await_suspend (std::coroutine_handle<>) {
+		scheduler->suspend(slot, deadline, wantsPress);
+	}
+
+	GameEvent await_resume () { return scheduler->lastEvent(slot); }
+};
+
+class SimulatedPlayer;
+class InputRecorder;
+class InputReplayer;
+
+// Structure for holding everything a game coroutine needs
+struct GameContext {
+	GameScheduler* scheduler;   // Scheduler which resumes the game
+	int slot;                   // Slot of the game in the scheduler
+	Statistics* stats;          // Statistics updated by the game
+	GameData* game;             // State of the game
+	bool usesHardware;          // Whether the game drives the GPIO pins
+	SimulatedPlayer* player;    // Synthetic player for simulated games, or
+	                            // NULL if presses come from the button
+	StatsJournal* journal;      // Journal recording changes to the
+	                            // statistics, or NULL if there is none
+	ReactionSketches* sketches; // Sketches of press timing, or NULL if
+	                            // press timing is not recorded
+	SessionHistory* history;    // History which gets a record of the
+	                            // game, or NULL if there is none
+	SharedState* sharedState;   // Shared memory mirroring the game, or
+	                            // NULL if there is none
+	EventRing* events;          // Stream which gets the events of the
+	                            // game, or NULL if there is none
+	ControlServer* control;     // Control socket which can stop the game,
+	                            // or NULL if there is none
+	SegmentDisplay* display;    // Display of the level and high score, or
+	                            // NULL if there is none
+	InputRecorder* recorder;    // Recording which gets the presses of the
+	                            // game, or NULL if there is none
+	InputReplayer* replayer;    // Recording the presses come from, or NULL
+	                            // if they are not played back
+};
+
+/*************************************************************************
+	This class presses the button for simulated games. The player aims
+	for the middle of the window in which a press passes the level, and
+	misses by a normally distributed reaction error. The batch simulator
+	keeps one for each of its lanes, so both simulators draw presses
+	from the same model.
+ *************************************************************************/
+
+class SimulatedPlayer {
+	private:
+		std::mt19937 generator;
+		std::normal_distribution<double> reactionError;
+
+	public:
+		SimulatedPlayer(unsigned seed, double errorStdDev);
+		void   seed(unsigned seed);
+		double pressDelay(int stepsToPass, double timePerLight);
+		bool   planPress(GameContext* context, double levelStartTime);
+};
+
+// Structure shared by the thread pressing the button of a stand-in tree
+// and the game reacting to it, in the input-to-light benchmark
+struct LatencyTrials {
+	const char* buttonFileName; // Value file of the stand-in button
+	int notifier;               // Inotify watching the lights' value files
+	int numTrials;              // Number of presses to make
+	std::atomic<int> numReleases;   // Number of releases the game has seen
+	vector<double> pressTimes;  // Time each press was written
+	vector<double> reactTimes;  // Time the game woke up for each press
+	vector<double> lightTimes;  // Time a light first changed after each
+	                            // press
+	int numErrors;              // Reads and frames which failed and were
+	                            // tried again
+	bool isFinished;            // Whether every trial was made
+};
+
+// ----------------- [Game scheduler classes end here] ----------------- //
+
+
+
+// --------------- [Input recording classes begin here] ---------------- //
+
+/*************************************************************************
+	These classes record the input of games and play it back. A
+	recording holds the seed of each game's direction generator, the
+	difficulty it was played at and every press, all as LEB128
+	varints. A press is stored as the number of levels since the last
+	one, the light step it came in and the microseconds after that step,
+	so playing it back on a virtual clock puts it in the same position
+	however late the real light steps were. Each press also keeps the
+	position it was judged at, and each game its outcome, so a replay
+	can tell where it stops matching.
+ *************************************************************************/
+
+// Kinds of entries in a recording
+enum RecordingTag {
+	RECORDING_GAME = 1,         // A game started
+	RECORDING_PRESS,            // The button was pressed
+	RECORDING_STOP,             // The game was stopped
+	RECORDING_GAME_END          // The game ended
+};
+
+// Press or stop of a recorded game
+struct RecordedEvent {
+	RecordingTag type;          // Kind of event
+	int round;                  // Number of levels played before it
+	int step;                   // Light step it came in
+	int offset;                 // Microseconds after the step, which is
+	                            // negative for a press stamped before it
+	int position;               // Position the light was judged at
+};
+
+// Settings and outcome of a recorded game
+struct RecordedGame {
+	unsigned int seed;          // Seed of the direction generator
+	long long startTime;        // Wall clock time the game started
+	DifficultyConfig difficulty;// Difficulty the game was played at
+	bool scoresPrecision;       // Whether presses were graded
+	int level;                  // Level reached
+	int presses;                // Number of presses
+	int livesLost;              // Number of lives lost
+	vector<RecordedEvent> events;
+};
+
+class InputRecorder {
+	private:
+		int fileDescriptor;         // Recording opened for appending
+		vector<unsigned char> buffer;   // Entries of the current game
+		int lastRound;              // Round of the last event recorded
+
+		void putVarint(unsigned long long value);
+		void recordEvent(RecordingTag type, int round, int step,
+			double offset, int position);
+
+	public:
+		InputRecorder();
+		~InputRecorder();
+		bool open(const char* fileName);
+		void close();
+		bool isOpen();
+		void startGame(unsigned int seed, long long startTime);
+		void recordPress(int round, int step, double offset, int position);
+		void recordStop(int round, int step, double offset);
+		bool endGame(int level, int presses, int livesLost);
+};
+
+class InputReplayer {
+	private:
+		vector<unsigned char> contents; // Whole recording
+		size_t readOffset;          // Offset of the next entry
+		RecordedGame current;       // Game being played back
+		size_t nextEvent;           // Index of the next event to play
+		size_t nextCheck;           // Index of the next press to check
+		bool isStopped;             // Whether a stop has been played
+		int numMismatches;          // Presses judged at other positions
+		bool hasSameOutcome;        // Whether the game ended as recorded
+
+		bool getVarint(unsigned long long& value);
+
+	public:
+		InputReplayer();
+		bool open(const char* fileName);
+		bool readGame(RecordedGame* game);
+		void startGame(const RecordedGame& game);
+		void onLightStep(GameContext* context, int round, int step);
+		double checkPress(int position);
+		void endGame(int level, int presses, int livesLost);
+		bool stopRequested();
+		bool matches();
+		int getNumMismatches();
+		size_t getSize();
+};
+
+// ---------------- [Input recording classes end here] ----------------- //
+
+
+
+// Global recording of the input of each game
+InputRecorder inputRecorder;
+
+
+
+// ---------------- [Batch simulator class begins here] ---------------- //
+
+/*************************************************************************
+	This class simulates a large number of games at once for tuning the
+	difficulty. The games are stored as structure-of-arrays in blocks of
+	SIMULATION_LANES games, and each level of every game in a block is
+	played by a single vectorized kernel which follows the same rules as
+	playGame. Presses come from a SimulatedPlayer in each lane, and times
+	are kept in double with light durations rounded to float, as the
+	scheduled games keep them.
+ *************************************************************************/
+
+// Vectors holding one value for each game in a block
+typedef float FloatLanes
+	__attribute__((vector_size(SIMULATION_LANES * sizeof(float))));
+typedef double DoubleLanes
+	__attribute__((vector_size(SIMULATION_LANES * sizeof(double))));
+typedef long long LongLanes
+	__attribute__((vector_size(SIMULATION_LANES * sizeof(long long))));
+typedef int IntLanes
+	__attribute__((vector_size(SIMULATION_LANES * sizeof(int))));
+typedef unsigned UintLanes
+	__attribute__((vector_size(SIMULATION_LANES * sizeof(unsigned))));
+
+class BatchSimulator {
+	private:
+		DifficultyConfig config;    // Difficulty the games are played at
+		int   numGames;             // Number of games being simulated
+		int   numBlocks;            // Number of blocks holding the games
+		vector<SimulatedPlayer> players;    // Player of each lane of the
+		                                    // block being played
+
+		// State of the games, with one entry per block
+		vector<UintLanes>   randomState;
+		vector<UintLanes>   playerSeed;
+		vector<IntLanes>    currentLevel;
+		vector<IntLanes>    numLivesRemaining;
+		vector<IntLanes>    currentLightPosition;
+		vector<IntLanes>    isMovingRight;
+		vector<DoubleLanes> timePerLight;
+		vector<DoubleLanes> sessionTime;
+		vector<IntLanes>    timesPressed;
+		vector<IntLanes>    livesLost;
+
+		UintLanes  nextRandom(int block);
+		bool       playLevel(int block);
+
+	public:
+		BatchSimulator(DifficultyConfig config, double errorStdDev,
+			int numGames, unsigned seed);
+		void   run();
+		int    getNumGames();
+		int    getLevelReached(int game);
+		double getSessionTime(int game);
+		int    getTimesPressed(int game);
+		int    getLivesLost(int game);
+};
+
+// ----------------- [Batch simulator class ends here] ----------------- //
+
+
+
+// -------------- [Work-stealing pool class begins here] --------------- //
+
+/*************************************************************************
+	This class runs a numbered set of tasks on every core. Each worker
+	takes tasks from the back of its own queue, and once that is empty
+	steals from the front of the other workers' queues.
+ *************************************************************************/
+
+// Function run for each task, given the task's number
+typedef void (*PoolTask)(void* context, int task);
+
+class WorkStealingPool {
+	private:
+		// Queue of tasks belonging to one worker
+		struct WorkerQueue {
+			std::mutex lock;
+			deque<int> tasks;
+		};
+
+		int          numWorkers;    // Number of threads running tasks
+		WorkerQueue* queues;        // One queue for each worker
+		PoolTask     function;      // Function run for each task
+		void*        context;       // Argument passed to the function
+		std::atomic<int> numStolen; // Number of tasks run by a worker
+		                            // which did not own them
+
+		bool takeTask(int worker, int& task);
+		static void work(WorkStealingPool* pool, int worker);
+
+	public:
+		WorkStealingPool(int numWorkers);
+		~WorkStealingPool();
+		void run(int numTasks, PoolTask function, void* context);
+		int  getNumWorkers();
+		int  getNumStolen();
+};
+
+// --------------- [Work-stealing pool class ends here] ---------------- //
+
+
+
+// ---------------- [Function declarations begin here] ----------------- //
+
+// Functions for hardware interfacing
+bool initialize(Statistics* stats, GameData* game, bool isWarmStart);
+void deinitialize(bool keepsPinsExported);
+bool updateLightStrip(const bool* lightStates);
+bool updateMirroredLightStrip(GameData* game);
+int  buttonIsPressed();
+bool retryInput(const char* prefix, double* outageStartTime, double time);
+void endInputOutage(const char* prefix, double* outageStartTime,
+	double time);
+GPIOHandler* exportPin(int pinID, bool isInput);
+
+// Functions for file input/output
+bool readStats(Statistics* stats);
+bool writeStats(Statistics* stats);
+unsigned int computeChecksum(const void* data, size_t length);
+bool readSnapshot(Statistics* stats, GameData* game);
+bool writeSnapshot(Statistics* stats, GameData* game);
+void parseline(char line[], Statistics* stats, int tracker);
+
+// Functions for calculating stats
+bool highScoreFunc(Statistics* stats, GameData* game);
+bool playTime(Statistics* stats, float seconds);
+float pressTimingError(GameData* game, double pressTime);
+bool pressPassesHeadToHead(int player, int position, bool isMovingRight);
+PressGrade gradePress(GameData* game, double pressTime, double stepTime,
+	double previousStepTime, double* timingError);
+
+// Functions for changing game data
+bool updateLightPosition(GameData* game);
+bool updateLightDuration(GameData* game);
+bool setRandomDirection (GameData* game);
+void clearLightStates(GameData* game);
+bool resetGameData(GameData* game);
+
+//Functions for handling game logic
+double   monotonicTime();
+double   processCPUTime();
+void     waitForTimers(TimerWheel* timers);
+void     sleep(float seconds);
+void     sleepUntil(double time);
+bool     gameLoopIdle(Statistics* stats, GameData* game);
+bool     gameLoopWait();
+bool     gameLoopAttract(float idleTime);
+bool     gameLoopPlay(Statistics* stats, GameData* game);
+bool     gameLoopHeadToHead(GameData* game);
+GameTask playGame(GameContext* context);
+void     publishEvent(GameContext* context, StreamEventType type, int value);
+bool     simulateGames(int numGames, double errorStdDev,
+	const char* recordingFile);
+bool     replayGames(const char* fileName);
+bool     batchSimulateGames(int numGames, double errorStdDev);
+bool     isToolMode(const char* argument);
+bool     checkLevelCap();
+bool     sweepDifficulty(int argc, const char* const argv[]);
+bool     printLeaderboard(int numScores);
+bool     benchmarkOutput(int numFrames);
+bool     benchmarkPWM(float seconds);
+bool     benchmarkDisplay(float seconds);
+bool     benchmarkShiftRegister(int numLights, int numFrames);
+bool     benchmarkButtons(int numTrials);
+bool     benchmarkFaults(float seconds);
+bool     writeStandInValue(const char* fileName, bool isOn);
+int      removeStandInFile(const char* fileName, const struct stat*,
+	int type, struct FTW*);
+bool     benchmarkLatency(int numTrials);
+void     driveLatencyTrials(LatencyTrials* trials);
+GameTask reactToPresses(GameContext* context, LatencyTrials* trials);
+void     printLatencyPercentiles(const char* name,
+	vector<double>& latencies, bool isLast);
+bool     followEvents();
+bool     watchGame(float interval);
+bool     benchmarkSharedState(int numPublishes);
+void     checkSnapshots(SnapshotCheck* check);
+bool     benchmarkEvents(int numEvents);
+void     checkEvents(EventCheck* check);
+bool     queryHistory(int argc, const char* const argv[]);
+bool     printAccuracy(int numFiles, const char* const fileNames[]);
+bool     mergeSketches(int numFiles, const char* const fileNames[]);
+bool     sendControlCommand(int numWords, const char* const words[]);
+DifficultyConfig defaultDifficulty();
+
+// ----------------- [Function declarations end here] ------------------ //
+
+
+
+// ---------- [Functions for the TimerWheel class begin here] ---------- //
+
+// TimerWheel constructor
+TimerWheel::TimerWheel (double resolution, double originTime) {
+	this->resolution   = resolution;
+	this->originTime   = originTime;
+	this->currentTick  = 0;
+	this->nextSequence = 0;
+	this->freeList     = -1;
+	this->numActive    = 0;
+
+	// Mark every slot as empty
+	for (int level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+		for (int slot = 0; slot < TIMER_WHEEL_SLOTS; slot++) {
+			heads[level][slot] = -1;
+		}
+
+		for (int word = 0; word < TIMER_WHEEL_SLOTS / 64; word++) {
+			occupied[level][word] = 0;
+		}
+	}
+
+	// Reset monitoring
+	for (int i = 0; i <= MAX_TRACKED_EXPIRIES; i++) {
+		tickExpiryCounts[i] = 0;
+	}
+
+	countingTick       = -1;
+	countingExpiries   = 0;
+	totalExpired       = 0;
+	maxExpiriesPerTick = 0;
+}
+
+// Get the tick in which a time falls
+long long TimerWheel::tickFromTime (double time) {
+	double tick = floor((time - originTime) / resolution);
+
+	return (tick > 0) ? ((long long) tick) : (0);
+}
+
+// Get the earliest time which falls in a tick
+double TimerWheel::timeFromTick (long long tick) {
+	double time = originTime + tick * resolution;
+
+	// Step past rounding errors so that the time maps back to the tick
+	while (tickFromTime(time) < tick) {
+		time = nextafter(time, INFINITY);
+	}
+
+	return time;
+}
+
+// Place a timer in the slot matching its tick
+void TimerWheel::link (int index) {
+	TimerEntry& entry = entries[index];
+
+	// Timers whose tick has already been processed are due
+	if (entry.tick < currentTick) {
+		DueTimer dueTimer = {entry.time, entry.sequence, index,
+			entry.generation};
+
+		entry.level = TIMER_DUE;
+		due.push(dueTimer);
+
+		return;
+	}
+
+	// Find the lowest level which reaches the timer's tick, holding
+	// timers beyond the top level in its furthest slot
+	long long delta = entry.tick - currentTick;
+	long long tick  = entry.tick;
+	int level = 0;
+
+	while (level < TIMER_WHEEL_LEVELS - 1 &&
+			delta >= (1LL << (TIMER_WHEEL_SLOT_BITS * (level + 1)))) {
+		level++;
+	}
+
+	long long range = 1LL << (TIMER_WHEEL_SLOT_BITS * TIMER_WHEEL_LEVELS);
+
+	if (delta >= range) {
+		tick = currentTick + range - 1;
+	}
+
+	int slot = (tick >> (TIMER_WHEEL_SLOT_BITS * level)) &
+		(TIMER_WHEEL_SLOTS - 1);
+
+	// Add the timer to the front of the slot's list
+	entry.level    = level;
+	entry.slot     = slot;
+	entry.previous = -1;
+	entry.next     = heads[level][slot];
+
+	if (entry.next >= 0) {
+		entries[entry.next].previous = index;
+	}
+
+	heads[level][slot] = index;
+	occupied[level][slot / 64] |= 1ULL << (slot % 64);
+}
+
+// Remove a timer from its slot
+void TimerWheel::unlink (int index) {
+	TimerEntry& entry = entries[index];
+
+	// Due timers are skipped once their generation changes
+	if (entry.level < 0) {
+		return;
+	}
+
+	if (entry.previous >= 0) {
+		entries[entry.previous].next = entry.next;
+	} else {
+		heads[entry.level][entry.slot] = entry.next;
+	}
+
+	if (entry.next >= 0) {
+		entries[entry.next].previous = entry.previous;
+	}
+
+	// Mark the slot as empty if this was its last timer
+	if (heads[entry.level][entry.slot] < 0) {
+		occupied[entry.level][entry.slot / 64] &= ~(1ULL << (entry.slot % 64));
+	}
+}
+
+// Return an entry to the free list
+void TimerWheel::release (int index) {
+	TimerEntry& entry = entries[index];
+
+	entry.generation++;
+	entry.level = TIMER_FREE;
+	entry.next  = freeList;
+	freeList    = index;
+	numActive--;
+}
+
+// Move the timers of the current slot of a level to lower levels
+void TimerWheel::cascade (int level) {
+	int slot = (currentTick >> (TIMER_WHEEL_SLOT_BITS * level)) &
+		(TIMER_WHEEL_SLOTS - 1);
+	int index = heads[level][slot];
+
+	heads[level][slot] = -1;
+	occupied[level][slot / 64] &= ~(1ULL << (slot % 64));
+
+	while (index >= 0) {
+		int next = entries[index].next;
+
+		link(index);
+		index = next;
+	}
+}
+
+// Process the current tick, making its timers due
+void TimerWheel::processTick () {
+	// Bring down timers from higher levels when their slot comes up
+	for (int level = TIMER_WHEEL_LEVELS - 1; level > 0; level--) {
+		long long mask = (1LL << (TIMER_WHEEL_SLOT_BITS * level)) - 1;
+
+		if ((currentTick & mask) == 0) {
+			cascade(level);
+		}
+	}
+
+	// Timers in the slot of the processed tick are now due
+	int slot = currentTick & (TIMER_WHEEL_SLOTS - 1);
+	int index = heads[0][slot];
+
+	heads[0][slot] = -1;
+	occupied[0][slot / 64] &= ~(1ULL << (slot % 64));
+	currentTick++;
+
+	while (index >= 0) {
+		int next = entries[index].next;
+
+		link(index);
+		index = next;
+	}
+}
+
+// Find the first occupied slot of a level in a range of slots
+int TimerWheel::findOccupied (int level, int fromSlot, int toSlot) {
+	for (int slot = fromSlot; slot <= toSlot; ) {
+		unsigned long long word = occupied[level][slot / 64] >> (slot % 64);
+
+		if (word != 0) {
+			int found = slot + __builtin_ctzll(word);
+
+			return (found <= toSlot) ? (found) : (-1);
+		}
+
+		slot = (slot / 64 + 1) * 64;
+	}
+
+	return -1;
+}
+
+// Count a timer expiring in the given tick
+void TimerWheel::recordExpiry (long long tick) {
+	if (tick != countingTick) {
+		flushExpiryCount();
+		countingTick = tick;
+	}
+
+	countingExpiries++;
+	totalExpired++;
+}
+
+// Add the count for the last tick in which timers expired
+void TimerWheel::flushExpiryCount () {
+	if (countingExpiries == 0) {
+		return;
+	}
+
+	if (countingExpiries > maxExpiriesPerTick) {
+		maxExpiriesPerTick = countingExpiries;
+	}
+
+	tickExpiryCounts[min(countingExpiries, MAX_TRACKED_EXPIRIES)]++;
+	countingExpiries = 0;
+}
+
+// Add a timer which calls the callback once the given time has passed
+TimerId TimerWheel::add (double time, TimerCallback callback, void* context,
+		int value) {
+
+	int index;
+
+	// Reuse a free entry if there is one
+	if (freeList >= 0) {
+		index = freeList;
+		freeList = entries[index].next;
+	} else {
+		TimerEntry entry;
+
+		entry.generation = 0;
+		entries.push_back(entry);
+		index = entries.size() - 1;
+	}
+
+	TimerEntry& entry = entries[index];
+
+	entry.time     = time;
+	entry.tick     = tickFromTime(time);
+	entry.sequence = nextSequence++;
+	entry.callback = callback;
+	entry.context  = context;
+	entry.value    = value;
+
+	numActive++;
+	link(index);
+
+	TimerId id = {index, entry.generation};
+
+	return id;
+}
+
+// Cancel a pending timer
+bool TimerWheel::cancel (TimerId& id) {
+	// Check whether the timer is still pending
+	if (id.index < 0 || id.index >= (int) entries.size() ||
+			entries[id.index].generation != id.generation ||
+			entries[id.index].level == TIMER_FREE) {
+
+		id.index = -1;
+
+		return false;
+	}
+
+	unlink(id.index);
+	release(id.index);
+	id.index = -1;
+
+	return true;
+}
+
+// Call the callbacks of every timer which has expired by the given time
+void TimerWheel::advance (double now) {
+	long long targetTick = tickFromTime(now);
+
+	// Process ticks, skipping over empty slots
+	while (currentTick <= targetTick) {
+		processTick();
+
+		// Stop at the next slot boundary, where higher levels cascade
+		long long slotMask = TIMER_WHEEL_SLOTS - 1;
+
+		if ((currentTick & slotMask) == 0 || currentTick > targetTick) {
+			continue;
+		}
+
+		int slot = findOccupied(0, currentTick & slotMask, slotMask);
+		long long nextTick = (slot >= 0) ?
+			((currentTick & ~slotMask) + slot) :
+			((currentTick | slotMask) + 1);
+
+		currentTick = min(nextTick, targetTick + 1);
+	}
+
+	// Fire due timers in order of their exact times
+	while (!due.empty() && due.top().time <= now) {
+		DueTimer dueTimer = due.top();
+		due.pop();
+
+		TimerEntry& entry = entries[dueTimer.index];
+
+		// Skip timers which were cancelled
+		if (entry.generation != dueTimer.generation ||
+				entry.level != TIMER_DUE) {
+			continue;
+		}
+
+		TimerCallback callback = entry.callback;
+		void* context = entry.context;
+		int value = entry.value;
+
+		recordExpiry(entry.tick);
+		release(dueTimer.index);
+
+		callback(context, value);
+	}
+}
+
+// Get the earliest time at which a timer may expire
+double TimerWheel::nextExpiry () {
+	// Drop cancelled timers from the front of the due queue
+	while (!due.empty() &&
+			(entries[due.top().index].generation != due.top().generation ||
+			entries[due.top().index].level != TIMER_DUE)) {
+		due.pop();
+	}
+
+	if (!due.empty()) {
+		return due.top().time;
+	}
+
+	if (numActive == 0) {
+		return INFINITY;
+	}
+
+	// Look for the next occupied slot in the current turn of level 0
+	long long slotMask = TIMER_WHEEL_SLOTS - 1;
+	int currentSlot = currentTick & slotMask;
+	int slot = findOccupied(0, currentSlot, slotMask);
+
+	if (slot >= 0) {
+		return timeFromTick((currentTick & ~slotMask) + slot);
+	}
+
+	// Otherwise find the earliest slot start across all levels, which
+	// is when its timers cascade closer to expiring
+	long long earliestTick = -1;
+
+	for (int level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+		int shift = TIMER_WHEEL_SLOT_BITS * level;
+		long long turnLength = 1LL << (shift + TIMER_WHEEL_SLOT_BITS);
+		long long turnStart  = currentTick & ~(turnLength - 1);
+		int levelSlot = (currentTick >> shift) & slotMask;
+		long long tick = -1;
+
+		// Slots after the current one are in this turn, the rest in the
+		// next turn
+		slot = (levelSlot < slotMask) ?
+			(findOccupied(level, levelSlot + 1, slotMask)) : (-1);
+
+		if (level > 0 && slot >= 0) {
+			tick = turnStart + ((long long) slot << shift);
+		} else {
+			slot = findOccupied(level, 0, levelSlot);
+
+			if (slot >= 0) {
+				tick = turnStart + turnLength + ((long long) slot << shift);
+			}
+		}
+
+		if (tick >= 0 && (earliestTick < 0 || tick < earliestTick)) {
+			earliestTick = tick;
+		}
+	}
+
+	return timeFromTick(earliestTick);
+}
+
+// Determine whether there are no pending timers
+bool TimerWheel::isEmpty () {
+	return numActive == 0;
+}
+
+// Get the number of pending timers
+int TimerWheel::getNumActive () {
+	return numActive;
+}
+
+// Get the number of ticks in which the given number of timers expired,
+// with the last count including every larger number
+long long TimerWheel::getTickExpiryCount (int numExpired) {
+	flushExpiryCount();
+
+	if (numExpired < 0) {
+		return 0;
+	}
+
+	return tickExpiryCounts[min(numExpired, MAX_TRACKED_EXPIRIES)];
+}
+
+// Get the total number of timers which have expired
+long long TimerWheel::getTotalExpired () {
+	return totalExpired;
+}
+
+// Get the largest number of timers which expired in one tick
+int TimerWheel::getMaxExpiriesPerTick () {
+	flushExpiryCount();
+
+	return maxExpiriesPerTick;
+}
+
+// Write the expiry counts to the log
+void TimerWheel::logStatistics (const char* owner) {
+	flushExpiryCount();
+
+	sysLog.sysLog << "[" << owner << "] " <<
+		totalExpired << " timer(s) expired, at most " <<
+		maxExpiriesPerTick << " in one tick" << endl;
+
+	for (int i = 1; i <= MAX_TRACKED_EXPIRIES; i++) {
+		if (tickExpiryCounts[i] > 0) {
+			sysLog.sysLog << "[" << owner << "] " <<
+				tickExpiryCounts[i] << " tick(s) with " << i <<
+				((i == MAX_TRACKED_EXPIRIES) ? (" or more") : ("")) <<
+				" expiries" << endl;
+		}
+	}
+}
+
+// ----------- [Functions for the TimerWheel class end here] ----------- //
+
+
+
+// ------------- [Functions for the Timer class begin here] ------------ //
+
+// Mark a timer as finished when its wheel entry expires
+void Timer::onExpire (void* context, int) {
+	((Timer*) context)->hasFinished = true;
+}
+
+// Deconstructor
+Timer::~Timer () {
+	systemTimers.cancel(timerID);
+}
+
+// Set timer for some number of seconds in the future
+bool Timer::setStopTime (float seconds) {
+
+	// Check for a valid time to add
+	if (seconds >= 0) {
+		sysLog.sysLog <<
+			"[Timer::setStopTime] Setting timer for " <<
+			seconds << " second(s) in the future" << endl;
+
+		systemTimers.cancel(timerID);
+		hasFinished = false;
+		timerID = systemTimers.add(monotonicTime() + seconds, onExpire,
+			this, 0);
+	}
+
+	return seconds >= 0;
+}
+
+// Determine whether the timer has finished
+bool Timer::isFinished () {
+	// Check for a valid stop time
+	if (timerID.index >= 0 || hasFinished) {
+		// Fire every timer whose stop time has passed
+		systemTimers.advance(monotonicTime());
+
+		return hasFinished;
+
+	// Handle invalid stop times
+	} else {
+		sysLog.sysLog <<
+			"[Timer::isFinished] ERROR: Timer was never set" << endl;
+
+		return false;
+	}
+}
+
+// Block until the next timer of a wheel may expire
+void waitForTimers (TimerWheel* timers) {
+	if (timers->isEmpty()) {
+		return;
+	}
+
+	double wakeTime = timers->nextExpiry();
+	timespec wakeSpec;
+
+	wakeSpec.tv_sec  = (time_t) floor(wakeTime);
+	wakeSpec.tv_nsec = (long) ((wakeTime - floor(wakeTime)) * 1e9);
+
+	clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wakeSpec, NULL);
+}
+
+// -------------- [Functions for the Timer class end here] ------------- //
+
+
+
+// ---------- [Functions for the log limit class begin here] ----------- //
+
+// First limited call site
+std::atomic<LogLimit*> LogLimit::sites(NULL);
+
+// LogLimit constructor, which adds the site to the list of sites
+LogLimit::LogLimit (const char* site, const char* description) {
+	this->site        = site;
+	this->description = description;
+	interval          = (long long) (1e9 / LOG_LIMIT_RATE);
+	tolerance         = interval * (LOG_LIMIT_BURST - 1);
+	fullTime          = 0;
+	numRepeats        = 0;
+	numSuppressed     = 0;
+	next              = sites.load();
+
+	while (!sites.compare_exchange_weak(next, this)) {
+	}
+}
+
+// Determine whether the site may log now, writing how many messages were
+// dropped since its last one if it may
+bool LogLimit::allow () {
+	timespec currentTime;
+
+	clock_gettime(CLOCK_MONOTONIC_COARSE, &currentTime);
+
+	long long now = currentTime.tv_sec * 1000000000LL + currentTime.tv_nsec;
+	long long full = fullTime.load(memory_order_relaxed);
+
+	// Take a token unless the bucket is empty
+	do {
+		if (full - tolerance > now) {
+			numRepeats.fetch_add(1, memory_order_relaxed);
+			numSuppressed.fetch_add(1, memory_order_relaxed);
+
+			return false;
+		}
+	} while (!fullTime.compare_exchange_weak(full, max(full, now) + interval,
+		memory_order_relaxed));
+
+	unsigned long long repeats = numRepeats.exchange(0, memory_order_relaxed);
+
+	if (repeats > 0) {
+		sysLog.sysLog << site << repeats << " more " << description <<
+			" message(s) suppressed" << endl;
+	}
+
+	return true;
+}
+
+// Write how many messages each site dropped
+void LogLimit::reportAll () {
+	for (LogLimit* limit = sites.load(); limit != NULL; limit = limit->next) {
+		if (limit->numSuppressed > 0) {
+			sysLog.sysLog << limit->site << limit->numSuppressed <<
+				" " << limit->description <<
+				" message(s) suppressed in total" << endl;
+		}
+	}
+}
+
+// ----------- [Functions for the log limit class end here] ------------ //
+
+
+
+// --------- [Functions for the GPIOHandler class begin here] ---------- //
+
+// Helper function for GPIOHandler constructor
+// Get string representation of int
+bool GPIOHandler::stringFromInt (int num, char*& output) {
+	sysLog.sysLog << "[GPIOHandler::stringFromInt] " <<
+		"Entered function" << endl;
+
+	// Reject negative numbers
+	if (num < 0) {
+		sysLog.sysLog << "[GPIOHandler::stringFromInt] " <<
+			"ERROR: Received negative number" << endl;
+
+		return false;
+
+	// Handle the 0 case
+	} else if (num == 0) {
+		output = new char[2];
+		output[0] = '0';
+		output[1] = 0;
+	} else {
+		int length = floor(log10(num) + 1) + 1;
+		output = new char[length];
+
+		// Null-terminate the string
+		output[length - 1] = 0;
+
+		// Add each digit to the string
+		for (int i = 1; i < length; i++) {
 			output[length - i - 1] = (num % 10) + '0';
 			num /= 10;
 		}
 	}
 
-	sysLog.sysLog << "[GPIOHandler::stringFromInt] " <<
-		"Received " << num << "; outputting \"" << output << "\"" << endl;
+	sysLog.sysLog << "[GPIOHandler::stringFromInt] " <<
+		"Received " << num << "; outputting \"" << output << "\"" << endl;
+
+	return true;
+}
+
+// Helper function for GPIOHandler::concatenate
+// Get number of characters in a string
+int GPIOHandler::getLength (const char* string) {
+	sysLog.sysLog << "[GPIOHandler::getLength] " <<
+		"Entered function" << endl;
+
+	// Check for null array
+	if (string == NULL) {
+		sysLog.sysLog << "[GPIOHandler::getLength] " <<
+			"ERROR: Received null string" << endl;
+
+		return -1;
+	}
+
+	int length = 0;
+
+	// Count number of non-null characters
+	while (string[length] != 0) {
+		length++;
+	}
+
+	sysLog.sysLog << "[GPIOHandler::getLength] " <<
+		"Received string of " << length << " characters" << endl;
+
+	return length;
+}
+
+// Helper function for GPIOHandler constructor
+// Concatenate strings
+bool GPIOHandler::concatenate (const char* string1,
+		const char* string2, char*& output) {
+
+	sysLog.sysLog << "[GPIOHandler::concatenate] " <<
+		"Entered function" << endl;
+
+	int outputStringIndex = 0;
+	int inputStringIndex  = 0;
+
+	// Check for null pointers
+	if (string1 == NULL || string2 == NULL) {
+		sysLog.sysLog << "[GPIOHandler::concatenate] " <<
+			"ERROR: Received null string" << endl;
+
+		return false;
+	}
+
+	int length = getLength(string1) + getLength(string2) + 1;
+
+	output = new char[length];
+
+	// Copy string1 into outputString
+	while (string1[inputStringIndex] != 0) {
+		output[outputStringIndex] = string1[inputStringIndex];
+		outputStringIndex++;
+		inputStringIndex ++;
+	}
+
+	inputStringIndex = 0;
+
+	// Copy string2 into outputString
+	while (string2[inputStringIndex] != 0) {
+		output[outputStringIndex] = string2[inputStringIndex];
+		outputStringIndex++;
+		inputStringIndex ++;
+	}
+
+	// Null-terminate the string
+	output[outputStringIndex] = 0;
+
+	sysLog.sysLog << "[GPIOHandler::concatenate] " <<
+		"Concatenated string: \"" << output << "\"" << endl;
+
+	return true;
+}
+
+// GPIOHandler constructor given pinID
+GPIOHandler::GPIOHandler (int pinID) {
+	sysLog.sysLog << "[GPIOHandler::GPIOHandler] " <<
+		"Entered constructor" << endl;
+
+	this->valueFileName = NULL;
+	this->valueFileDescriptor = -1;
+	this->directionFileName = NULL;
+	char* idString;
+
+	// Handle invalid ID
+	if (!stringFromInt(pinID, idString) ||
+			!concatenate(GPIO_DIRECTORY, idString, this->directoryName)) {
+
+		sysLog.sysLog << "[GPIOHandler::GPIOHandler] " <<
+			"ERROR: Received invalid pinID: " << pinID << endl;
+
+		this->pinID = -1;
+	} else {
+
+		this->pinID = pinID;
+	}
+}
+
+// Default GPIOHandler constructor
+GPIOHandler::GPIOHandler () {
+	sysLog.sysLog << "[GPIOHandler::GPIOHandler] " <<
+		"Entered constructor" << endl;
+
+	this->pinID = -1;
+	this->directoryName = NULL;
+	this->valueFileName = NULL;
+	this->valueFileDescriptor = -1;
+	this->directionFileName = NULL;
+}
+
+// GPIOHandler deconstructor
+GPIOHandler::~GPIOHandler () {
+	delete directoryName;
+	directoryName = NULL;
+	delete valueFileName;
+	valueFileName = NULL;
+	delete[] directionFileName;
+	directionFileName = NULL;
+	pinID = -1;
+
+	if (inFile.is_open()) {
+		inFile.close();
+	}
+
+	if (outFile.is_open()) {
+		outFile.close();
+	}
+
+	if (valueFileDescriptor >= 0) {
+		close(valueFileDescriptor);
+		valueFileDescriptor = -1;
+	}
+}
+
+// Activate GPIO pin
+bool GPIOHandler::activate () {
+	sysLog.sysLog << "[GPIOHandler::activate] " <<
+		"Entered function" << endl;
+
+	// Check if object is valid
+	if (pinID < 0) {
+		sysLog.sysLog << "[GPIOHandler::activate] " <<
+			"ERROR: Received invalid pinID: " << pinID << endl;
+
+		return false;
+	}
+
+	// Check if pin has already been activated
+	inFile.open(directoryName);
+
+	if (inFile.is_open()) {
+		sysLog.sysLog << "[GPIOHandler::activate] " <<
+			"WARNING: GPIO pin has already been activated" << endl;
+
+		return true;
+	}
+
+	inFile.close();
+	outFile.open(GPIO_EXPORT);
+
+	// Check if export file was successfully opened
+	if (!outFile.is_open()) {
+		sysLog.sysLog << "[GPIOHandler::activate] " <<
+			"ERROR: Could not open \"" << GPIO_EXPORT << "\"" << endl;
+
+		return false;
+	}
+
+	// Activate GPIO pin
+	char* stringID;
+
+	sysLog.sysLog << "[GPIOHandler::activate] " <<
+		"Getting pinID as a string" << endl;
+
+	// Check for valid pinID
+	if (!stringFromInt(pinID, stringID)) {
+		sysLog.sysLog << "[GPIOHandler::activate] " <<
+			"ERROR: Received invalid pinID " << endl;
+
+		return false;
+	}
+
+	outFile << stringID;
+	outFile.close();
+
+	return true;
+}
+
+// Deactivate GPIO pin
+bool GPIOHandler::deactivate () {
+	sysLog.sysLog << "[GPIOHandler::deactivate] " <<
+		"Entered function" << endl;
+
+	// Check if object is valid
+	if (pinID < 0) {
+		sysLog.sysLog << "[GPIOHandler::deactivate] " <<
+			"ERROR: Received invalid pinID: " << pinID << endl;
+
+		return false;
+	}
+
+	// Check if pin has already been deactivated
+	inFile.open(directoryName);
+
+	if (!inFile.is_open()) {
+		sysLog.sysLog << "[GPIOHandler::deactivate] " <<
+			"WARNING: GPIO pin has already been deactivated" << endl;
+
+		return true;
+	}
+
+	inFile.close();
+
+	if (outFile.is_open()) {
+		outFile.close();
+	}
+
+	outFile.open(GPIO_UNEXPORT);
+
+	// Check if export file was successfully opened
+	if (!outFile.is_open()) {
+		sysLog.sysLog << "[GPIOHandler::deactivate] " <<
+			"ERROR: Could not open " << GPIO_UNEXPORT << endl;
+
+		return false;
+	}
+
+	// Deactivate GPIO pin
+	char* stringID;
+
+	sysLog.sysLog << "[GPIOHandler::deactivate] " <<
+		"Getting pinID as a string" << endl;
+
+	stringFromInt(pinID, stringID);
+	outFile << stringID;
+	outFile.close();
+
+	return true;
+}
+
+// Designate GPIO pin to be either input or output
+bool GPIOHandler::setType (bool isInput) {
+	const char* IO_DIRECTION_FILE =
+		"/direction";
+
+	sysLog.sysLog << "[GPIOHandler::setType] " <<
+		"Entered function" << endl;
+
+	// Check if object is valid
+	if (pinID < 0) {
+		sysLog.sysLog << "[GPIOHandler::setType] " <<
+			"ERROR: Received invalid pinID: " << pinID << endl;
+
+		return false;
+	}
+
+	char* directionFileName;
+
+	sysLog.sysLog << "[GPIOHandler::setType] " <<
+		"Building path name" << endl;
+
+	// Check if path name was built correctly
+	if (!concatenate(directoryName, IO_DIRECTION_FILE, directionFileName)) {
+		sysLog.sysLog << "[GPIOHandler::setType] " <<
+			"ERROR: Path name could not be built" << endl;
+
+		return false;
+	}
+
+	outFile.open(directionFileName);
+
+	// Check if file was opened properly
+	if (!outFile.is_open()) {
+		sysLog.sysLog << "[GPIOHandler::setType] " <<
+			"ERROR: IO direction file could not be opened" << endl;
+
+		return false;
+	}
+
+	if (isInput) {
+		outFile << "in";
+	} else {
+		outFile << "out";
+	}
+
+	sysLog.sysLog << "[GPIOHandler::setType] " <<
+		"Pin " << pinID << " set to " <<
+		((isInput) ? ("input") : ("output")) << endl;
+
+	outFile.close();
+
+	return true;
+}
+
+// Get state of pin
+bool GPIOHandler::getState (bool& isOn) {
+	/*sysLog.sysLog << "[GPIOHandler::getState] " <<
+		"Entered function" << endl;*/
+
+	// Check if object is valid
+	if (pinID < 0) {
+		sysLog.sysLog << "[GPIOHandler::getState] " <<
+			"ERROR: Received invalid pinID: " << pinID << endl;
+
+		return false;
+	}
+
+	// Build path name
+	if (!buildValueFileName()) {
+		sysLog.sysLog << "[GPIOHandler::getState] " <<
+			"ERROR: path name could not be built" << endl;
+
+		return false;
+	}
+
+	// Let injected faults delay the read or fail it
+	if (!gpioFaults.inject(FAULT_READ)) {
+		sysLog.sysLog << "[GPIOHandler::getState] " <<
+			"ERROR: Value could not be read (injected EIO)" << endl;
+
+		return false;
+	}
+
+	this->inFile.close();
+	this->inFile.open(valueFileName);
+
+	// Check if file could be opened
+	if (!this->inFile.is_open()) {
+		sysLog.sysLog << "[GPIOHandler::getState] " <<
+			"ERROR: File could not be opened" << endl;
+
+		return false;
+	}
+
+	// Read value from file
+	char pinState = 0;
+
+	// Check if value can be read
+	if (!this->inFile.get(pinState)) {
+		sysLog.sysLog << "[GPIOHandler::getState] " <<
+			"ERROR: Value could not be read" << endl;
+
+		return false;
+	}
+
+	/*sysLog.sysLog << "[GPIOHandler::getState] " <<
+		"Read value \"" << pinState << "\"" << endl;*/
+
+	isOn = (pinState == '1');
+
+	// A stuck pin reads its stuck value
+	gpioFaults.holdsValue(pinID, isOn);
+
+	return true;
+}
+
+// Read state of pin without logging, through a file opened for this read
+// alone, for threads other than the game's, which must not write to the
+// log or share the game's file streams
+bool GPIOHandler::readState (bool& isOn) {
+	// The path is built before the pin is handed to another thread, and
+	// injected faults may delay the read or fail it
+	if (valueFileName == NULL || !gpioFaults.inject(FAULT_READ)) {
+		return false;
+	}
+
+	int fileDescriptor = open(valueFileName, O_RDONLY);
+
+	// Check if file could be opened
+	if (fileDescriptor < 0) {
+		return false;
+	}
+
+	char pinState = 0;
+	ssize_t numRead = read(fileDescriptor, &pinState, 1);
+
+	close(fileDescriptor);
+
+	if (numRead != 1) {
+		return false;
+	}
+
+	isOn = (pinState == '1');
+
+	// A stuck pin reads its stuck value
+	gpioFaults.holdsValue(pinID, isOn);
+
+	return true;
+}
+
+// Set state of pin, logging the value. This is only called from the game
+// thread; other threads use writeState().
+bool GPIOHandler::setState (bool isOn) {
+	// Check if object is valid
+	if (pinID < 0) {
+		sysLog.sysLog << "[GPIOHandler::setState] " <<
+			"ERROR: Received invalid pinID: " << pinID << endl;
+
+		return false;
+	}
+
+	/*sysLog.sysLog << "[GPIOHandler::setState][Pin " << pinID << "] " <<
+	"Entered function" << endl;*/
+
+	int fileDescriptor = getValueFileDescriptor();
+
+	// Check if file could be opened
+	if (fileDescriptor < 0) {
+		sysLog.sysLog << "[GPIOHandler::setState][Pin " << pinID << "] " <<
+			"ERROR: File could not be opened" << endl;
+
+		return false;
+	}
+
+	// Let injected faults delay the write or fail it, and keep a stuck
+	// pin at its stuck value
+	if (!gpioFaults.inject(FAULT_WRITE)) {
+		sysLog.sysLog << "[GPIOHandler::setState][Pin " << pinID << "] " <<
+			"ERROR: Value could not be written (injected EIO)" << endl;
+
+		return false;
+	}
+
+	gpioFaults.holdsValue(pinID, isOn);
+
+	// Set value, logging at a limited rate since the game writes the
+	// lights on every step
+	static LogLimit valueLimit("[GPIOHandler::setState] ", "pin value");
+
+	if (valueLimit.allow()) {
+		sysLog.sysLog << "[GPIOHandler::setState][Pin " << pinID << "] " <<
+			"Value set to " << (isOn + 0) << endl;
+	}
+
+	if (pwrite(fileDescriptor, (isOn) ? ("1") : ("0"), 1, 0) != 1) {
+		sysLog.sysLog << "[GPIOHandler::setState][Pin " << pinID << "] " <<
+			"ERROR: Value could not be written" << endl;
+
+		return false;
+	}
+
+	return true;
+}
+
+// Set state of pin without logging, for threads other than the game's,
+// which must not write to the log
+bool GPIOHandler::writeState (bool isOn) {
+	int fileDescriptor = getValueFileDescriptor();
+
+	// Check if file could be opened, and let injected faults delay the
+	// write or fail it
+	if (fileDescriptor < 0 || !gpioFaults.inject(FAULT_WRITE)) {
+		return false;
+	}
+
+	gpioFaults.holdsValue(pinID, isOn);
+
+	return pwrite(fileDescriptor, (isOn) ? ("1") : ("0"), 1, 0) == 1;
+}
+
+// Get the value file, opening it for writing and keeping it open
+int GPIOHandler::getValueFileDescriptor () {
+	if (valueFileDescriptor >= 0 || pinID < 0) {
+		return valueFileDescriptor;
+	}
+
+	// Build path name
+	if (!buildValueFileName()) {
+		sysLog.sysLog << "[GPIOHandler::getValueFileDescriptor] " <<
+			"ERROR: path name could not be built" << endl;
+
+		return -1;
+	}
+
+	valueFileDescriptor = open(valueFileName, O_WRONLY);
+
+	return valueFileDescriptor;
+}
+
+// Determine whether the pin has been exported
+bool GPIOHandler::isActivated () {
+	return pinID >= 0 && access(directoryName, F_OK) == 0;
+}
+
+// Determine whether the attribute files of the pin can be used yet
+bool GPIOHandler::isReady (bool isInput) {
+	const char* IO_DIRECTION_FILE =
+		"/direction";
+
+	// Check if object is valid
+	if (pinID < 0) {
+		return false;
+	}
+
+	// Build path names
+	if ((directionFileName == NULL && !concatenate(directoryName,
+			IO_DIRECTION_FILE, directionFileName)) || !buildValueFileName()) {
+		return false;
+	}
+
+	return access(directionFileName, R_OK | W_OK) == 0 &&
+		access(valueFileName, (isInput) ? (R_OK) : (W_OK)) == 0;
+}
+
+// Set the direction of the pin unless it already has it, returning 1 if
+// the pin was configured, 0 if it was skipped and -1 on errors. This does
+// not log, so pins can be configured from several threads at once.
+int GPIOHandler::configure (bool isInput) {
+	const char* direction = (isInput) ? ("in") : ("out");
+	char currentDirection[8] = {0};
+	int result = 0;
+
+	// Check if object is valid
+	if (pinID < 0 || directionFileName == NULL) {
+		return -1;
+	}
+
+	int fileDescriptor = open(directionFileName, O_RDONLY);
+
+	if (fileDescriptor < 0) {
+		return -1;
+	}
+
+	ssize_t length = read(fileDescriptor, currentDirection,
+		sizeof(currentDirection) - 1);
+
+	close(fileDescriptor);
+
+	// Write the direction only if it differs
+	if (length < 0 || strncmp(currentDirection, direction,
+			strlen(direction)) != 0 || (length > (ssize_t) strlen(direction) &&
+				currentDirection[strlen(direction)] != '\n')) {
+
+		fileDescriptor = open(directionFileName, O_WRONLY | O_TRUNC);
+		result = (fileDescriptor >= 0 && write(fileDescriptor, direction,
+			strlen(direction)) == (ssize_t) strlen(direction)) ? (1) : (-1);
+
+		if (fileDescriptor >= 0) {
+			close(fileDescriptor);
+		}
+	}
+
+	// Open the value file of outputs ahead of the first frame
+	if (result >= 0 && !isInput && getValueFileDescriptor() < 0) {
+		result = -1;
+	}
+
+	return result;
+}
+
+// Get the identifier of the pin
+int GPIOHandler::getPinID () {
+	return pinID;
+}
+
+// Get the directory for controlling the pin
+const char* GPIOHandler::getDirectoryName () {
+	return directoryName;
+}
+
+// Get the name of the value file of the pin
+const char* GPIOHandler::getValueFileName () {
+	if (!buildValueFileName()) {
+		return NULL;
+	}
+
+	return valueFileName;
+}
+
+// Choose which edges of an input raise an interrupt: "none", "rising",
+// "falling" or "both"
+bool GPIOHandler::setEdge (const char* edge) {
+	const char* IO_EDGE_FILE =
+		"/edge";
+
+	sysLog.sysLog << "[GPIOHandler::setEdge][Pin " << pinID << "] " <<
+		"Entered function" << endl;
+
+	// Check if object is valid
+	if (pinID < 0 || edge == NULL) {
+		sysLog.sysLog << "[GPIOHandler::setEdge] " <<
+			"ERROR: Received invalid arguments" << endl;
+
+		return false;
+	}
+
+	char* edgeFileName = NULL;
+
+	if (!concatenate(directoryName, IO_EDGE_FILE, edgeFileName)) {
+		sysLog.sysLog << "[GPIOHandler::setEdge] " <<
+			"ERROR: path name could not be built" << endl;
+
+		return false;
+	}
+
+	// Only pins which can raise interrupts have an edge file
+	int fileDescriptor = open(edgeFileName, O_WRONLY | O_TRUNC);
+
+	delete[] edgeFileName;
+
+	if (fileDescriptor < 0) {
+		sysLog.sysLog << "[GPIOHandler::setEdge][Pin " << pinID << "] " <<
+			"Pin has no edge file" << endl;
+
+		return false;
+	}
+
+	bool isWritten = write(fileDescriptor, edge, strlen(edge)) ==
+		(ssize_t) strlen(edge);
+
+	close(fileDescriptor);
+
+	return isWritten;
+}
+
+// Build the name of the value file once
+bool GPIOHandler::buildValueFileName () {
+	const char* IO_VALUE_FILE =
+		"/value";
+
+	if (valueFileName != NULL) {
+		return true;
+	}
+
+	sysLog.sysLog << "[GPIOHandler::buildValueFileName][Pin " << pinID <<
+		"] " << "Building path name" << endl;
+
+	return concatenate(directoryName, IO_VALUE_FILE, valueFileName);
+}
+
+// ---------- [Functions for the GPIOHandler class end here] ----------- //
+
+
+
+// --------- [Functions for the fault injector class begin here] -------- //
+
+// FaultInjector constructor
+FaultInjector::FaultInjector () : generator(time(NULL)) {
+	hasFaults = false;
+	isEnabled = false;
+	startTime = 0;
+	numStuckAccesses = 0;
+
+	for (int access = 0; access < NUM_FAULT_ACCESSES; access++) {
+		FaultProfile& profile = profiles[access];
+
+		profile.delayKind          = DELAY_NONE;
+		profile.delayParameters[0] = 0;
+		profile.delayParameters[1] = 0;
+		profile.spikeRate          = 0;
+		profile.spikeTime          = 0;
+		profile.errorRate          = 0;
+		profile.numAccesses        = 0;
+		profile.numSpikes          = 0;
+		profile.numErrors          = 0;
+		profile.totalDelay         = 0;
+	}
+}
+
+// Read one line of a fault file, returning false if it is not understood
+bool FaultInjector::parseLine (const char* line) {
+	char word[MAX_LINE_LENGTH];
+	char kind[MAX_LINE_LENGTH];
+	double values[2] = {0, INFINITY};
+	int pinID = 0;
+	int isOn = 0;
+	unsigned int seed = 0;
+
+	// Skip blank lines and comments
+	if (sscanf(line, "%99s", word) != 1 || word[0] == '#') {
+		return true;
+	}
+
+	if (strcmp(word, "seed") == 0) {
+		if (sscanf(line, "%*s %u", &seed) != 1) {
+			return false;
+		}
+
+		generator.seed(seed);
+
+		return true;
+	}
+
+	// Hold a pin from a time after injection starts for a while, or for
+	// good
+	if (strcmp(word, "stuck") == 0) {
+		if (sscanf(line, "%*s %d %d %lf %lf", &pinID, &isOn, &values[0],
+				&values[1]) < 2 || values[0] < 0 || values[1] < 0) {
+			return false;
+		}
+
+		StuckPin pin = {pinID, isOn != 0, values[0], values[0] + values[1]};
+
+		stuckPins.push_back(pin);
+
+		return true;
+	}
+
+	FaultAccess access;
+
+	if (strcmp(word, "read") == 0) {
+		access = FAULT_READ;
+	} else if (strcmp(word, "write") == 0) {
+		access = FAULT_WRITE;
+	} else {
+		return false;
+	}
+
+	FaultProfile& profile = profiles[access];
+
+	if (sscanf(line, "%*s %99s", kind) != 1) {
+		return false;
+	}
+
+	if (strcmp(kind, "delay") == 0) {
+		char distribution[MAX_LINE_LENGTH];
+		int numValues = sscanf(line, "%*s %*s %99s %lf %lf", distribution,
+			&values[0], &values[1]) - 1;
+
+		if (strcmp(distribution, "fixed") == 0 && numValues >= 1) {
+			profile.delayKind = DELAY_FIXED;
+		} else if (strcmp(distribution, "uniform") == 0 && numValues >= 2 &&
+				values[1] >= values[0]) {
+			profile.delayKind = DELAY_UNIFORM;
+		} else if (strcmp(distribution, "exponential") == 0 &&
+				numValues >= 1) {
+			profile.delayKind = DELAY_EXPONENTIAL;
+		} else {
+			return false;
+		}
+
+		profile.delayParameters[0] = values[0];
+		profile.delayParameters[1] = values[1];
+
+		return values[0] >= 0;
+	}
+
+	if (strcmp(kind, "spike") == 0) {
+		return sscanf(line, "%*s %*s %lf %lf", &profile.spikeRate,
+			&profile.spikeTime) == 2 && profile.spikeTime >= 0;
+	}
+
+	if (strcmp(kind, "error") == 0) {
+		return sscanf(line, "%*s %*s %lf", &profile.errorRate) == 1;
+	}
+
+	return false;
+}
+
+// Draw a number between 0 and 1, from whichever thread is accessing a pin
+double FaultInjector::drawUniform () {
+	std::lock_guard<std::mutex> guard(generatorLock);
+
+	return std::uniform_real_distribution<double>(0, 1)(generator);
+}
+
+// Load the faults to inject from a file, and start injecting them
+bool FaultInjector::load (const char* fileName) {
+	sysLog.sysLog << "[FaultInjector::load] " <<
+		"Entered function" << endl;
+
+	// Check for null pointer
+	if (fileName == NULL) {
+		sysLog.sysLog << "[FaultInjector::load] " <<
+			"ERROR: Null pointer found" << endl;
+
+		return false;
+	}
+
+	ifstream inFile(fileName);
+
+	// Check if file could be opened
+	if (!inFile.is_open()) {
+		sysLog.sysLog << "[FaultInjector::load] " <<
+			"ERROR: \"" << fileName << "\" could not be opened" << endl;
+
+		return false;
+	}
+
+	char line[MAX_LINE_LENGTH];
+	int lineNumber = 0;
+
+	while (inFile.getline(line, MAX_LINE_LENGTH)) {
+		lineNumber++;
+
+		if (!parseLine(line)) {
+			sysLog.sysLog << "[FaultInjector::load] " <<
+				"ERROR: Line " << lineNumber << " of \"" << fileName <<
+				"\" is not understood: " << line << endl;
+
+			return false;
+		}
+	}
+
+	hasFaults = true;
+	setEnabled(true);
+
+	sysLog.sysLog << "[FaultInjector::load] " <<
+		"Injecting faults from \"" << fileName << "\", " <<
+		stuckPins.size() << " stuck pin(s)" << endl;
+
+	return true;
+}
+
+// Start or stop injecting the loaded faults, timing stuck pins from the
+// start
+void FaultInjector::setEnabled (bool isEnabled) {
+	startTime.store(monotonicTime(), memory_order_relaxed);
+	this->isEnabled.store(isEnabled && hasFaults, memory_order_relaxed);
+}
+
+// Determine whether faults have been loaded
+bool FaultInjector::isLoaded () {
+	return hasFaults;
+}
+
+// Delay an access to a pin as its profile says, returning false if the
+// access should fail with EIO
+bool FaultInjector::inject (FaultAccess access) {
+	if (!isEnabled.load(memory_order_relaxed)) {
+		return true;
+	}
+
+	FaultProfile& profile = profiles[access];
+	double delay = 0;
+
+	profile.numAccesses++;
+
+	switch (profile.delayKind) {
+		case DELAY_FIXED:
+			delay = profile.delayParameters[0];
+
+			break;
+		case DELAY_UNIFORM:
+			delay = profile.delayParameters[0] + drawUniform() *
+				(profile.delayParameters[1] - profile.delayParameters[0]);
+
+			break;
+		case DELAY_EXPONENTIAL:
+			delay = -profile.delayParameters[0] * log(1 - drawUniform());
+
+			break;
+		default:
+			break;
+	}
+
+	if (profile.spikeRate > 0 && drawUniform() < profile.spikeRate) {
+		delay += profile.spikeTime;
+		profile.numSpikes++;
+	}
+
+	if (delay > 0) {
+		profile.totalDelay += delay;
+		sleepUntil(monotonicTime() + delay);
+	}
+
+	if (profile.errorRate > 0 && drawUniform() < profile.errorRate) {
+		profile.numErrors++;
+		errno = EIO;
+
+		return false;
+	}
+
+	return true;
+}
+
+// Replace the value of a pin with the one it is stuck at, returning
+// whether it is stuck
+bool FaultInjector::holdsValue (int pinID, bool& isOn) {
+	if (!isEnabled.load(memory_order_relaxed) || stuckPins.empty()) {
+		return false;
+	}
+
+	double time = monotonicTime() - startTime.load(memory_order_relaxed);
+
+	for (size_t i = 0; i < stuckPins.size(); i++) {
+		if (stuckPins[i].pinID == pinID && time >= stuckPins[i].startTime &&
+				time < stuckPins[i].endTime) {
+			isOn = stuckPins[i].isOn;
+			numStuckAccesses++;
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// Write how many faults were injected, starting each line with prefix
+void FaultInjector::report (ostream& output, const char* prefix) {
+	const char* accessNames[NUM_FAULT_ACCESSES] = {"read", "write"};
+
+	for (int access = 0; access < NUM_FAULT_ACCESSES; access++) {
+		FaultProfile& profile = profiles[access];
+
+		output << prefix << "Injected into " << profile.numAccesses << " " <<
+			accessNames[access] << "(s): " << profile.numSpikes <<
+			" stall(s), " << profile.numErrors << " EIO error(s), " <<
+			profile.totalDelay * 1000 << " ms of delay" << endl;
+	}
+
+	output << prefix << "Stuck pins held " << numStuckAccesses << " access(es)" << endl;
+}
+
+// ---------- [Functions for the fault injector class end here] --------- //
+
+
+
+// --------- [Functions for the stand-in tree class begin here] --------- //
+
+// StandInTree constructor
+StandInTree::StandInTree () {
+	directoryName[0] = '\0';
+	previousDirectory = -1;
+}
+
+// StandInTree deconstructor
+StandInTree::~StandInTree () {
+	leave();
+}
+
+// Create the directory and files of a pin, left as an output at 0
+bool StandInTree::makePin (int pinID) {
+	string directory = GPIO_DIRECTORY + to_string(pinID);
+
+	if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+		return false;
+	}
+
+	ofstream directionFile((directory + "/direction").c_str());
+
+	directionFile << "out" << endl;
+	directionFile.close();
+
+	return !directionFile.fail() &&
+		writeStandInValue((directory + "/value").c_str(), false);
+}
+
+// Build a stand-in tree and work inside it, unless the pins are the
+// kernel's, in which case nothing is done
+bool StandInTree::enter () {
+	sysLog.sysLog << "[StandInTree::enter] " <<
+		"Entered function" << endl;
+
+	struct statfs fileSystem;
+
+	// Use the real pins when there are some
+	if (statfs(GPIO_ROOT, &fileSystem) == 0 &&
+			fileSystem.f_type == SYSFS_MAGIC) {
+		return true;
+	}
+
+	leave();
+	strcpy(directoryName, STAND_IN_TREE_TEMPLATE);
+	previousDirectory = open(".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+	if (previousDirectory < 0 || mkdtemp(directoryName) == NULL ||
+			chdir(directoryName) != 0) {
+		sysLog.sysLog << "[StandInTree::enter] " <<
+			"ERROR: Temporary directory could not be created" << endl;
+		cerr << "[StandInTree::enter] ERROR: Could not build a stand-in " <<
+			"GPIO tree" << endl;
+
+		directoryName[0] = '\0';
+		leave();
+
+		return false;
+	}
+
+	// Create every directory leading to the pins, then the export files
+	string root = GPIO_ROOT;
+	bool succeeded = true;
+	size_t slash = 0;
+
+	while (succeeded && slash != string::npos) {
+		slash = root.find('/', slash + 1);
+		succeeded = mkdir(root.substr(0, slash).c_str(), 0755) == 0;
+	}
+
+	ofstream exportFile(GPIO_EXPORT);
+	ofstream unexportFile(GPIO_UNEXPORT);
+
+	succeeded = succeeded && exportFile.is_open() && unexportFile.is_open();
+
+	// Add every pin the game, the shift register, the display and the
+	// second button can use
+	for (int i = 0; i < TOTAL_NUM_PINS && succeeded; i++) {
+		succeeded = makePin(PIN_IDS[i]);
+	}
+
+	for (int pinID : SHIFT_REGISTER_PIN_IDS) {
+		succeeded = succeeded && makePin(pinID);
+	}
+
+	for (int pinID : SEGMENT_PIN_IDS) {
+		succeeded = succeeded && makePin(pinID);
+	}
+
+	for (int pinID : DIGIT_PIN_IDS) {
+		succeeded = succeeded && makePin(pinID);
+	}
+
+	succeeded = succeeded && makePin(SECOND_BUTTON_PIN_ID);
+
+	if (!succeeded) {
+		sysLog.sysLog << "[StandInTree::enter] " <<
+			"ERROR: Pins could not be created in " << directoryName << endl;
+		cerr << "[StandInTree::enter] ERROR: Could not build a stand-in " <<
+			"GPIO tree" << endl;
+
+		leave();
+
+		return false;
+	}
+
+	sysLog.sysLog << "[StandInTree::enter] " <<
+		"Working in a stand-in GPIO tree in " << directoryName << endl;
+
+	return true;
+}
+
+// Go back to the directory the tree was entered from and remove the tree
+void StandInTree::leave () {
+	if (previousDirectory >= 0) {
+		if (fchdir(previousDirectory) != 0) {
+			sysLog.sysLog << "[StandInTree::leave] " <<
+				"ERROR: Could not return to the working directory" << endl;
+		}
+
+		close(previousDirectory);
+		previousDirectory = -1;
+	}
+
+	if (directoryName[0] != '\0') {
+		nftw(directoryName, removeStandInFile, 16, FTW_DEPTH | FTW_PHYS);
+		directoryName[0] = '\0';
+	}
+}
+
+// Remove a file or directory of a stand-in tree, children first, as
+// nftw() visits them
+int removeStandInFile (const char* fileName, const struct stat*, int type,
+		struct FTW*) {
+	if (type == FTW_DP) {
+		rmdir(fileName);
+	} else {
+		unlink(fileName);
+	}
+
+	return 0;
+}
+
+// ---------- [Functions for the stand-in tree class end here] ---------- //
+
+
+
+// -------- [Functions for the shift register class begin here] -------- //
+
+// ShiftRegisterOutput constructor
+ShiftRegisterOutput::ShiftRegisterOutput () {
+	for (int pin = 0; pin < NUM_SHIFT_REGISTER_PINS; pin++) {
+		pins[pin] = NULL;
+		pinStates[pin] = false;
+	}
+
+	numLights = 0;
+	latchedStates = NULL;
+	hasLatched = false;
+	numFrames = 0;
+	numBitsShifted = 0;
+	numToggles = 0;
+	isQuiet = false;
+}
+
+// ShiftRegisterOutput deconstructor
+ShiftRegisterOutput::~ShiftRegisterOutput () {
+	close();
+}
+
+// Set the level of a pin, skipping the write if it already has it
+bool ShiftRegisterOutput::setPin (ShiftRegisterPin pin, bool isOn) {
+	if (pinStates[pin] == isOn) {
+		return true;
+	}
+
+	numToggles++;
+	pinStates[pin] = isOn;
+
+	return (isQuiet) ?
+		(pins[pin]->writeState(isOn)) : (pins[pin]->setState(isOn));
+}
+
+// Find the fewest bits which turn the latched frame into the given one.
+// Shifting k bits moves light i to light i + k, so k works if every light
+// from k on equals the latched light k places before it.
+int ShiftRegisterOutput::findShift (const bool* lightStates) {
+	if (!hasLatched) {
+		return numLights;
+	}
+
+	for (int shift = 0; shift < numLights; shift++) {
+		bool isMatch = true;
+
+		for (int i = shift; i < numLights && isMatch; i++) {
+			isMatch = lightStates[i] == latchedStates[i - shift];
+		}
+
+		if (isMatch) {
+			return shift;
+		}
+	}
+
+	return numLights;
+}
+
+// Export the data, clock and latch pins and set them up as outputs
+bool ShiftRegisterOutput::open (const int pinIDs[], int numLights) {
+	sysLog.sysLog << "[ShiftRegisterOutput::open] " <<
+		"Entered function" << endl;
+
+	// Check for invalid arguments
+	if (pinIDs == NULL || numLights <= 0 || numLights % 8 != 0 ||
+			numLights > MAX_SHIFT_REGISTER_LIGHTS) {
+		sysLog.sysLog << "[ShiftRegisterOutput::open] " <<
+			"ERROR: The chain must be a whole number of 8-bit registers" <<
+			endl;
+
+		return false;
+	}
+
+	close();
+
+	for (int pin = 0; pin < NUM_SHIFT_REGISTER_PINS; pin++) {
+		pins[pin] = exportPin(pinIDs[pin], false);
+		pinStates[pin] = false;
+
+		if (pins[pin] == NULL) {
+			close();
+
+			return false;
+		}
+	}
+
+	this->numLights = numLights;
+	latchedStates = new bool[numLights];
+	hasLatched = false;
+	numFrames = 0;
+	numBitsShifted = 0;
+	numToggles = 0;
+
+	sysLog.sysLog << "[ShiftRegisterOutput::open] " <<
+		"Driving " << numLights << " light(s) through " << numLights / 8 <<
+		" shift register(s)" << endl;
+
+	return true;
+}
+
+// Release the pins of the chain
+void ShiftRegisterOutput::close () {
+	for (int pin = 0; pin < NUM_SHIFT_REGISTER_PINS; pin++) {
+		if (pins[pin] != NULL) {
+			pins[pin]->deactivate();
+			delete pins[pin];
+			pins[pin] = NULL;
+		}
+	}
+
+	delete[] latchedStates;
+	latchedStates = NULL;
+	numLights = 0;
+	hasLatched = false;
+}
+
+// Shift in the bits of a frame which differ and latch it
+bool ShiftRegisterOutput::commit (const bool* lightStates) {
+	// Check for null pointer
+	if (lightStates == NULL || latchedStates == NULL) {
+		if (!isQuiet) {
+			sysLog.sysLog << "[ShiftRegisterOutput::commit] " <<
+				"ERROR: Output is not open" << endl;
+		}
+
+		return false;
+	}
+
+	int shift = findShift(lightStates);
+
+	if (shift == 0) {
+		return true;
+	}
+
+	bool succeeded = true;
+
+	// The first bit shifted in ends up furthest along the chain
+	for (int i = shift - 1; i >= 0 && succeeded; i--) {
+		succeeded = setPin(SHIFT_DATA, lightStates[i]) &&
+			setPin(SHIFT_CLOCK, true) && setPin(SHIFT_CLOCK, false);
+	}
+
+	succeeded = succeeded && setPin(SHIFT_LATCH, true) &&
+		setPin(SHIFT_LATCH, false);
+
+	numFrames++;
+	numBitsShifted += shift;
+
+	// Send the whole frame next time if the chain is in doubt
+	hasLatched = succeeded;
+
+	for (int i = 0; i < numLights; i++) {
+		latchedStates[i] = lightStates[i];
+	}
+
+	if (!succeeded && !isQuiet) {
+		sysLog.sysLog << "[ShiftRegisterOutput::commit] " <<
+			"ERROR: Frame could not be shifted out" << endl;
+	}
+
+	return succeeded;
+}
+
+// Write frames without logging while another thread owns the chain
+void ShiftRegisterOutput::setQuiet (bool isQuiet) {
+	this->isQuiet = isQuiet;
+}
+
+// Get the number of outputs in the chain
+int ShiftRegisterOutput::getNumLights () {
+	return numLights;
+}
+
+// Get the number of frames latched
+unsigned long long ShiftRegisterOutput::getNumFrames () {
+	return numFrames;
+}
+
+// Get the number of bits sent down the chain
+unsigned long long ShiftRegisterOutput::getNumBitsShifted () {
+	return numBitsShifted;
+}
+
+// Get the number of pin writes issued
+unsigned long long ShiftRegisterOutput::getNumToggles () {
+	return numToggles;
+}
+
+// --------- [Functions for the shift register class end here] --------- //
+
+
+
+// -------- [Functions for the light output class begin here] ---------- //
+
+// LightOutput constructor
+LightOutput::LightOutput () {
+	backend = OUTPUT_PLAIN_WRITES;
+	isOpen  = false;
+	ringFileDescriptor = -1;
+	submissionRing = NULL;
+	completionRing = NULL;
+	submissions    = NULL;
+	submissionRingLength = 0;
+	completionRingLength = 0;
+	submissionsLength    = 0;
+	usesRegisteredFiles  = false;
+	stateBuffers[0] = '0';
+	stateBuffers[1] = '1';
+	hasCommitted = false;
+	numCommits = 0;
+	numWrites  = 0;
+	isQuiet    = false;
+}
+
+// LightOutput deconstructor
+LightOutput::~LightOutput () {
+	close();
+}
+
+// Set up an io_uring instance with room for one frame
+bool LightOutput::setUpRing () {
+	io_uring_params parameters;
+
+	memset(&parameters, 0, sizeof(parameters));
+	ringFileDescriptor = syscall(__NR_io_uring_setup, OUTPUT_RING_ENTRIES,
+		&parameters);
+
+	// Check if the kernel supports io_uring
+	if (ringFileDescriptor < 0) {
+		sysLog.sysLog << "[LightOutput::setUpRing] " <<
+			"io_uring is not available: " << strerror(errno) << endl;
+
+		return false;
+	}
+
+	// Map the rings and the submission entries
+	submissionRingLength = parameters.sq_off.array +
+		parameters.sq_entries * sizeof(unsigned);
+	completionRingLength = parameters.cq_off.cqes +
+		parameters.cq_entries * sizeof(io_uring_cqe);
+	submissionsLength = parameters.sq_entries * sizeof(io_uring_sqe);
+
+	if (parameters.features & IORING_FEAT_SINGLE_MMAP) {
+		submissionRingLength = max(submissionRingLength, completionRingLength);
+		completionRingLength = submissionRingLength;
+	}
+
+	submissionRing = mmap(NULL, submissionRingLength, PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_POPULATE, ringFileDescriptor, IORING_OFF_SQ_RING);
+	completionRing = (parameters.features & IORING_FEAT_SINGLE_MMAP) ?
+		(submissionRing) :
+		(mmap(NULL, completionRingLength, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, ringFileDescriptor,
+			IORING_OFF_CQ_RING));
+	void* entries = mmap(NULL, submissionsLength, PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_POPULATE, ringFileDescriptor, IORING_OFF_SQES);
+
+	if (submissionRing == MAP_FAILED || completionRing == MAP_FAILED ||
+			entries == MAP_FAILED) {
+		sysLog.sysLog << "[LightOutput::setUpRing] " <<
+			"ERROR: io_uring could not be mapped" << endl;
+
+		submissionRing = (submissionRing == MAP_FAILED) ?
+			(NULL) : (submissionRing);
+		completionRing = (completionRing == MAP_FAILED) ?
+			(NULL) : (completionRing);
+		submissions = (entries == MAP_FAILED) ?
+			(NULL) : ((io_uring_sqe*) entries);
+		tearDownRing();
+
+		return false;
+	}
+
+	char* submissionBase = (char*) submissionRing;
+	char* completionBase = (char*) completionRing;
+
+	submissions     = (io_uring_sqe*) entries;
+	submissionTail  = (atomic<unsigned>*)
+		(submissionBase + parameters.sq_off.tail);
+	submissionMask  = (unsigned*) (submissionBase + parameters.sq_off.ring_mask);
+	submissionArray = (unsigned*) (submissionBase + parameters.sq_off.array);
+	completionHead  = (atomic<unsigned>*)
+		(completionBase + parameters.cq_off.head);
+	completionTail  = (atomic<unsigned>*)
+		(completionBase + parameters.cq_off.tail);
+	completionMask  = (unsigned*) (completionBase + parameters.cq_off.ring_mask);
+	completions     = (io_uring_cqe*) (completionBase + parameters.cq_off.cqes);
+
+	// Register the value files and the state buffer so the kernel does not
+	// look them up on every write
+	int fileDescriptors[TOTAL_NUM_LIGHTS];
+	iovec buffer = {stateBuffers, sizeof(stateBuffers)};
+
+	for (int i = 0; i < TOTAL_NUM_LIGHTS; i++) {
+		fileDescriptors[i] = systemPins[i]->getValueFileDescriptor();
+	}
+
+	usesRegisteredFiles =
+		syscall(__NR_io_uring_register, ringFileDescriptor,
+			IORING_REGISTER_FILES, fileDescriptors, TOTAL_NUM_LIGHTS) == 0 &&
+		syscall(__NR_io_uring_register, ringFileDescriptor,
+			IORING_REGISTER_BUFFERS, &buffer, 1) == 0;
+
+	sysLog.sysLog << "[LightOutput::setUpRing] " <<
+		"Set up io_uring with " << parameters.sq_entries << " entries" <<
+		((usesRegisteredFiles) ? (" and registered files") : ("")) << endl;
+
+	return true;
+}
+
+// Release the io_uring instance
+void LightOutput::tearDownRing () {
+	if (submissions != NULL) {
+		munmap(submissions, submissionsLength);
+		submissions = NULL;
+	}
+
+	if (completionRing != NULL && completionRing != submissionRing) {
+		munmap(completionRing, completionRingLength);
+	}
+
+	if (submissionRing != NULL) {
+		munmap(submissionRing, submissionRingLength);
+	}
+
+	submissionRing = NULL;
+	completionRing = NULL;
+
+	if (ringFileDescriptor >= 0) {
+		::close(ringFileDescriptor);
+		ringFileDescriptor = -1;
+	}
+
+	usesRegisteredFiles = false;
+}
+
+// Write the changed pins one at a time
+bool LightOutput::writePlain (const int pins[], int numPins,
+		const bool* states) {
+
+	for (int i = 0; i < numPins; i++) {
+		int pin = pins[i];
+
+		if (isQuiet) {
+			if (!systemPins[pin]->writeState(states[pin])) {
+				return false;
+			}
+		} else if (!systemPins[pin]->setState(states[pin])) {
+			sysLog.sysLog << "[LightOutput::writePlain] " <<
+				"ERROR: State of light at pin " << PIN_IDS[pin] <<
+				" could not be set" << endl;
+
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Shift out the lights of a frame, leaving the rest of the chain off
+bool LightOutput::writeShiftRegister (const bool* states) {
+	for (int i = 0; i < TOTAL_NUM_LIGHTS; i++) {
+		chainStates[i] = states[i];
+	}
+
+	return shiftRegister.commit(chainStates);
+}
+
+// Write the changed pins with a single io_uring_enter
+bool LightOutput::writeRing (const int pins[], int numPins,
+		const bool* states) {
+
+	unsigned tail = submissionTail->load(memory_order_relaxed);
+
+	// Queue one write for each changed pin
+	for (int i = 0; i < numPins; i++) {
+		int pin = pins[i];
+		unsigned index = tail & *submissionMask;
+		io_uring_sqe* entry = &submissions[index];
+
+		memset(entry, 0, sizeof(*entry));
+		entry->addr = (unsigned long long) &stateBuffers[states[pin]];
+		entry->len  = 1;
+		entry->off  = 0;
+		entry->user_data = pin;
+
+		if (usesRegisteredFiles) {
+			entry->opcode = IORING_OP_WRITE_FIXED;
+			entry->fd     = pin;
+			entry->flags  = IOSQE_FIXED_FILE;
+			entry->buf_index = 0;
+		} else {
+			entry->opcode = IORING_OP_WRITE;
+			entry->fd     = systemPins[pin]->getValueFileDescriptor();
+		}
+
+		submissionArray[index] = index;
+		tail++;
+	}
+
+	submissionTail->store(tail, memory_order_release);
+
+	// Submit the frame and wait for all of it to complete
+	int numSubmitted;
+
+	do {
+		numSubmitted = syscall(__NR_io_uring_enter, ringFileDescriptor,
+			numPins, numPins, IORING_ENTER_GETEVENTS, NULL, 0);
+	} while (numSubmitted < 0 && errno == EINTR);
+
+	if (numSubmitted != numPins) {
+		if (!isQuiet) {
+			sysLog.sysLog << "[LightOutput::writeRing] " <<
+				"ERROR: Frame could not be submitted: " << strerror(errno) <<
+				endl;
+		}
+
+		return false;
+	}
+
+	// Check every completion for errors
+	bool succeeded = true;
+	unsigned head = completionHead->load(memory_order_relaxed);
+	unsigned completedTail = completionTail->load(memory_order_acquire);
+
+	for (; head != completedTail; head++) {
+		io_uring_cqe* completion = &completions[head & *completionMask];
+
+		if (completion->res != 1 && !isQuiet) {
+			sysLog.sysLog << "[LightOutput::writeRing] " <<
+				"ERROR: State of light at pin " <<
+				PIN_IDS[completion->user_data] << " could not be set: " <<
+				((completion->res < 0) ?
+					(strerror(-completion->res)) : ("short write")) << endl;
+		}
+
+		if (completion->res != 1) {
+			succeeded = false;
+		}
+	}
+
+	completionHead->store(head, memory_order_release);
+
+	return succeeded;
+}
+
+// Set up writing to the light pins, falling back to plain writes if the
+// backend is not available
+bool LightOutput::open (OutputBackend backend) {
+	sysLog.sysLog << "[LightOutput::open] " <<
+		"Entered function" << endl;
+
+	close();
+
+	// Check that the pins are set up
+	for (int i = 0; i < TOTAL_NUM_LIGHTS; i++) {
+		if (systemPins[i] == NULL ||
+				systemPins[i]->getValueFileDescriptor() < 0) {
+			sysLog.sysLog << "[LightOutput::open] " <<
+				"ERROR: Value file of pin " << PIN_IDS[i] <<
+				" could not be opened" << endl;
+
+			return false;
+		}
+	}
+
+	this->backend = OUTPUT_PLAIN_WRITES;
+
+	if (backend == OUTPUT_IO_URING && setUpRing()) {
+		this->backend = OUTPUT_IO_URING;
+	}
+
+	// Show the lights on the first outputs of a shift register chain
+	if (backend == OUTPUT_SHIFT_REGISTER) {
+		if (shiftRegisterLength < TOTAL_NUM_LIGHTS ||
+				!shiftRegister.open(SHIFT_REGISTER_PIN_IDS, shiftRegisterLength)) {
+			sysLog.sysLog << "[LightOutput::open] " <<
+				"ERROR: Shift register chain could not be set up" << endl;
+
+			return false;
+		}
+
+		for (int i = 0; i < MAX_SHIFT_REGISTER_LIGHTS; i++) {
+			chainStates[i] = false;
+		}
+
+		this->backend = OUTPUT_SHIFT_REGISTER;
+	}
+
+	isOpen = true;
+	hasCommitted = false;
+
+	return true;
+}
+
+// Stop writing to the light pins
+void LightOutput::close () {
+	tearDownRing();
+
+	if (backend == OUTPUT_SHIFT_REGISTER) {
+		shiftRegister.close();
+	}
+
+	isOpen = false;
+	hasCommitted = false;
+}
+
+// Write the lights which differ from the last frame
+bool LightOutput::commit (const bool* lightStates) {
+	// Check for null pointer
+	if (lightStates == NULL || !isOpen) {
+		if (!isQuiet) {
+			sysLog.sysLog << "[LightOutput::commit] " <<
+				"ERROR: Output is not open" << endl;
+		}
+
+		return false;
+	}
+
+	bool frameStates[TOTAL_NUM_LIGHTS];
+	int changedPins[TOTAL_NUM_LIGHTS];
+	int numChanged = 0;
+
+	// Show stuck lights at the value they are stuck at
+	for (int i = 0; i < TOTAL_NUM_LIGHTS; i++) {
+		frameStates[i] = lightStates[i];
+		gpioFaults.holdsValue(PIN_IDS[i], frameStates[i]);
+
+		if (!hasCommitted || frameStates[i] != committedStates[i]) {
+			changedPins[numChanged] = i;
+			numChanged++;
+		}
+	}
+
+	numCommits++;
+
+	if (numChanged == 0) {
+		return true;
+	}
+
+	numWrites += numChanged;
+
+	bool succeeded;
+
+	// Let injected faults delay the frame or fail it on io_uring, whose
+	// writes do not go through GPIOHandler
+	if (backend == OUTPUT_IO_URING && !gpioFaults.inject(FAULT_WRITE)) {
+		if (!isQuiet) {
+			sysLog.sysLog << "[LightOutput::commit] " <<
+				"ERROR: Frame could not be written (injected EIO)" << endl;
+		}
+
+		succeeded = false;
+	} else if (backend == OUTPUT_SHIFT_REGISTER) {
+		succeeded = writeShiftRegister(frameStates);
+	} else if (backend == OUTPUT_IO_URING) {
+		succeeded = writeRing(changedPins, numChanged, frameStates);
+	} else {
+		succeeded = writePlain(changedPins, numChanged, frameStates);
+	}
+
+	// Write every pin next time if the pins are in doubt
+	hasCommitted = succeeded;
+
+	for (int i = 0; i < TOTAL_NUM_LIGHTS; i++) {
+		committedStates[i] = frameStates[i];
+	}
+
+	return succeeded;
+}
+
+// Write a frame given as a bitmask, with light 0 in bit 0
+bool LightOutput::commitMask (unsigned int lights) {
+	bool lightStates[TOTAL_NUM_LIGHTS];
+
+	for (int i = 0; i < TOTAL_NUM_LIGHTS; i++) {
+		lightStates[i] = (lights >> i) & 1;
+	}
+
+	return commit(lightStates);
+}
+
+// Write frames without logging while another thread, such as the
+// software PWM, owns the output
+void LightOutput::setQuiet (bool isQuiet) {
+	this->isQuiet = isQuiet;
+	shiftRegister.setQuiet(isQuiet);
+}
+
+// Forget the states last written so the next frame writes every pin
+void LightOutput::invalidate () {
+	hasCommitted = false;
+}
+
+// Get the backend in use
+OutputBackend LightOutput::getBackend () {
+	return backend;
+}
+
+// Get the number of frames committed
+unsigned long long LightOutput::getNumCommits () {
+	return numCommits;
+}
+
+// Get the number of pin writes issued
+unsigned long long LightOutput::getNumWrites () {
+	return numWrites;
+}
+
+// --------- [Functions for the light output class end here] ----------- //
+
+
+// -------- [Functions for the button waiter class begin here] --------- //
+
+// ButtonWaiter constructor
+ButtonWaiter::ButtonWaiter () {
+	button = NULL;
+	mode = WAKE_ON_INTERVAL;
+	fileDescriptor = -1;
+}
+
+// ButtonWaiter deconstructor
+ButtonWaiter::~ButtonWaiter () {
+	close();
+}
+
+// Consume the notification which ended a wait
+void ButtonWaiter::drain () {
+	char buffer[4096];
+
+	if (mode == WAKE_ON_EDGE) {
+		// Edges stay signalled until the value file is read again
+		if (lseek(fileDescriptor, 0, SEEK_SET) < 0 ||
+				read(fileDescriptor, buffer, sizeof(buffer)) < 0) {
+			return;
+		}
+	} else {
+		while (read(fileDescriptor, buffer, sizeof(buffer)) > 0) {
+		}
+	}
+}
+
+// Pick the cheapest way of waiting for the button
+bool ButtonWaiter::open (GPIOHandler* button) {
+	sysLog.sysLog << "[ButtonWaiter::open] " <<
+		"Entered function" << endl;
+
+	// Check for null pointer
+	if (button == NULL) {
+		sysLog.sysLog << "[ButtonWaiter::open] " <<
+			"ERROR: Null pointer found" << endl;
+
+		return false;
+	}
+
+	close();
+	this->button = button;
+
+	// Ask the kernel for an interrupt on the rising edge
+	if (button->setEdge("rising")) {
+		fileDescriptor = ::open(button->getValueFileName(),
+			O_RDONLY | O_CLOEXEC);
+
+		if (fileDescriptor >= 0) {
+			drain();
+			mode = WAKE_ON_EDGE;
+
+			sysLog.sysLog << "[ButtonWaiter::open] " <<
+				"Waking on the rising edge" << endl;
+
+			return true;
+		}
+	}
+
+	// Watch for writes to the pin directory instead
+	fileDescriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+	if (fileDescriptor >= 0 && inotify_add_watch(fileDescriptor,
+			button->getDirectoryName(), IN_CLOSE_WRITE | IN_MOVED_TO) >= 0) {
+		mode = WAKE_ON_INOTIFY;
+
+		sysLog.sysLog << "[ButtonWaiter::open] " <<
+			"Edges are not available - waking on inotify" << endl;
+
+		return true;
+	}
+
+	if (fileDescriptor >= 0) {
+		::close(fileDescriptor);
+		fileDescriptor = -1;
+	}
+
+	mode = WAKE_ON_INTERVAL;
+
+	sysLog.sysLog << "[ButtonWaiter::open] " <<
+		"Warning: Checking the button every " << BUTTON_RECHECK_INTERVAL <<
+		" ms" << endl;
+
+	return true;
+}
+
+// Stop waiting for the button
+void ButtonWaiter::close () {
+	if (fileDescriptor >= 0) {
+		::close(fileDescriptor);
+		fileDescriptor = -1;
+	}
+
+	mode = WAKE_ON_INTERVAL;
+}
+
+// Get the way the waiter finds out about changes
+ButtonWakeMode ButtonWaiter::getMode () {
+	return mode;
+}
+
+// Sleep until the button is pressed, the deadline passes or the command
+// file becomes readable. A deadline of INFINITY waits without a limit and
+// a command file of -1 is ignored.
+WakeReason ButtonWaiter::wait (double deadline, int commandFileDescriptor) {
+	// Check for a missing button
+	if (button == NULL) {
+		return WAKE_ERROR;
+	}
+
+	while (true) {
+		bool isOn = false;
+
+		// Check the button first, so a press before the wait is not missed
+		if (!button->getState(isOn)) {
+			return WAKE_ERROR;
+		}
+
+		if (isOn) {
+			return WAKE_PRESS;
+		}
+
+		double remaining = deadline - monotonicTime();
+
+		if (remaining <= 0) {
+			return WAKE_DEADLINE;
+		}
+
+		int timeout = (remaining > INT_MAX / 1000) ?
+			(-1) : ((int) ceil(remaining * 1000));
+
+		if (mode == WAKE_ON_INTERVAL &&
+				(timeout < 0 || timeout > BUTTON_RECHECK_INTERVAL)) {
+			timeout = BUTTON_RECHECK_INTERVAL;
+		}
+
+		pollfd events[2] = {
+			{fileDescriptor, (short) ((mode == WAKE_ON_EDGE) ?
+				(POLLPRI | POLLERR) : (POLLIN)), 0},
+			{commandFileDescriptor, POLLIN, 0}
+		};
+
+		if (poll(events, 2, timeout) < 0 && errno != EINTR) {
+			return WAKE_ERROR;
+		}
+
+		if (events[1].revents & POLLIN) {
+			return WAKE_COMMAND;
+		}
+
+		if (events[0].revents != 0) {
+			drain();
+		}
+	}
+}
+
+// --------- [Functions for the button waiter class end here] ---------- //
+
+
+// ------- [Functions for the dual button input class begin here] ------- //
+
+// DualButtonInput constructor
+DualButtonInput::DualButtonInput () {
+	exportedButton = NULL;
+	stopFileDescriptor = -1;
+	edgeFileDescriptor = -1;
+	isRunning = false;
+	numErrors = 0;
+
+	for (int player = 0; player < NUM_PLAYERS; player++) {
+		buttons[player] = NULL;
+		hasWaitingEdge[player] = false;
+		numEdges[player] = 0;
+	}
+}
+
+// DualButtonInput deconstructor
+DualButtonInput::~DualButtonInput () {
+	close();
+}
+
+// Stamp the rising edges of one player's button until stopped. This runs
+// on a thread of its own, so it does not log.
+void DualButtonInput::listen (int player) {
+	const unsigned long long EDGE = 1;
+
+	while (isRunning) {
+		WakeReason reason = waiters[player].wait(INFINITY, stopFileDescriptor);
+		double time = monotonicTime();
+
+		if (reason == WAKE_COMMAND) {
+			break;
+		}
+
+		if (reason == WAKE_ERROR) {
+			numErrors++;
+			sleepUntil(time + BUTTON_RECHECK_INTERVAL / 1000.0);
+
+			continue;
+		}
+
+		// Leave the edge for the game to collect
+		{
+			std::lock_guard<std::mutex> guard(edgeLock);
+
+			waitingEdges[player] = {player, time};
+			hasWaitingEdge[player] = true;
+		}
+
+		numEdges[player]++;
+
+		if (write(edgeFileDescriptor, &EDGE, sizeof(EDGE)) < 0) {
+			numErrors++;
+		}
+
+		// Wait for the button to be released before looking for the next
+		// edge
+		bool isOn = true;
+
+		while (isRunning && isOn) {
+			pollfd stop = {stopFileDescriptor, POLLIN, 0};
+
+			if (poll(&stop, 1, 1) != 0 ||
+					!buttons[player]->readState(isOn)) {
+				break;
+			}
+		}
+	}
+}
+
+// Start listening to the first button, which is already set up, and to
+// the button on the given pin, which is exported here
+bool DualButtonInput::open (GPIOHandler* firstButton, int secondPinID) {
+	sysLog.sysLog << "[DualButtonInput::open] " <<
+		"Entered function" << endl;
+
+	// Check for null pointer
+	if (firstButton == NULL) {
+		sysLog.sysLog << "[DualButtonInput::open] " <<
+			"ERROR: Null pointer found" << endl;
+
+		return false;
+	}
+
+	close();
+
+	exportedButton = exportPin(secondPinID, true);
+	buttons[0] = firstButton;
+	buttons[1] = exportedButton;
+
+	if (exportedButton == NULL) {
+		sysLog.sysLog << "[DualButtonInput::open] " <<
+			"ERROR: Second button could not be set up" << endl;
+
+		close();
+
+		return false;
+	}
+
+	for (int player = 0; player < NUM_PLAYERS; player++) {
+		// Build the path the listener reads before it starts
+		if (!waiters[player].open(buttons[player]) ||
+				buttons[player]->getValueFileName() == NULL) {
+			close();
+
+			return false;
+		}
+
+		if (waiters[player].getMode() == WAKE_ON_INTERVAL) {
+			sysLog.sysLog << "[DualButtonInput::open] " <<
+				"Warning: Presses of player " << player + 1 <<
+				" are only stamped to within " << BUTTON_RECHECK_INTERVAL <<
+				" ms" << endl;
+		}
+
+		hasWaitingEdge[player] = false;
+		numEdges[player] = 0;
+	}
+
+	stopFileDescriptor = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	edgeFileDescriptor = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+	if (stopFileDescriptor < 0 || edgeFileDescriptor < 0) {
+		sysLog.sysLog << "[DualButtonInput::open] " <<
+			"ERROR: Could not create eventfds" << endl;
+
+		close();
+
+		return false;
+	}
+
+	numErrors = 0;
+	isRunning = true;
+
+	for (int player = 0; player < NUM_PLAYERS; player++) {
+		listeners[player] = std::thread(&DualButtonInput::listen, this,
+			player);
+	}
+
+	sysLog.sysLog << "[DualButtonInput::open] " <<
+		"Listening to buttons on pins " << buttons[0]->getPinID() <<
+		" and " << buttons[1]->getPinID() << endl;
+
+	return true;
+}
+
+// Stop listening and release the pin exported for the second button
+void DualButtonInput::close () {
+	const unsigned long long STOP = 1;
+
+	if (isRunning) {
+		isRunning = false;
+
+		if (write(stopFileDescriptor, &STOP, sizeof(STOP)) < 0) {
+			sysLog.sysLog << "[DualButtonInput::close] " <<
+				"ERROR: Could not wake the listeners" << endl;
+		}
+
+		for (int player = 0; player < NUM_PLAYERS; player++) {
+			if (listeners[player].joinable()) {
+				listeners[player].join();
+			}
+		}
+
+		logStatistics();
+	}
+
+	for (int player = 0; player < NUM_PLAYERS; player++) {
+		waiters[player].close();
+		buttons[player] = NULL;
+	}
+
+	if (stopFileDescriptor >= 0) {
+		::close(stopFileDescriptor);
+		stopFileDescriptor = -1;
+	}
+
+	if (edgeFileDescriptor >= 0) {
+		::close(edgeFileDescriptor);
+		edgeFileDescriptor = -1;
+	}
+
+	if (exportedButton != NULL) {
+		exportedButton->deactivate();
+		delete exportedButton;
+		exportedButton = NULL;
+	}
+}
+
+// Determine whether the buttons are being listened to
+bool DualButtonInput::isOpen () {
+	return isRunning;
+}
+
+// Get the pin of a player's button, or NULL if it is not set up
+GPIOHandler* DualButtonInput::getButton (int player) {
+	if (player < 0 || player >= NUM_PLAYERS) {
+		return NULL;
+	}
+
+	return buttons[player];
+}
+
+// Get a file which is readable while edges are waiting to be collected
+int DualButtonInput::getEdgeFileDescriptor () {
+	return edgeFileDescriptor;
+}
+
+// Take the edges stamped since the last call, earliest first, returning
+// how many there were
+int DualButtonInput::collect (ButtonEdge edges[]) {
+	unsigned long long count;
+	int numCollected = 0;
+
+	// Check for null pointer
+	if (edges == NULL) {
+		return 0;
+	}
+
+	if (edgeFileDescriptor >= 0) {
+		while (read(edgeFileDescriptor, &count, sizeof(count)) > 0) {
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(edgeLock);
+
+		for (int player = 0; player < NUM_PLAYERS; player++) {
+			if (hasWaitingEdge[player]) {
+				edges[numCollected++] = waitingEdges[player];
+				hasWaitingEdge[player] = false;
+			}
+		}
+	}
+
+	// Order presses by when they happened, not by whose button is first
+	if (numCollected == NUM_PLAYERS && edges[1].time < edges[0].time) {
+		swap(edges[0], edges[1]);
+	}
+
+	return numCollected;
+}
+
+// Write the number of edges stamped on each button to the log
+void DualButtonInput::logStatistics () {
+	sysLog.sysLog << "[DualButtonInput::logStatistics] " <<
+		numEdges[0] << " and " << numEdges[1] << " edge(s) stamped, " <<
+		numErrors << " read error(s)" << endl;
+}
+
+// -------- [Functions for the dual button input class end here] -------- //
+
+
+// --------- [Functions for the software PWM class begin here] --------- //
+
+// SoftwarePWM constructor
+SoftwarePWM::SoftwarePWM () {
+	output = NULL;
+	carrierFrequency = 0;
+	trailDecay = 0;
+	isRunning = false;
+	targetLights = 0;
+	numRuns = 0;
+	numPeriods = 0;
+	numLatePeriods = 0;
+	numRebuilds = 0;
+	numErrors = 0;
+
+	for (int i = 0; i < TOTAL_NUM_LIGHTS; i++) {
+		brightness[i] = 0;
+		duties[i] = 0;
+	}
+}
+
+// SoftwarePWM deconstructor
+SoftwarePWM::~SoftwarePWM () {
+	stop();
+}
+
+// Play the schedule until stopped
+void SoftwarePWM::run () {
+	double periodTime = 1.0 / carrierFrequency;
+	double slotTime = periodTime / PWM_SLOTS;
+	double periodStart = monotonicTime();
+
+	while (isRunning) {
+		updateDuties();
+
+		// Commit each run once, at the time its first slot is due
+		for (int i = 0; i < numRuns; i++) {
+			sleepUntil(periodStart + schedule[i].startSlot * slotTime);
+
+			if (!output->commitMask(schedule[i].lights)) {
+				numErrors++;
+			}
+		}
+
+		numPeriods++;
+		periodStart += periodTime;
+
+		// Start over from now rather than rushing through missed periods
+		double currentTime = monotonicTime();
+
+		if (currentTime > periodStart + periodTime) {
+			numLatePeriods++;
+			periodStart = currentTime;
+		}
+	}
+}
+
+// Let lights which were turned off fade, and work out the schedule again
+// if any duty changed
+void SoftwarePWM::updateDuties () {
+	unsigned int lights = targetLights.load(memory_order_relaxed);
+	bool hasChanged = false;
+
+	for (int i = 0; i < TOTAL_NUM_LIGHTS; i++) {
+		brightness[i] = ((lights >> i) & 1) ?
+			(1) : (brightness[i] * trailDecay);
+
+		int duty = (int) (brightness[i] * PWM_SLOTS + 0.5f);
+
+		if (duty != duties[i]) {
+			duties[i] = duty;
+			hasChanged = true;
+		}
+	}
+
+	if (hasChanged || numRuns == 0) {
+		buildSchedule();
+	}
+}
+
+// Split a period into runs of slots in which the same lights are on
+void SoftwarePWM::buildSchedule () {
+	numRuns = 0;
+
+	for (int slot = 0; slot < PWM_SLOTS; slot++) {
+		unsigned int lights = 0;
+
+		for (int i = 0; i < TOTAL_NUM_LIGHTS; i++) {
+			if (slot < duties[i]) {
+				lights |= 1u << i;
+			}
+		}
+
+		if (numRuns == 0 || schedule[numRuns - 1].lights != lights) {
+			schedule[numRuns].lights = lights;
+			schedule[numRuns].startSlot = slot;
+			numRuns++;
+		}
+	}
+
+	numRebuilds++;
+}
+
+// Start dimming the lights of an open output. Lights which are turned off
+// fade to nothing over trailTime seconds, or at once if it is 0.
+bool SoftwarePWM::start (LightOutput* output, int carrierFrequency,
+		float trailTime) {
+	sysLog.sysLog << "[SoftwarePWM::start] " <<
+		"Entered function" << endl;
+
+	// Check for invalid arguments
+	if (output == NULL || carrierFrequency <= 0 || trailTime < 0) {
+		sysLog.sysLog << "[SoftwarePWM::start] " <<
+			"ERROR: Received invalid arguments" << endl;
+
+		return false;
+	}
+
+	stop();
+
+	this->output = output;
+	this->carrierFrequency = carrierFrequency;
+
+	// Fall to a single slot over the trail time
+	trailDecay = (trailTime > 0) ?
+		(powf(1.0f / PWM_SLOTS, 1.0f / (trailTime * carrierFrequency))) : (0);
+
+	numRuns = 0;
+	numPeriods = 0;
+	numLatePeriods = 0;
+	numRebuilds = 0;
+	numErrors = 0;
+	isRunning = true;
+
+	// The worker must not write to the log, which only the game writes
+	output->setQuiet(true);
+	worker = std::thread(&SoftwarePWM::run, this);
+
+	sysLog.sysLog << "[SoftwarePWM::start] " <<
+		"Dimming lights with a " << carrierFrequency << " Hz carrier" << endl;
+
+	return true;
+}
+
+// Stop dimming the lights, leaving them as the last slot left them
+void SoftwarePWM::stop () {
+	if (!worker.joinable()) {
+		return;
+	}
+
+	isRunning = false;
+	worker.join();
+	output->setQuiet(false);
+
+	sysLog.sysLog << "[SoftwarePWM::stop] " <<
+		"Played " << numPeriods << " period(s), " << numLatePeriods <<
+		" late, with " << numRebuilds << " schedule(s) and " << numErrors <<
+		" error(s)" << endl;
+}
+
+// Determine whether the lights are being dimmed
+bool SoftwarePWM::isStarted () {
+	return worker.joinable();
+}
+
+// Set which lights are on, from any thread
+void SoftwarePWM::setLights (const bool* lightStates) {
+	unsigned int lights = 0;
+
+	for (int i = 0; i < TOTAL_NUM_LIGHTS; i++) {
+		if (lightStates[i]) {
+			lights |= 1u << i;
+		}
+	}
+
+	targetLights.store(lights, memory_order_relaxed);
+}
+
+// Get the number of periods per second
+int SoftwarePWM::getCarrierFrequency () {
+	return carrierFrequency;
+}
+
+// Get the number of periods played
+unsigned long long SoftwarePWM::getNumPeriods () {
+	return numPeriods;
+}
+
+// Get the number of periods cut short by falling behind
+unsigned long long SoftwarePWM::getNumLatePeriods () {
+	return numLatePeriods;
+}
+
+// Get the number of schedules worked out
+unsigned long long SoftwarePWM::getNumRebuilds () {
+	return numRebuilds;
+}
+
+// Get the number of frames which could not be committed
+unsigned long long SoftwarePWM::getNumErrors () {
+	return numErrors;
+}
+
+// ---------- [Functions for the software PWM class end here] ---------- //
+
+
+// -------- [Functions for the segment display class begin here] ------- //
+
+// SegmentDisplay constructor
+SegmentDisplay::SegmentDisplay () {
+	for (int segment = 0; segment < NUM_SEGMENTS; segment++) {
+		segmentPins[segment] = NULL;
+		segmentStates[segment] = false;
+	}
+
+	for (int digit = 0; digit < DISPLAY_NUM_DIGITS; digit++) {
+		digitPins[digit] = NULL;
+	}
+
+	isRunning = false;
+	patterns = 0;
+	numRefreshes = 0;
+	numSkipped = 0;
+	numErrors = 0;
+	totalLateness = 0;
+	maxLateness = 0;
+
+	for (int i = 0; i <= DISPLAY_JITTER_BUCKETS; i++) {
+		latenessCounts[i] = 0;
+	}
+}
+
+// SegmentDisplay deconstructor
+SegmentDisplay::~SegmentDisplay () {
+	close();
+}
+
+// Light the next digit at each refresh deadline until closed
+void SegmentDisplay::run () {
+	double refreshTime = 1.0 / DISPLAY_REFRESH_RATE;
+	double deadline = monotonicTime();
+	int digit = 0;
+
+	while (isRunning) {
+		deadline += refreshTime;
+		sleepUntil(deadline);
+
+		double lateness = monotonicTime() - deadline;
+
+		// Start over from now rather than rushing through missed refreshes
+		if (lateness > refreshTime) {
+			numSkipped += (unsigned long long) (lateness / refreshTime);
+			deadline += floor(lateness / refreshTime) * refreshTime;
+		}
+
+		numRefreshes++;
+		totalLateness += lateness;
+		maxLateness = max(maxLateness, lateness);
+		latenessCounts[min((int) (lateness / DISPLAY_JITTER_BUCKET_TIME),
+			DISPLAY_JITTER_BUCKETS)]++;
+
+		// Turn off the lit digit before its neighbour's segments are set,
+		// so no digit shows the pattern of another. The pins are written
+		// with writeState, since this thread must not write to the log.
+		if (!digitPins[digit]->writeState(false)) {
+			numErrors++;
+		}
+
+		digit = (digit + 1) % DISPLAY_NUM_DIGITS;
+		showDigit(digit, (patterns.load(memory_order_relaxed) >> (8 * digit)) &
+			0xFF);
+	}
+
+	digitPins[digit]->writeState(false);
+}
+
+// Set the segments of a digit, only writing those which change, and light
+// the digit
+void SegmentDisplay::showDigit (int digit, unsigned char pattern) {
+	for (int segment = 0; segment < NUM_SEGMENTS; segment++) {
+		bool isOn = (pattern >> segment) & 1;
+
+		if (isOn != segmentStates[segment]) {
+			segmentStates[segment] = isOn;
+
+			if (!segmentPins[segment]->writeState(isOn)) {
+				numErrors++;
+			}
+		}
+	}
+
+	if (!digitPins[digit]->writeState(true)) {
+		numErrors++;
+	}
+}
+
+// Export the pins of the display and start refreshing it
+bool SegmentDisplay::open (const int segmentPinIDs[],
+		const int digitPinIDs[]) {
+	sysLog.sysLog << "[SegmentDisplay::open] " <<
+		"Entered function" << endl;
+
+	// Check for null pointers
+	if (segmentPinIDs == NULL || digitPinIDs == NULL) {
+		sysLog.sysLog << "[SegmentDisplay::open] " <<
+			"ERROR: Null pointer found" << endl;
+
+		return false;
+	}
+
+	close();
+
+	for (int segment = 0; segment < NUM_SEGMENTS; segment++) {
+		segmentPins[segment] = exportPin(segmentPinIDs[segment], false);
+		segmentStates[segment] = false;
+
+		if (segmentPins[segment] == NULL) {
+			close();
+
+			return false;
+		}
+	}
+
+	for (int digit = 0; digit < DISPLAY_NUM_DIGITS; digit++) {
+		digitPins[digit] = exportPin(digitPinIDs[digit], false);
+
+		if (digitPins[digit] == NULL) {
+			close();
+
+			return false;
+		}
+	}
+
+	numRefreshes = 0;
+	numSkipped = 0;
+	numErrors = 0;
+	totalLateness = 0;
+	maxLateness = 0;
+
+	for (int i = 0; i <= DISPLAY_JITTER_BUCKETS; i++) {
+		latenessCounts[i] = 0;
+	}
+
+	showScores(0, 0);
+	isRunning = true;
+	worker = std::thread(&SegmentDisplay::run, this);
+
+	sysLog.sysLog << "[SegmentDisplay::open] " <<
+		"Refreshing " << DISPLAY_NUM_DIGITS << " digit(s) at " <<
+		DISPLAY_REFRESH_RATE << " Hz" << endl;
+
+	return true;
+}
+
+// Stop refreshing the display and release its pins
+void SegmentDisplay::close () {
+	if (worker.joinable()) {
+		isRunning = false;
+		worker.join();
+		logJitter();
+	}
+
+	for (int segment = 0; segment < NUM_SEGMENTS; segment++) {
+		if (segmentPins[segment] != NULL) {
+			segmentPins[segment]->setState(false);
+			segmentPins[segment]->deactivate();
+			delete segmentPins[segment];
+			segmentPins[segment] = NULL;
+		}
+	}
+
+	for (int digit = 0; digit < DISPLAY_NUM_DIGITS; digit++) {
+		if (digitPins[digit] != NULL) {
+			digitPins[digit]->deactivate();
+			delete digitPins[digit];
+			digitPins[digit] = NULL;
+		}
+	}
+}
+
+// Determine whether the display is being refreshed
+bool SegmentDisplay::isOpen () {
+	return worker.joinable();
+}
+
+// Show the level on the first half of the digits and the high score on
+// the second half, from any thread
+void SegmentDisplay::showScores (int level, int highScore) {
+	const int DIGITS_PER_SCORE = DISPLAY_NUM_DIGITS / 2;
+	int scores[2] = {level, highScore};
+	unsigned int shownPatterns = 0;
+
+	for (int score = 0; score < 2; score++) {
+		int value = scores[score];
+		int limit = 1;
+
+		for (int i = 0; i < DIGITS_PER_SCORE; i++) {
+			limit *= 10;
+		}
+
+		// Fill every digit from the right, blanking leading zeros and
+		// showing dashes for scores which do not fit
+		for (int i = DIGITS_PER_SCORE - 1; i >= 0; i--) {
+			unsigned char pattern;
+
+			if (value < 0 || value >= limit) {
+				pattern = SEGMENT_DASH;
+			} else if (value == 0 && i < DIGITS_PER_SCORE - 1) {
+				pattern = SEGMENT_BLANK;
+			} else {
+				pattern = SEGMENT_PATTERNS[value % 10];
+			}
+
+			shownPatterns |= (unsigned int) pattern <<
+				(8 * (score * DIGITS_PER_SCORE + i));
+
+			if (value >= 0 && value < limit) {
+				value /= 10;
+			}
+		}
+	}
+
+	patterns.store(shownPatterns, memory_order_relaxed);
+}
+
+// Log how late the refreshes were
+void SegmentDisplay::logJitter () {
+	sysLog.sysLog << "[SegmentDisplay::logJitter] " <<
+		numRefreshes << " refresh(es), " << numSkipped << " skipped, " <<
+		numErrors << " error(s); lateness mean " <<
+		getMeanLateness() * 1e6 << " us, p50 " <<
+		getLatenessPercentile(0.5) * 1e6 << " us, p99 " <<
+		getLatenessPercentile(0.99) * 1e6 << " us, max " <<
+		getMaxLateness() * 1e6 << " us" << endl;
+}
+
+// Get the mean lateness of refreshes in seconds
+double SegmentDisplay::getMeanLateness () {
+	return (numRefreshes > 0) ? (totalLateness / numRefreshes) : (0);
+}
+
+// Get the latest a refresh has been in seconds
+double SegmentDisplay::getMaxLateness () {
+	return maxLateness;
+}
+
+// Get the lateness in seconds which the given fraction of refreshes were
+// within, rounded up to a whole bucket
+double SegmentDisplay::getLatenessPercentile (double fraction) {
+	unsigned long long target = (unsigned long long) (fraction * numRefreshes);
+	unsigned long long count = 0;
+
+	for (int i = 0; i < DISPLAY_JITTER_BUCKETS; i++) {
+		count += latenessCounts[i];
+
+		if (count > target) {
+			return (i + 1) * DISPLAY_JITTER_BUCKET_TIME;
+		}
+	}
+
+	return maxLateness;
+}
+
+// Get the number of digits shown
+unsigned long long SegmentDisplay::getNumRefreshes () {
+	return numRefreshes;
+}
+
+// Get the number of refreshes missed entirely
+unsigned long long SegmentDisplay::getNumSkipped () {
+	return numSkipped;
+}
+
+// --------- [Functions for the segment display class end here] -------- //
+
+
+// ------- [Functions for the animation player class begin here] ------- //
+
+// AnimationPlayer constructor
+AnimationPlayer::AnimationPlayer () {
+	animation = NULL;
+	isLooping = false;
+	showsFrames = false;
+	nextFrame = 0;
+	nextFrameTime = 0;
+	numFramesShown = 0;
+	numFramesSkipped = 0;
+}
+
+// Start playing an animation, with the first frame due at startTime
+void AnimationPlayer::start (const Animation* animation, double startTime,
+		bool isLooping, bool showsFrames) {
+	sysLog.sysLog << "[AnimationPlayer::start] " <<
+		"Playing " << ((animation != NULL) ? (animation->name) : ("nothing")) <<
+		endl;
+
+	// Animations which take no time cannot loop
+	this->animation = animation;
+	this->isLooping = isLooping && animation != NULL &&
+		animation->totalDuration > 0;
+	this->showsFrames = showsFrames;
+	nextFrame = 0;
+	nextFrameTime = startTime;
+	numFramesShown = 0;
+	numFramesSkipped = 0;
+}
+
+// Show the latest frame which is due, returning 1 while the animation is
+// playing, 0 once it has finished and -1 on errors
+int AnimationPlayer::step (double currentTime) {
+	if (animation == NULL) {
+		return 0;
+	}
+
+	int dueFrame = -1;
+
+	// Find the latest frame which is due, skipping any before it
+	while (currentTime >= nextFrameTime) {
+		if (nextFrame >= animation->numFrames) {
+			if (!isLooping) {
+				break;
+			}
+
+			nextFrame = 0;
+		}
+
+		if (dueFrame >= 0) {
+			numFramesSkipped++;
+		}
+
+		dueFrame = nextFrame;
+		nextFrameTime += animation->frames[nextFrame].duration;
+		nextFrame++;
+	}
+
+	if (dueFrame >= 0) {
+		numFramesShown++;
+
+		if (showsFrames &&
+				!updateLightStrip(animation->frames[dueFrame].lights)) {
+			sysLog.sysLog << "[AnimationPlayer::step] " <<
+				"ERROR: Frame could not be shown" << endl;
+
+			return -1;
+		}
+	}
+
+	// Finish once the last frame has been shown for its whole duration
+	if (nextFrame >= animation->numFrames && !isLooping &&
+			currentTime >= nextFrameTime) {
+		animation = NULL;
+
+		return 0;
+	}
+
+	return 1;
+}
+
+// Get the time at which the next frame is due
+double AnimationPlayer::getDeadline () {
+	return nextFrameTime;
+}
+
+// Get the number of frames shown since starting
+int AnimationPlayer::getNumFramesShown () {
+	return numFramesShown;
+}
+
+// Get the number of frames skipped for being late since starting
+int AnimationPlayer::getNumFramesSkipped () {
+	return numFramesSkipped;
+}
+
+// -------- [Functions for the animation player class end here] -------- //
+
+
+
+// --------- [Functions for the stats journal class begin here] -------- //
+
+// StatsJournal constructor
+StatsJournal::StatsJournal () {
+	fileDescriptor = -1;
+	nextSequence   = 1;
+	numRecords     = 0;
+	needsSync      = false;
+}
+
+// StatsJournal deconstructor
+StatsJournal::~StatsJournal () {
+	close();
+}
+
+// Compute the CRC-32 of a record, leaving out the checksum itself
+unsigned int StatsJournal::checksum (const JournalRecord& record) {
+	return computeChecksum((const char*) &record + sizeof(record.checksum),
+		sizeof(record) - sizeof(record.checksum));
+}
+
+// Apply the records written after the statistics file to the statistics,
+// cutting off a record which was only partly written
+bool StatsJournal::replay (Statistics* stats) {
+	JournalRecord record;
+	off_t validLength = 0;
+	int numApplied = 0;
+
+	numRecords = 0;
+
+	while (read(fileDescriptor, &record, sizeof(record)) ==
+			(ssize_t) sizeof(record)) {
+
+		// Stop at the first damaged record
+		if (record.checksum != checksum(record)) {
+			sysLog.sysLog << "[StatsJournal::replay] " <<
+				"WARNING: Damaged record after " << numRecords <<
+				" record(s)" << endl;
+
+			break;
+		}
+
+		validLength += sizeof(record);
+		numRecords++;
+
+		if (record.sequence >= nextSequence) {
+			nextSequence = record.sequence + 1;
+		}
+
+		// Skip records already in the statistics file
+		if (record.sequence <= stats->journalSequence) {
+			continue;
+		}
+
+		switch (record.type) {
+			case JOURNAL_PRESS:
+				stats->timesPressed++;
+				break;
+
+			case JOURNAL_LIFE_LOST:
+				stats->totalLivesLost++;
+				break;
+
+			case JOURNAL_HIGH_SCORE:
+				stats->highScore = max(stats->highScore, (int) record.value);
+				break;
+
+			case JOURNAL_PLAY_TIME:
+				stats->totalTimePlayed += record.value;
+				break;
+
+			case JOURNAL_PRECISION_HIGH_SCORE:
+				stats->precisionHighScore = max(stats->precisionHighScore,
+					(int) record.value);
+				break;
+		}
+
+		stats->journalSequence = record.sequence;
+		numApplied++;
+	}
+
+	// Drop whatever follows the last valid record
+	if (ftruncate(fileDescriptor, validLength) != 0 ||
+			lseek(fileDescriptor, validLength, SEEK_SET) != validLength) {
+		sysLog.sysLog << "[StatsJournal::replay] " <<
+			"ERROR: Could not truncate journal" << endl;
+
+		return false;
+	}
+
+	sysLog.sysLog << "[StatsJournal::replay] " <<
+		"Applied " << numApplied << " of " << numRecords <<
+		" journal record(s)" << endl;
+
+	return true;
+}
+
+// Load the statistics file and the journal, then open the journal for
+// appending
+bool StatsJournal::open (Statistics* stats, bool hasStats) {
+	sysLog.sysLog << "[StatsJournal::open] " <<
+		"Entered function" << endl;
+
+	// Check for null pointer
+	if (stats == NULL) {
+		sysLog.sysLog << "[StatsJournal::open] " <<
+			"ERROR: Received null pointer" << endl;
+
+		return false;
+	}
+
+	close();
+
+	// Statistics resumed from elsewhere only need the newer records
+	if (!hasStats && !readStats(stats)) {
+		sysLog.sysLog << "[StatsJournal::open] " <<
+			"WARNING: Could not read statistics from file" << endl;
+	}
+
+	nextSequence = stats->journalSequence + 1;
+	fileDescriptor = ::open(JOURNAL_FILE, O_RDWR | O_CREAT, 0644);
+
+	// Check if file could be opened
+	if (fileDescriptor < 0) {
+		sysLog.sysLog << "[StatsJournal::open] " <<
+			"ERROR: Journal file could not be opened" << endl;
+
+		return false;
+	}
+
+	return replay(stats);
+}
+
+// Close the journal file
+void StatsJournal::close () {
+	if (fileDescriptor >= 0) {
+		sync();
+		::close(fileDescriptor);
+		fileDescriptor = -1;
+	}
+}
+
+// Append a record to the journal
+bool StatsJournal::append (JournalRecordType type, float value) {
+	// Check if journal is open
+	if (fileDescriptor < 0) {
+		return false;
+	}
+
+	JournalRecord record;
+
+	memset(&record, 0, sizeof(record));
+	record.type     = type;
+	record.sequence = nextSequence;
+	record.value    = value;
+	record.checksum = checksum(record);
+
+	if (write(fileDescriptor, &record, sizeof(record)) !=
+			(ssize_t) sizeof(record)) {
+		sysLog.sysLog << "[StatsJournal::append] " <<
+			"ERROR: Could not write record " << nextSequence << endl;
+
+		return false;
+	}
+
+	nextSequence++;
+	numRecords++;
+	needsSync = true;
+
+	return true;
+}
+
+// Record a press of the button
+bool StatsJournal::recordPress () {
+	return append(JOURNAL_PRESS, 0);
+}
+
+// Record a lost life
+bool StatsJournal::recordLifeLost () {
+	return append(JOURNAL_LIFE_LOST, 0);
+}
+
+// Record a new high score
+bool StatsJournal::recordHighScore (int highScore) {
+	return append(JOURNAL_HIGH_SCORE, highScore);
+}
+
+// Record the length of a game
+bool StatsJournal::recordPlayTime (float seconds) {
+	return append(JOURNAL_PLAY_TIME, seconds);
+}
+
+// Record a new precision high score
+bool StatsJournal::recordPrecisionHighScore (int highScore) {
+	return append(JOURNAL_PRECISION_HIGH_SCORE, highScore);
+}
+
+// Make the records written so far survive a power cut
+bool StatsJournal::sync () {
+	if (fileDescriptor < 0 || !needsSync) {
+		return true;
+	}
+
+	needsSync = false;
+
+	if (fdatasync(fileDescriptor) != 0) {
+		sysLog.sysLog << "[StatsJournal::sync] " <<
+			"ERROR: Could not sync journal" << endl;
+
+		return false;
+	}
+
+	return true;
+}
+
+// Determine whether the journal has grown enough to be compacted
+bool StatsJournal::needsCompaction () {
+	return numRecords >= MAX_JOURNAL_RECORDS;
+}
+
+// Write the statistics file and empty the journal
+bool StatsJournal::compact (Statistics* stats) {
+	sysLog.sysLog << "[StatsJournal::compact] " <<
+		"Compacting " << numRecords << " journal record(s)" << endl;
+
+	// Check if journal is open
+	if (fileDescriptor < 0 || stats == NULL) {
+		sysLog.sysLog << "[StatsJournal::compact] " <<
+			"ERROR: Journal is not open" << endl;
+
+		return false;
+	}
+
+	// The statistics file covers every record written so far, so the
+	// records are skipped if a crash happens before they are removed
+	stats->journalSequence = nextSequence - 1;
+
+	if (!writeStats(stats)) {
+		sysLog.sysLog << "[StatsJournal::compact] " <<
+			"ERROR: Could not write statistics file" << endl;
+
+		return false;
+	}
+
+	if (ftruncate(fileDescriptor, 0) != 0 ||
+			lseek(fileDescriptor, 0, SEEK_SET) != 0) {
+		sysLog.sysLog << "[StatsJournal::compact] " <<
+			"ERROR: Could not truncate journal" << endl;
+
+		return false;
+	}
+
+	numRecords = 0;
+	needsSync  = true;
+
+	return sync();
+}
+
+// ---------- [Functions for the stats journal class end here] --------- //
+
+
+
+// ---------- [Functions for the Leaderboard class begin here] --------- //
+
+// Leaderboard constructor
+Leaderboard::Leaderboard () : generator(time(NULL)) {
+	fileDescriptor = -1;
+	isReadOnly     = false;
+	mappedLength   = 0;
+	header         = NULL;
+	records        = NULL;
+}
+
+// Leaderboard deconstructor
+Leaderboard::~Leaderboard () {
+	close();
+}
+
+// Map the given length of the file into memory
+bool Leaderboard::map (size_t length) {
+	void* mapping;
+
+	if (header == NULL) {
+		mapping = mmap(NULL, length,
+			(isReadOnly) ? (PROT_READ) : (PROT_READ | PROT_WRITE), MAP_SHARED,
+			fileDescriptor, 0);
+	} else {
+		mapping = mremap(header, mappedLength, length, MREMAP_MAYMOVE);
+	}
+
+	// Check if file could be mapped
+	if (mapping == MAP_FAILED) {
+		sysLog.sysLog << "[Leaderboard::map] " <<
+			"ERROR: Could not map " << length << " byte(s)" << endl;
+
+		return false;
+	}
+
+	header       = (LeaderboardHeader*) mapping;
+	records      = (LeaderboardRecord*) (header + 1);
+	mappedLength = length;
+
+	return true;
+}
+
+// Check that a mapped file's header describes records which fit in the
+// file, without reading the records
+bool Leaderboard::hasValidHeader (off_t fileSize) {
+	return header->magic == LEADERBOARD_MAGIC &&
+		header->version == LEADERBOARD_VERSION &&
+		header->capacity >= 0 && header->numRecords >= 0 &&
+		header->numRecords <= header->capacity &&
+		header->numLevels >= 1 && header->numLevels <= LEADERBOARD_LEVELS &&
+		fileSize >= (off_t) (sizeof(LeaderboardHeader) +
+			(size_t) header->capacity * sizeof(LeaderboardRecord));
+}
+
+// Double the number of records the file has room for
+bool Leaderboard::grow () {
+	int capacity = header->capacity * 2;
+	size_t length = sizeof(LeaderboardHeader) +
+		capacity * sizeof(LeaderboardRecord);
+
+	sysLog.sysLog << "[Leaderboard::grow] " <<
+		"Growing leaderboard to " << capacity << " record(s)" << endl;
+
+	if (ftruncate(fileDescriptor, length) != 0 || !map(length)) {
+		sysLog.sysLog << "[Leaderboard::grow] " <<
+			"ERROR: Could not grow leaderboard" << endl;
+
+		return false;
+	}
+
+	header->capacity = capacity;
+
+	return true;
+}
+
+// Determine whether a record ranks before another, with ties going to
+// the earlier session
+bool Leaderboard::ranksBefore (int first, int second) {
+	if (records[first].score != records[second].score) {
+		return records[first].score > records[second].score;
+	}
+
+	return first < second;
+}
+
+// Determine whether a link read from the file may be followed, which it
+// may if it points at a record in use that is linked into the level and
+// ranks after the record the link comes from (-1 for the front)
+bool Leaderboard::isValidLink (int from, int next, int level) {
+	if (next < 0) {
+		return next == -1;
+	}
+
+	return next < header->numRecords && records[next].numLevels > level &&
+		records[next].numLevels <= LEADERBOARD_LEVELS &&
+		(from < 0 || ranksBefore(from, next));
+}
+
+// Find the last record before the given one in each level, or -1 if the
+// record belongs at the front, returning false if a bad link was found
+bool Leaderboard::findPredecessors (int index, int predecessors[]) {
+	int current = -1;
+
+	for (int level = header->numLevels - 1; level >= 0; level--) {
+		int next = (current < 0) ?
+			(header->head[level]) : (records[current].next[level]);
+		int numSteps = 0;
+
+		// Check each link before following it. Links in ranking order
+		// cannot pass more records than there are.
+		while (true) {
+			if (!isValidLink(current, next, level) ||
+					++numSteps > header->numRecords + 1) {
+				return false;
+			}
+
+			if (next < 0 || next == index || !ranksBefore(next, index)) {
+				break;
+			}
+
+			current = next;
+			next = records[current].next[level];
+		}
+
+		predecessors[level] = current;
+	}
+
+	return true;
+}
+
+// Insert a record into the skip list, returning false if a bad link kept
+// it out
+bool Leaderboard::link (int index) {
+	LeaderboardRecord& record = records[index];
+	int predecessors[LEADERBOARD_LEVELS];
+
+	// Each level holds a quarter of the records in the level below
+	record.numLevels = 1;
+
+	while (record.numLevels < LEADERBOARD_LEVELS && generator() % 4 == 0) {
+		record.numLevels++;
+	}
+
+	while (header->numLevels < record.numLevels) {
+		header->head[header->numLevels] = -1;
+		header->numLevels++;
+	}
+
+	if (!findPredecessors(index, predecessors)) {
+		return false;
+	}
+
+	for (int level = 0; level < record.numLevels; level++) {
+		int& link = (predecessors[level] < 0) ?
+			(header->head[level]) : (records[predecessors[level]].next[level]);
+
+		record.next[level] = link;
+		link = index;
+	}
+
+	return true;
+}
+
+// Remove a record from the skip list, returning false if a bad link was
+// found on the way to it
+bool Leaderboard::unlink (int index) {
+	LeaderboardRecord& record = records[index];
+	int predecessors[LEADERBOARD_LEVELS];
+
+	if (record.numLevels < 1 || record.numLevels > header->numLevels ||
+			!findPredecessors(index, predecessors)) {
+		return false;
+	}
+
+	for (int level = 0; level < record.numLevels; level++) {
+		int& link = (predecessors[level] < 0) ?
+			(header->head[level]) : (records[predecessors[level]].next[level]);
+
+		if (link == index) {
+			link = record.next[level];
+		}
+	}
+
+	return true;
+}
+
+// Link every record into a new skip list. The records are a flat array
+// with no gaps, so this only needs the records' scores.
+void Leaderboard::rebuild () {
+	sysLog.sysLog << "[Leaderboard::rebuild] " <<
+		"Found a bad link - rebuilding the index of " << header->numRecords <<
+		" record(s)" << endl;
+
+	header->numLevels = 1;
+	header->head[0]   = -1;
+
+	for (int index = 0; index < header->numRecords; index++) {
+		link(index);
+	}
+}
+
+// Find the best scores by looking at every record, for a file opened for
+// reading whose links cannot be rebuilt
+int Leaderboard::scanTopScores (int numScores, LeaderboardRecord* output) {
+	vector<int> best;
+
+	for (int index = 0; index < header->numRecords; index++) {
+		int position = best.size();
+
+		while (position > 0 && ranksBefore(index, best[position - 1])) {
+			position--;
+		}
+
+		if (position < numScores) {
+			best.insert(best.begin() + position, index);
+
+			if ((int) best.size() > numScores) {
+				best.pop_back();
+			}
+		}
+	}
+
+	for (size_t i = 0; i < best.size(); i++) {
+		output[i] = records[best[i]];
+	}
+
+	return best.size();
+}
+
+// Open the leaderboard file, creating it if it does not exist
+bool Leaderboard::open (const char* fileName) {
+	sysLog.sysLog << "[Leaderboard::open] " <<
+		"Entered function" << endl;
+
+	close();
+
+	fileDescriptor = ::open(fileName, O_RDWR | O_CREAT, 0644);
+
+	// Check if file could be opened
+	if (fileDescriptor < 0) {
+		sysLog.sysLog << "[Leaderboard::open] " <<
+			"ERROR: Leaderboard file could not be opened" << endl;
+
+		return false;
+	}
+
+	struct stat fileStatus;
+
+	if (fstat(fileDescriptor, &fileStatus) != 0) {
+		close();
+
+		return false;
+	}
+
+	// Set up a new file
+	if (fileStatus.st_size == 0) {
+		size_t length = sizeof(LeaderboardHeader) +
+			INITIAL_LEADERBOARD_CAPACITY * sizeof(LeaderboardRecord);
+
+		if (ftruncate(fileDescriptor, length) != 0 || !map(length)) {
+			close();
+
+			return false;
+		}
+
+		header->magic      = LEADERBOARD_MAGIC;
+		header->version    = LEADERBOARD_VERSION;
+		header->numRecords = 0;
+		header->capacity   = INITIAL_LEADERBOARD_CAPACITY;
+		header->numLevels  = 1;
+		header->head[0]    = -1;
+
+		return true;
+	}
+
+	// Check the existing file's header before trusting it
+	if (fileStatus.st_size < (off_t) sizeof(LeaderboardHeader) ||
+			!map(fileStatus.st_size) || !hasValidHeader(fileStatus.st_size)) {
+		sysLog.sysLog << "[Leaderboard::open] " <<
+			"ERROR: \"" << fileName << "\" is not a valid leaderboard" << endl;
+
+		close();
+
+		return false;
+	}
+
+	sysLog.sysLog << "[Leaderboard::open] " <<
+		"Opened leaderboard with " << header->numRecords << " record(s)" <<
+		endl;
+
+	return true;
+}
+
+// Open an existing leaderboard file for reading only, without creating
+// or changing it
+bool Leaderboard::openReadOnly (const char* fileName) {
+	sysLog.sysLog << "[Leaderboard::openReadOnly] " <<
+		"Entered function" << endl;
+
+	close();
+
+	fileDescriptor = ::open(fileName, O_RDONLY);
+	isReadOnly     = true;
+
+	// Check if file could be opened
+	if (fileDescriptor < 0) {
+		sysLog.sysLog << "[Leaderboard::openReadOnly] " <<
+			"ERROR: Leaderboard file could not be opened" << endl;
+
+		close();
+
+		return false;
+	}
+
+	struct stat fileStatus;
+
+	// Check the file's header before trusting it
+	if (fstat(fileDescriptor, &fileStatus) != 0 ||
+			fileStatus.st_size < (off_t) sizeof(LeaderboardHeader) ||
+			!map(fileStatus.st_size) || !hasValidHeader(fileStatus.st_size)) {
+		sysLog.sysLog << "[Leaderboard::openReadOnly] " <<
+			"ERROR: \"" << fileName << "\" is not a valid leaderboard" << endl;
+
+		close();
+
+		return false;
+	}
+
+	return true;
+}
+
+// Write back and unmap the leaderboard
+void Leaderboard::close () {
+	if (header != NULL) {
+		if (!isReadOnly) {
+			msync(header, mappedLength, MS_SYNC);
+		}
+
+		munmap(header, mappedLength);
+		header  = NULL;
+		records = NULL;
+		mappedLength = 0;
+	}
+
+	if (fileDescriptor >= 0) {
+		::close(fileDescriptor);
+		fileDescriptor = -1;
+	}
+
+	isReadOnly = false;
+}
+
+// Determine whether the leaderboard is open
+bool Leaderboard::isOpen () {
+	return header != NULL;
+}
+
+// Add a record for a new session, returning its index or -1
+int Leaderboard::addSession (const char* playerName, long long startTime) {
+	// Check if leaderboard is open for writing
+	if (header == NULL || isReadOnly || playerName == NULL) {
+		return -1;
+	}
+
+	if (header->numRecords == header->capacity && !grow()) {
+		return -1;
+	}
+
+	int index = header->numRecords;
+	LeaderboardRecord& record = records[index];
+
+	memset(&record, 0, sizeof(record));
+	strncpy(record.playerName, playerName, MAX_PLAYER_NAME_LENGTH - 1);
+	record.score     = 0;
+	record.startTime = startTime;
+
+	header->numRecords++;
+
+	if (!link(index)) {
+		rebuild();
+	}
+
+	sysLog.sysLog << "[Leaderboard::addSession] " <<
+		"Added session " << index << " for \"" << record.playerName << "\"" <<
+		endl;
+
+	return index;
+}
+
+// Change the score of a session in place
+bool Leaderboard::updateScore (int index, int score) {
+	// Check for invalid record
+	if (header == NULL || isReadOnly || index < 0 ||
+			index >= header->numRecords) {
+		sysLog.sysLog << "[Leaderboard::updateScore] " <<
+			"ERROR: Received invalid record: " << index << endl;
+
+		return false;
+	}
+
+	if (records[index].score == score) {
+		return true;
+	}
+
+	bool wasUnlinked = unlink(index);
+
+	records[index].score = score;
+
+	if (!wasUnlinked || !link(index)) {
+		rebuild();
+	}
+
+	return true;
+}
+
+// Get the score of a session
+int Leaderboard::getScore (int index) {
+	// Check for invalid record
+	if (header == NULL || index < 0 || index >= header->numRecords) {
+		return -1;
+	}
+
+	return records[index].score;
+}
+
+// Copy out the best scores, returning how many there were
+int Leaderboard::getTopScores (int numScores, LeaderboardRecord* output) {
+	int numFound = 0;
+
+	if (header == NULL) {
+		return 0;
+	}
+
+	int previous = -1;
+	int index = header->head[0];
+
+	while (index != -1 && numFound < numScores) {
+		// Rebuild the index if a bad link was found, or look at every
+		// record if the file cannot be changed
+		if (!isValidLink(previous, index, 0)) {
+			if (isReadOnly) {
+				return scanTopScores(numScores, output);
+			}
+
+			rebuild();
+			numFound = 0;
+			previous = -1;
+			index = header->head[0];
+
+			continue;
+		}
+
+		output[numFound] = records[index];
+		numFound++;
+		previous = index;
+		index = records[index].next[0];
+	}
+
+	return numFound;
+}
+
+// Write the leaderboard back to the file
+void Leaderboard::sync () {
+	if (header != NULL && msync(header, mappedLength, MS_SYNC) != 0) {
+		sysLog.sysLog << "[Leaderboard::sync] " <<
+			"ERROR: Leaderboard could not be written back" << endl;
+	}
+}
+
+// Get the number of sessions in the leaderboard
+int Leaderboard::getNumRecords () {
+	return (header == NULL) ? (0) : (header->numRecords);
+}
+
+// ----------- [Functions for the Leaderboard class end here] ---------- //
+
+
+
+// -------- [Functions for the quantile sketch classes begin here] ------- //
+
+// QuantileSketch constructor
+QuantileSketch::QuantileSketch () {
+	count = 0;
+	randomState = 0x9E3779B9;
+}
+
+// Promote every other value of a full compactor to the one above
+void QuantileSketch::compact (int height) {
+	if (height + 1 == (int) compactors.size()) {
+		compactors.resize(height + 2);
+	}
+
+	vector<float>& values = compactors[height];
+	vector<float>& above  = compactors[height + 1];
+
+	sort(values.begin(), values.end());
+
+	// Pick the even or odd values at random so the error cancels out
+	randomState ^= randomState << 13;
+	randomState ^= randomState >> 17;
+	randomState ^= randomState << 5;
+
+	// An odd value out stays behind
+	size_t numPaired = values.size() & ~((size_t) 1);
+
+	for (size_t i = randomState & 1; i < numPaired; i += 2) {
+		above.push_back(values[i]);
+	}
+
+	if (numPaired < values.size()) {
+		values[0] = values.back();
+		values.resize(1);
+	} else {
+		values.clear();
+	}
+
+	if ((int) above.size() >= SKETCH_CAPACITY) {
+		compact(height + 1);
+	}
+}
+
+// Add a value to the sketch
+void QuantileSketch::add (float value) {
+	if (compactors.empty()) {
+		compactors.resize(1);
+	}
+
+	compactors[0].push_back(value);
+	count++;
+
+	if ((int) compactors[0].size() >= SKETCH_CAPACITY) {
+		compact(0);
+	}
+}
+
+// Add the values of another sketch to this one
+void QuantileSketch::merge (const QuantileSketch& other) {
+	if (compactors.size() < other.compactors.size()) {
+		compactors.resize(other.compactors.size());
+	}
+
+	for (size_t height = 0; height < other.compactors.size(); height++) {
+		compactors[height].insert(compactors[height].end(),
+			other.compactors[height].begin(), other.compactors[height].end());
+	}
+
+	count += other.count;
+
+	for (size_t height = 0; height < compactors.size(); height++) {
+		if ((int) compactors[height].size() >= SKETCH_CAPACITY) {
+			compact(height);
+		}
+	}
+}
+
+// Estimate the value below which the given fraction of values fall
+float QuantileSketch::quantile (double fraction) const {
+	vector< pair<float, unsigned long long> > weighted;
+	unsigned long long totalWeight = 0;
+
+	for (size_t height = 0; height < compactors.size(); height++) {
+		for (size_t i = 0; i < compactors[height].size(); i++) {
+			weighted.push_back(make_pair(compactors[height][i],
+				1ULL << height));
+			totalWeight += 1ULL << height;
+		}
+	}
+
+	if (weighted.empty()) {
+		return NAN;
+	}
+
+	sort(weighted.begin(), weighted.end());
+
+	unsigned long long cumulativeWeight = 0;
+
+	for (size_t i = 0; i < weighted.size(); i++) {
+		cumulativeWeight += weighted[i].second;
+
+		if (cumulativeWeight >= fraction * totalWeight) {
+			return weighted[i].first;
+		}
+	}
+
+	return weighted.back().first;
+}
+
+// Get the number of values added to the sketch
+unsigned long long QuantileSketch::getCount () const {
+	return count;
+}
+
+// Write one line for each compactor which holds values
+bool QuantileSketch::write (ostream& output, int level, int direction) const {
+	for (size_t height = 0; height < compactors.size(); height++) {
+		const vector<float>& values = compactors[height];
+
+		if (values.empty()) {
+			continue;
+		}
+
+		output << level << ' ' << direction << ' ' << height << ' ' <<
+			values.size();
+
+		for (size_t i = 0; i < values.size(); i++) {
+			output << ' ' << values[i];
+		}
+
+		output << '\n';
+	}
+
+	return output.good();
+}
+
+// Read the values of one compactor written by write
+bool QuantileSketch::readCompactor (istream& input, int height,
+		int numValues) {
+
+	// Check for invalid compactor
+	if (height < 0 || height >= MAX_SKETCH_HEIGHT || numValues < 0) {
+		return false;
+	}
+
+	if ((int) compactors.size() <= height) {
+		compactors.resize(height + 1);
+	}
+
+	for (int i = 0; i < numValues; i++) {
+		float value;
+
+		if (!(input >> value)) {
+			return false;
+		}
+
+		compactors[height].push_back(value);
+		count += 1ULL << height;
+	}
+
+	if ((int) compactors[height].size() >= SKETCH_CAPACITY) {
+		compact(height);
+	}
+
+	return true;
+}
+
+// Record how early (negative) or late (positive) a press was
+void ReactionSketches::recordPress (int level, bool isMovingRight,
+		float error) {
+
+	// Levels past the last sketch share it
+	level = max(0, min(level, MAX_SKETCH_LEVELS - 1));
+
+	sketches[level][isMovingRight].add(error);
+}
+
+// Add the presses of other sketches to these
+void ReactionSketches::merge (const ReactionSketches& other) {
+	for (int level = 0; level < MAX_SKETCH_LEVELS; level++) {
+		for (int direction = 0; direction < 2; direction++) {
+			sketches[level][direction].merge(other.sketches[level][direction]);
+		}
+	}
+}
+
+// Add the presses in a sketch file to these
+bool ReactionSketches::read (const char* fileName) {
+	ifstream sketchFile(fileName);
+
+	// Check if file could be opened
+	if (!sketchFile.is_open()) {
+		sysLog.sysLog << "[ReactionSketches::read] " <<
+			"Warning: \"" << fileName << "\" could not be opened" << endl;
+
+		return false;
+	}
+
+	int level;
+	int direction;
+	int height;
+	int numValues;
+
+	while (sketchFile >> level >> direction >> height >> numValues) {
+		// Check for invalid lines
+		if (level < 0 || level >= MAX_SKETCH_LEVELS ||
+				direction < 0 || direction > 1 ||
+				!sketches[level][direction].readCompactor(sketchFile, height,
+					numValues)) {
+			sysLog.sysLog << "[ReactionSketches::read] " <<
+				"ERROR: \"" << fileName << "\" is corrupted" << endl;
+
+			return false;
+		}
+	}
+
+	return sketchFile.eof();
+}
+
+// Write the sketches to a file, replacing it atomically
+bool ReactionSketches::write (const char* fileName) {
+	string tempFileName = string(fileName) + ".tmp";
+	ofstream sketchFile(tempFileName.c_str());
+
+	// Check if file could be opened
+	if (!sketchFile.is_open()) {
+		sysLog.sysLog << "[ReactionSketches::write] " <<
+			"ERROR: \"" << tempFileName << "\" could not be opened" << endl;
+
+		return false;
+	}
+
+	// Floats written with 9 significant digits read back exactly
+	sketchFile.precision(9);
+
+	for (int level = 0; level < MAX_SKETCH_LEVELS; level++) {
+		for (int direction = 0; direction < 2; direction++) {
+			sketches[level][direction].write(sketchFile, level, direction);
+		}
+	}
+
+	sketchFile.close();
+
+	// Make the new file durable before it replaces the old one
+	int fileDescriptor = open(tempFileName.c_str(), O_RDONLY);
+	bool isDurable = (fileDescriptor >= 0 && fsync(fileDescriptor) == 0);
+
+	if (fileDescriptor >= 0) {
+		close(fileDescriptor);
+	}
+
+	if (sketchFile.fail() || !isDurable ||
+			rename(tempFileName.c_str(), fileName) != 0) {
+		sysLog.sysLog << "[ReactionSketches::write] " <<
+			"ERROR: \"" << fileName << "\" could not be written" << endl;
+
+		return false;
+	}
+
+	return true;
+}
+
+// Print the spread of press timing for each level and direction
+void ReactionSketches::report (ostream& output) {
+	const char* directionNames[2] = {"left", "right"};
+
+	output << "level,direction,presses,p10,p50,p90" << endl;
+
+	for (int level = 0; level < MAX_SKETCH_LEVELS; level++) {
+		for (int direction = 0; direction < 2; direction++) {
+			const QuantileSketch& sketch = sketches[level][direction];
+
+			if (sketch.getCount() == 0) {
+				continue;
+			}
+
+			output << level <<
+				((level == MAX_SKETCH_LEVELS - 1) ? ("+") : ("")) << ',' <<
+				directionNames[direction] << ',' << sketch.getCount() << ',' <<
+				sketch.quantile(0.1) << ',' << sketch.quantile(0.5) << ',' <<
+				sketch.quantile(0.9) << endl;
+		}
+	}
+}
+
+// --------- [Functions for the quantile sketch classes end here] -------- //
+
+
+
+// ------- [Functions for the session history class begin here] -------- //
+
+// SessionHistory constructor
+SessionHistory::SessionHistory () {
+	fileDescriptor = -1;
+	numBlocks = 0;
+	memset(&tail, 0, sizeof(tail));
+}
+
+// SessionHistory deconstructor
+SessionHistory::~SessionHistory () {
+	close();
+}
+
+// Get the position of a block in the file
+off_t SessionHistory::blockOffset (int block) {
+	return (off_t) block * (sizeof(HistoryBlockHeader) +
+		(off_t) NUM_HISTORY_COLUMNS * HISTORY_BLOCK_ROWS * sizeof(double));
+}
+
+// Get the position of a value in the file
+off_t SessionHistory::valueOffset (int block, int column, int row) {
+	return blockOffset(block) + sizeof(HistoryBlockHeader) +
+		((off_t) column * HISTORY_BLOCK_ROWS + row) * sizeof(double);
+}
+
+// Add an empty block to the end of the file
+bool SessionHistory::startBlock () {
+	memset(&tail, 0, sizeof(tail));
+	tail.magic = HISTORY_MAGIC;
+
+	// Columns with no values have an empty range
+	for (int column = 0; column < NUM_HISTORY_COLUMNS; column++) {
+		tail.minimum[column] = NAN;
+		tail.maximum[column] = NAN;
+	}
+
+	if (ftruncate(fileDescriptor, blockOffset(numBlocks + 1)) != 0 ||
+			pwrite(fileDescriptor, &tail, sizeof(tail),
+				blockOffset(numBlocks)) != sizeof(tail)) {
+		sysLog.sysLog << "[SessionHistory::startBlock] " <<
+			"ERROR: Block could not be added" << endl;
+
+		return false;
+	}
+
+	numBlocks++;
+
+	return true;
+}
+
+// Open the history file, creating it if it may be written
+bool SessionHistory::open (const char* fileName, bool isWritable) {
+	sysLog.sysLog << "[SessionHistory::open] " <<
+		"Entered function" << endl;
+
+	close();
+
+	fileDescriptor = (isWritable) ?
+		(::open(fileName, O_RDWR | O_CREAT, 0644)) :
+		(::open(fileName, O_RDONLY));
+
+	// Check if file could be opened
+	if (fileDescriptor < 0) {
+		sysLog.sysLog << "[SessionHistory::open] " <<
+			"ERROR: \"" << fileName << "\" could not be opened" << endl;
+
+		return false;
+	}
+
+	// Blocks are only ever added whole
+	off_t fileSize = lseek(fileDescriptor, 0, SEEK_END);
+	numBlocks = fileSize / blockOffset(1);
+
+	if (numBlocks > 0 && !readHeader(numBlocks - 1, &tail)) {
+		sysLog.sysLog << "[SessionHistory::open] " <<
+			"ERROR: \"" << fileName << "\" is not a session history" << endl;
+
+		close();
+
+		return false;
+	}
+
+	sysLog.sysLog << "[SessionHistory::open] " <<
+		"Opened session history with " << numBlocks << " block(s)" << endl;
+
+	return true;
+}
+
+// Close the history file
+void SessionHistory::close () {
+	if (fileDescriptor >= 0) {
+		::close(fileDescriptor);
+		fileDescriptor = -1;
+	}
+
+	numBlocks = 0;
+}
+
+// Add the record of a session to the end of the history
+bool SessionHistory::append (const SessionRecord& record) {
+	// Check if history is open
+	if (fileDescriptor < 0) {
+		return false;
+	}
+
+	if ((numBlocks == 0 || tail.numRows == HISTORY_BLOCK_ROWS) &&
+			!startBlock()) {
+		return false;
+	}
+
+	double values[NUM_HISTORY_COLUMNS];
+
+	values[HISTORY_START_TIME] = record.startTime;
+	values[HISTORY_DURATION]   = record.duration;
+	values[HISTORY_LEVEL]      = record.level;
+	values[HISTORY_PRESSES]    = record.presses;
+	values[HISTORY_LIVES_LOST] = record.livesLost;
+
+	for (int level = 0; level < MAX_HISTORY_LEVELS; level++) {
+		values[HISTORY_TIME_PER_LIGHT + level] = record.timePerLight[level];
+	}
+
+	// Write the values before the header which counts them, so a crash
+	// leaves the block as it was
+	int row = tail.numRows;
+	int block = numBlocks - 1;
+
+	for (int column = 0; column < NUM_HISTORY_COLUMNS; column++) {
+		if (pwrite(fileDescriptor, &values[column], sizeof(double),
+				valueOffset(block, column, row)) != sizeof(double)) {
+			sysLog.sysLog << "[SessionHistory::append] " <<
+				"ERROR: Session could not be written" << endl;
+
+			return false;
+		}
+
+		// Unreached levels do not widen the range
+		if (isnan(values[column])) {
+			continue;
+		}
+
+		if (isnan(tail.minimum[column]) ||
+				values[column] < tail.minimum[column]) {
+			tail.minimum[column] = values[column];
+		}
+
+		if (isnan(tail.maximum[column]) ||
+				values[column] > tail.maximum[column]) {
+			tail.maximum[column] = values[column];
+		}
+	}
+
+	tail.numRows++;
+
+	if (pwrite(fileDescriptor, &tail, sizeof(tail), blockOffset(block)) !=
+			sizeof(tail) || fdatasync(fileDescriptor) != 0) {
+		sysLog.sysLog << "[SessionHistory::append] " <<
+			"ERROR: Block header could not be written" << endl;
+
+		return false;
+	}
+
+	return true;
+}
+
+// Get the number of blocks in the history
+int SessionHistory::getNumBlocks () {
+	return numBlocks;
+}
+
+// Read the header of a block
+bool SessionHistory::readHeader (int block, HistoryBlockHeader* header) {
+	// Check for invalid arguments
+	if (header == NULL || block < 0 || block >= numBlocks) {
+		return false;
+	}
+
+	return pread(fileDescriptor, header, sizeof(*header),
+			blockOffset(block)) == sizeof(*header) &&
+		header->magic == HISTORY_MAGIC &&
+		header->numRows <= (unsigned int) HISTORY_BLOCK_ROWS;
+}
+
+// Read the first numRows values of one column of a block
+bool SessionHistory::readColumn (int block, int column, int numRows,
+		double* values) {
+
+	// Check for invalid arguments
+	if (values == NULL || block < 0 || block >= numBlocks || column < 0 ||
+			column >= NUM_HISTORY_COLUMNS || numRows < 0 ||
+			numRows > HISTORY_BLOCK_ROWS) {
+		return false;
+	}
+
+	ssize_t length = numRows * sizeof(double);
+
+	return pread(fileDescriptor, values, length,
+		valueOffset(block, column, 0)) == length;
+}
+
+// -------- [Functions for the session history class end here] --------- //
+
+
+
+// --------- [Functions for the shared state class begin here] --------- //
+
+// SharedState constructor
+SharedState::SharedState () {
+	state = NULL;
+	isWriter = false;
+}
+
+// SharedState deconstructor
+SharedState::~SharedState () {
+	close();
+}
+
+// Make the sequence odd so readers retry
+void SharedState::beginWrite () {
+	state->sequence.store(state->sequence.load(memory_order_relaxed) + 1,
+		memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+}
+
+// Make the sequence even so readers accept what was written
+void SharedState::endWrite () {
+	state->sequence.store(state->sequence.load(memory_order_relaxed) + 1,
+		memory_order_release);
+}
+
+// Create the shared segment for the game to write
+bool SharedState::create (const char* name) {
+	sysLog.sysLog << "[SharedState::create] " <<
+		"Entered function" << endl;
+
+	close();
+
+	int fileDescriptor = shm_open(name, O_RDWR | O_CREAT, 0644);
+
+	// Check if segment could be opened
+	if (fileDescriptor < 0 ||
+			ftruncate(fileDescriptor, sizeof(SharedGameState)) != 0) {
+		sysLog.sysLog << "[SharedState::create] " <<
+			"ERROR: Shared memory could not be created" << endl;
+
+		if (fileDescriptor >= 0) {
+			::close(fileDescriptor);
+		}
+
+		return false;
+	}
+
+	void* mapping = mmap(NULL, sizeof(SharedGameState),
+		PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0);
+
+	::close(fileDescriptor);
+
+	if (mapping == MAP_FAILED) {
+		sysLog.sysLog << "[SharedState::create] " <<
+			"ERROR: Shared memory could not be mapped" << endl;
+
+		return false;
+	}
+
+	// Keep the sequence of an earlier run so readers see a change
+	state = (SharedGameState*) mapping;
+	isWriter = true;
+
+	beginWrite();
+	state->isPlaying.store(0, memory_order_relaxed);
+	state->numTopScores.store(0, memory_order_relaxed);
+	endWrite();
+
+	state->magic.store(SHARED_STATE_MAGIC, memory_order_release);
+
+	return true;
+}
+
+// Attach to the shared segment of a running game as a reader
+bool SharedState::attach (const char* name) {
+	close();
+
+	int fileDescriptor = shm_open(name, O_RDONLY, 0);
+
+	// Check if segment could be opened
+	if (fileDescriptor < 0) {
+		return false;
+	}
+
+	struct stat segmentStatus;
+	void* mapping = MAP_FAILED;
+
+	if (fstat(fileDescriptor, &segmentStatus) == 0 &&
+			segmentStatus.st_size >= (off_t) sizeof(SharedGameState)) {
+		mapping = mmap(NULL, sizeof(SharedGameState), PROT_READ, MAP_SHARED,
+			fileDescriptor, 0);
+	}
+
+	::close(fileDescriptor);
+
+	if (mapping == MAP_FAILED) {
+		return false;
+	}
+
+	state = (SharedGameState*) mapping;
+	isWriter = false;
+
+	// Check that the game has set up the segment
+	if (state->magic.load(memory_order_acquire) != SHARED_STATE_MAGIC) {
+		close();
+
+		return false;
+	}
+
+	return true;
+}
+
+// Unmap the shared segment, marking it idle if this process writes it
+void SharedState::close () {
+	if (state == NULL) {
+		return;
+	}
+
+	if (isWriter) {
+		beginWrite();
+		state->isPlaying.store(0, memory_order_relaxed);
+		endWrite();
+	}
+
+	munmap(state, sizeof(SharedGameState));
+	state = NULL;
+}
+
+// Copy the state of the game into the shared segment
+void SharedState::publish (Statistics* stats, GameData* game,
+		bool isPlaying) {
+
+	// Check for null pointers
+	if (state == NULL || !isWriter || stats == NULL || game == NULL) {
+		return;
+	}
+
+	beginWrite();
+	state->isPlaying.store(isPlaying, memory_order_relaxed);
+	state->currentLevel.store(game->currentLevel, memory_order_relaxed);
+	state->numLivesRemaining.store(game->numLivesRemaining,
+		memory_order_relaxed);
+	state->currentLightPosition.store(game->currentLightPosition,
+		memory_order_relaxed);
+	state->isMovingRight.store(game->isMovingRight, memory_order_relaxed);
+	state->highScore.store(stats->highScore, memory_order_relaxed);
+	state->timesPressed.store(stats->timesPressed, memory_order_relaxed);
+	state->totalLivesLost.store(stats->totalLivesLost, memory_order_relaxed);
+	state->totalTimePlayed.store(stats->totalTimePlayed,
+		memory_order_relaxed);
+	endWrite();
+}
+
+// Copy the best scores of the leaderboard into the shared segment
+void SharedState::publishLeaderboard (Leaderboard* board) {
+	// Check for null pointers
+	if (state == NULL || !isWriter || board == NULL) {
+		return;
+	}
+
+	LeaderboardRecord topScores[SHARED_TOP_SCORES];
+	int numTopScores = board->getTopScores(SHARED_TOP_SCORES, topScores);
+
+	beginWrite();
+
+	for (int i = 0; i < numTopScores; i++) {
+		for (int j = 0; j < MAX_PLAYER_NAME_LENGTH; j++) {
+			state->topScores[i].playerName[j].store(
+				topScores[i].playerName[j], memory_order_relaxed);
+		}
+
+		state->topScores[i].score.store(topScores[i].score,
+			memory_order_relaxed);
+	}
+
+	state->numTopScores.store(numTopScores, memory_order_relaxed);
+	endWrite();
+}
+
+// Take a consistent copy of the shared segment
+bool SharedState::snapshot (SharedGameSnapshot* output) {
+	// Check for null pointers
+	if (state == NULL || output == NULL) {
+		return false;
+	}
+
+	unsigned int sequence;
+
+	// Retry until the game did not write during the copy
+	do {
+		sequence = state->sequence.load(memory_order_acquire);
+
+		if (sequence & 1) {
+			continue;
+		}
+
+		output->sequence = sequence;
+		output->isPlaying = state->isPlaying.load(memory_order_relaxed);
+		output->currentLevel = state->currentLevel.load(memory_order_relaxed);
+		output->numLivesRemaining =
+			state->numLivesRemaining.load(memory_order_relaxed);
+		output->currentLightPosition =
+			state->currentLightPosition.load(memory_order_relaxed);
+		output->isMovingRight = state->isMovingRight.load(memory_order_relaxed);
+		output->highScore = state->highScore.load(memory_order_relaxed);
+		output->timesPressed = state->timesPressed.load(memory_order_relaxed);
+		output->totalLivesLost =
+			state->totalLivesLost.load(memory_order_relaxed);
+		output->totalTimePlayed =
+			state->totalTimePlayed.load(memory_order_relaxed);
+		output->numTopScores = min(max(0,
+			state->numTopScores.load(memory_order_relaxed)), SHARED_TOP_SCORES);
+
+		for (int i = 0; i < output->numTopScores; i++) {
+			for (int j = 0; j < MAX_PLAYER_NAME_LENGTH; j++) {
+				output->topPlayerNames[i][j] =
+					state->topScores[i].playerName[j].load(memory_order_relaxed);
+			}
+
+			output->topPlayerNames[i][MAX_PLAYER_NAME_LENGTH - 1] = '\0';
+			output->topScores[i] =
+				state->topScores[i].score.load(memory_order_relaxed);
+		}
+
+		atomic_thread_fence(memory_order_acquire);
+	} while ((sequence & 1) ||
+		state->sequence.load(memory_order_relaxed) != sequence);
+
+	return true;
+}
+
+// ---------- [Functions for the shared state class end here] ---------- //
+
+
+
+// ------- [Functions for the event stream classes begin here] --------- //
+
+// EventRing constructor
+EventRing::EventRing () {
+	ring = NULL;
+	isWriter = false;
+}
+
+// EventRing deconstructor
+EventRing::~EventRing () {
+	close();
+}
+
+// Create the shared segment for the game to publish into
+bool EventRing::create (const char* name) {
+	sysLog.sysLog << "[EventRing::create] " <<
+		"Entered function" << endl;
+
+	close();
+
+	// Start from an empty ring so old subscribers notice the restart
+	shm_unlink(name);
+
+	int fileDescriptor = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0644);
+
+	// Check if segment could be opened
+	if (fileDescriptor < 0 ||
+			ftruncate(fileDescriptor, sizeof(EventRingState)) != 0) {
+		sysLog.sysLog << "[EventRing::create] " <<
+			"ERROR: Shared memory could not be created" << endl;
+
+		if (fileDescriptor >= 0) {
+			::close(fileDescriptor);
+		}
+
+		return false;
+	}
+
+	void* mapping = mmap(NULL, sizeof(EventRingState),
+		PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0);
+
+	::close(fileDescriptor);
+
+	if (mapping == MAP_FAILED) {
+		sysLog.sysLog << "[EventRing::create] " <<
+			"ERROR: Shared memory could not be mapped" << endl;
+
+		return false;
+	}
+
+	// A new segment is zeroed, which is an empty ring
+	ring = (EventRingState*) mapping;
+	isWriter = true;
+	ring->magic.store(EVENT_RING_MAGIC, memory_order_release);
+
+	return true;
+}
+
+// Attach to the shared segment of a running game as a subscriber
+bool EventRing::attach (const char* name) {
+	close();
+
+	int fileDescriptor = shm_open(name, O_RDONLY, 0);
+
+	// Check if segment could be opened
+	if (fileDescriptor < 0) {
+		return false;
+	}
+
+	struct stat segmentStatus;
+	void* mapping = MAP_FAILED;
+
+	if (fstat(fileDescriptor, &segmentStatus) == 0 &&
+			segmentStatus.st_size >= (off_t) sizeof(EventRingState)) {
+		mapping = mmap(NULL, sizeof(EventRingState), PROT_READ, MAP_SHARED,
+			fileDescriptor, 0);
+	}
+
+	::close(fileDescriptor);
+
+	if (mapping == MAP_FAILED) {
+		return false;
+	}
+
+	ring = (EventRingState*) mapping;
+	isWriter = false;
+
+	// Check that the game has set up the segment
+	if (ring->magic.load(memory_order_acquire) != EVENT_RING_MAGIC) {
+		close();
+
+		return false;
+	}
+
+	return true;
+}
+
+// Unmap the shared segment
+void EventRing::close () {
+	if (ring != NULL) {
+		munmap(ring, sizeof(EventRingState));
+		ring = NULL;
+	}
+}
+
+// Publish an event, overwriting the oldest one
+void EventRing::publish (StreamEventType type, int value, double time) {
+	// Check if ring is open
+	if (ring == NULL || !isWriter) {
+		return;
+	}
+
+	unsigned long long sequence = ring->head.load(memory_order_relaxed);
+	EventSlot& slot = ring->slots[sequence % EVENT_RING_CAPACITY];
+
+	slot.sequence.store(2 * sequence + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+
+	slot.detail.store(((unsigned long long) type << 32) |
+		(unsigned int) value, memory_order_relaxed);
+	slot.time.store(time, memory_order_relaxed);
+
+	slot.sequence.store(2 * sequence + 2, memory_order_release);
+	ring->head.store(sequence + 1, memory_order_release);
+}
+
+// Get the number of events published
+unsigned long long EventRing::getHead () {
+	return (ring == NULL) ? (0) : (ring->head.load(memory_order_acquire));
+}
+
+// Read an event, returning 1 if it was read, 0 if it has not been
+// published yet and -1 if it has been overwritten
+int EventRing::read (unsigned long long sequence, StreamEvent* output) {
+	// Check for null pointers
+	if (ring == NULL || output == NULL) {
+		return 0;
+	}
+
+	EventSlot& slot = ring->slots[sequence % EVENT_RING_CAPACITY];
+	unsigned long long expected = 2 * sequence + 2;
+	unsigned long long before = slot.sequence.load(memory_order_acquire);
+
+	if (before < expected) {
+		return 0;
+	}
+
+	unsigned long long detail = slot.detail.load(memory_order_relaxed);
+	double time = slot.time.load(memory_order_relaxed);
+
+	atomic_thread_fence(memory_order_acquire);
+
+	// The slot was reused for a later event during or before the copy
+	if (before != expected ||
+			slot.sequence.load(memory_order_relaxed) != expected) {
+		return -1;
+	}
+
+	output->sequence = sequence;
+	output->type  = (StreamEventType) (detail >> 32);
+	output->value = (int) (unsigned int) detail;
+	output->time  = time;
+
+	return 1;
+}
+
+// EventSubscriber constructor
+EventSubscriber::EventSubscriber (EventRing* ring, bool startsAtOldest) {
+	unsigned long long head = (ring == NULL) ? (0) : (ring->getHead());
+
+	this->ring = ring;
+	this->cursor = head;
+	this->maxLag = 0;
+	this->numOverrun = 0;
+
+	// Start with the oldest event which is still in the ring
+	if (startsAtOldest) {
+		this->cursor = (head > EVENT_RING_CAPACITY) ?
+			(head - EVENT_RING_CAPACITY) : (0);
+	}
+}
+
+// Read the next event, returning false if there is none yet
+bool EventSubscriber::poll (StreamEvent* output) {
+	// Check for null pointers
+	if (ring == NULL || output == NULL) {
+		return false;
+	}
+
+	while (true) {
+		unsigned long long lag = getLag();
+
+		if (lag > maxLag) {
+			maxLag = lag;
+		}
+
+		int result = ring->read(cursor, output);
+
+		if (result > 0) {
+			cursor++;
+
+			return true;
+		}
+
+		if (result == 0) {
+			return false;
+		}
+
+		// Skip to the oldest event which cannot be overwritten before it
+		// is read, counting the ones lost
+		unsigned long long head = ring->getHead();
+		unsigned long long oldest = head - EVENT_RING_CAPACITY / 2;
+
+		numOverrun += oldest - cursor;
+		cursor = oldest;
+	}
+}
+
+// Get the number of events waiting to be read
+unsigned long long EventSubscriber::getLag () {
+	unsigned long long head = ring->getHead();
+
+	return (head > cursor) ? (head - cursor) : (0);
+}
+
+// Get the most events which were ever waiting to be read
+unsigned long long EventSubscriber::getMaxLag () {
+	return maxLag;
+}
+
+// Get the number of events lost to being lapped by the game
+unsigned long long EventSubscriber::getNumOverrun () {
+	return numOverrun;
+}
+
+// -------- [Functions for the event stream classes end here] ---------- //
+
+
+// ------- [Functions for the control server class begin here] --------- //
+
+// ControlServer constructor
+ControlServer::ControlServer () {
+	listenSocket = -1;
+	wakeFileDescriptor = -1;
+	stopFileDescriptor = -1;
+	isStartRequested = false;
+	isStopRequested = false;
+	isShutdownRequested = false;
+	hasPendingDifficulty = false;
+	state = NULL;
+}
+
+// ControlServer deconstructor
+ControlServer::~ControlServer () {
+	close();
+}
+
+// Accept clients until the server is closed
+void ControlServer::serve () {
+	while (true) {
+		pollfd events[2] = {
+			{listenSocket, POLLIN, 0},
+			{stopFileDescriptor, POLLIN, 0}
+		};
+
+		if (poll(events, 2, -1) < 0 && errno != EINTR) {
+			return;
+		}
+
+		if (events[1].revents != 0) {
+			return;
+		}
+
+		if (events[0].revents & POLLIN) {
+			int client = accept4(listenSocket, NULL, NULL, SOCK_CLOEXEC);
+
+			if (client >= 0) {
+				serveClient(client);
+				::close(client);
+			}
+		}
+	}
+}
+
+// Answer each line a client sends until it hangs up or goes quiet
+void ControlServer::serveClient (int client) {
+	timeval timeout = {CONTROL_CLIENT_TIMEOUT, 0};
+	char buffer[MAX_LINE_LENGTH];
+	size_t length = 0;
+
+	setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+	while (true) {
+		ssize_t numRead = recv(client, buffer + length,
+			sizeof(buffer) - length - 1, 0);
+
+		if (numRead <= 0) {
+			return;
+		}
+
+		length += numRead;
+		buffer[length] = '\0';
+
+		// Answer every whole line received so far
+		char* line = buffer;
+		char* end;
+
+		while ((end = strchr(line, '\n')) != NULL) {
+			*end = '\0';
+
+			string reply = handleCommand(line) + "\n";
+
+			if (send(client, reply.c_str(), reply.size(), MSG_NOSIGNAL) < 0) {
+				return;
+			}
+
+			line = end + 1;
+		}
+
+		length -= line - buffer;
+		memmove(buffer, line, length);
+
+		// Drop clients whose lines do not fit
+		if (length == sizeof(buffer) - 1) {
+			return;
+		}
+	}
+}
+
+// Carry out a single command, returning the reply
+string ControlServer::handleCommand (const char* command) {
+	char name[MAX_LINE_LENGTH];
+
+	if (sscanf(command, "%s", name) != 1) {
+		return "error: empty command";
+	}
+
+	if (strcmp(name, "start") == 0) {
+		isStartRequested = true;
+	} else if (strcmp(name, "stop") == 0) {
+		isStopRequested = true;
+	} else if (strcmp(name, "shutdown") == 0) {
+		isStopRequested = true;
+		isShutdownRequested = true;
+	} else if (strcmp(name, "difficulty") == 0) {
+		DifficultyConfig config;
+
+		if (sscanf(command, "%*s %f %f %f %d", &config.timePerLevel,
+				&config.initialTimePerLight, &config.scalingTimePerLight,
+				&config.initialNumLives) != 4 || config.timePerLevel <= 0 ||
+				config.initialTimePerLight <= 0 ||
+				config.scalingTimePerLight <= 0 || config.initialNumLives <= 0) {
+			return "error: expected difficulty <time per level> "
+				"<initial time per light> <scaling> <lives>";
+		}
+
+		std::lock_guard<std::mutex> guard(difficultyLock);
+		pendingDifficulty = config;
+		hasPendingDifficulty = true;
+
+		return "ok: applies from the next game";
+	} else if (strcmp(name, "stats") == 0) {
+		SharedGameSnapshot snapshot;
+
+		if (state == NULL || !state->snapshot(&snapshot)) {
+			return "error: no state";
+		}
+
+		char reply[4 * MAX_LINE_LENGTH];
+
+		snprintf(reply, sizeof(reply), "%s level %d lives %d high score %d "
+			"presses %d lives lost %d time played %g",
+			(snapshot.isPlaying) ? ("playing") : ("idle"),
+			snapshot.currentLevel, snapshot.numLivesRemaining,
+			snapshot.highScore, snapshot.timesPressed, snapshot.totalLivesLost,
+			snapshot.totalTimePlayed);
+
+		return reply;
+	} else {
+		return string("error: unknown command: ") + name;
+	}
+
+	wake();
+
+	return "ok";
+}
+
+// Wake the game thread if it is waiting
+void ControlServer::wake () {
+	unsigned long long count = 1;
+
+	if (write(wakeFileDescriptor, &count, sizeof(count)) < 0) {
+		return;
+	}
+}
+
+// Start accepting commands on a Unix domain socket
+bool ControlServer::open (const char* path, SharedState* state) {
+	sysLog.sysLog << "[ControlServer::open] " <<
+		"Entered function" << endl;
+
+	close();
+
+	sockaddr_un address;
+
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+
+	// Check for a path which does not fit
+	if (strlen(path) >= sizeof(address.sun_path)) {
+		sysLog.sysLog << "[ControlServer::open] " <<
+			"ERROR: Socket path is too long" << endl;
+
+		return false;
+	}
+
+	strcpy(address.sun_path, path);
+	unlink(path);
+	socketPath = path;
+
+	this->state = state;
+	listenSocket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	wakeFileDescriptor = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	stopFileDescriptor = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+	if (listenSocket < 0 || wakeFileDescriptor < 0 ||
+			stopFileDescriptor < 0 ||
+			bind(listenSocket, (sockaddr*) &address, sizeof(address)) != 0 ||
+			listen(listenSocket, CONTROL_BACKLOG) != 0) {
+		sysLog.sysLog << "[ControlServer::open] " <<
+			"ERROR: Socket could not be opened: " << strerror(errno) << endl;
+
+		close();
+
+		return false;
+	}
+
+	server = std::thread(&ControlServer::serve, this);
+
+	sysLog.sysLog << "[ControlServer::open] " <<
+		"Listening on \"" << path << "\"" << endl;
+
+	return true;
+}
+
+// Stop accepting commands
+void ControlServer::close () {
+	if (server.joinable()) {
+		unsigned long long count = 1;
+
+		if (write(stopFileDescriptor, &count, sizeof(count)) ==
+				sizeof(count)) {
+			server.join();
+		} else {
+			server.detach();
+		}
+	}
+
+	if (listenSocket >= 0) {
+		::close(listenSocket);
+		unlink(socketPath.c_str());
+		listenSocket = -1;
+	}
+
+	if (wakeFileDescriptor >= 0) {
+		::close(wakeFileDescriptor);
+		wakeFileDescriptor = -1;
+	}
+
+	if (stopFileDescriptor >= 0) {
+		::close(stopFileDescriptor);
+		stopFileDescriptor = -1;
+	}
+}
+
+// Get the event counter which becomes readable when a command arrives
+int ControlServer::getWakeFileDescriptor () {
+	return wakeFileDescriptor;
+}
+
+// Reset the event counter after waking
+void ControlServer::clearWake () {
+	unsigned long long count;
+
+	if (read(wakeFileDescriptor, &count, sizeof(count)) < 0) {
+		return;
+	}
+}
+
+// Check for and clear a request to start a game
+bool ControlServer::takeStartRequest () {
+	return isStartRequested.exchange(false);
+}
+
+// Check for a request to stop the current game
+bool ControlServer::stopRequested () {
+	return isStopRequested;
+}
+
+// Clear a request to stop the current game
+void ControlServer::clearStopRequest () {
+	isStopRequested = false;
+}
+
+// Check for a request to shut down
+bool ControlServer::shutdownRequested () {
+	return isShutdownRequested;
+}
+
+// Check for and take a new difficulty
+bool ControlServer::takeDifficulty (DifficultyConfig* output) {
+	std::lock_guard<std::mutex> guard(difficultyLock);
+
+	if (!hasPendingDifficulty || output == NULL) {
+		return false;
+	}
+
+	*output = pendingDifficulty;
+	hasPendingDifficulty = false;
+
+	return true;
+}
+
+// -------- [Functions for the control server class end here] ---------- //
+
+
+
+// ------ [Functions for the game scheduler classes begin here] -------- //
+
+// GameScheduler constructor
+GameScheduler::GameScheduler (bool usesVirtualTime) :
+		virtualTimers(TIMER_RESOLUTION, 0) {
+
+	this->usesVirtualTime = usesVirtualTime;
+	this->virtualTime     = 0;
+	this->hardwareSlot    = -1;
+	this->numRunning      = 0;
+	this->numFailed       = 0;
+
+	// Real-time games share the system timer wheel
+	this->timers = (usesVirtualTime) ? (&virtualTimers) : (&systemTimers);
+}
+
+// GameScheduler deconstructor
+GameScheduler::~GameScheduler () {
+	// Destroy games which have not ended
+	for (size_t i = 0; i < slots.size(); i++) {
+		if (slots[i].handle) {
+			timers->cancel(slots[i].deadlineTimer);
+			slots[i].handle.destroy();
+			slots[i].handle = NULL;
+		}
+	}
+}
+
+// Get the current time in seconds
+double GameScheduler::now () {
+	if (usesVirtualTime) {
+		return virtualTime;
+	}
+
+	return monotonicTime();
+}
+
+// Take ownership of a game and schedule it to start immediately
+int GameScheduler::spawn (GameTask task) {
+	GameSlot slot;
+
+	slot.handle     = task.release();
+	slot.wantsPress = false;
+	slot.isWaiting  = false;
+	slot.event      = EVENT_DEADLINE;
+	slot.pressTime  = 0;
+
+	slots.push_back(slot);
+	numRunning++;
+
+	suspend(slots.size() - 1, now(), false);
+
+	return slots.size() - 1;
+}
+
+// Have presses of the button resume the given game
+void GameScheduler::setHardwareSlot (int slot) {
+	hardwareSlot = slot;
+}
+
+// Record what a game is waiting for
+void GameScheduler::suspend (int slot, double deadline, bool wantsPress) {
+	GameSlot& waiting = slots[slot];
+
+	waiting.wantsPress    = wantsPress;
+	waiting.isWaiting     = true;
+	waiting.deadlineTimer = timers->add(deadline, onDeadline, this, slot);
+}
+
+// Get the event which last resumed a game
+GameEvent GameScheduler::lastEvent (int slot) {
+	return slots[slot].event;
+}
+
+// Get the time at which the last press of a game was stamped
+double GameScheduler::lastPressTime (int slot) {
+	return slots[slot].pressTime;
+}
+
+// Press the button for a simulated game at the given time
+bool GameScheduler::schedulePress (int slot, double time) {
+	// Check for an invalid slot
+	if (slot < 0 || slot >= (int) slots.size()) {
+		sysLog.sysLog << "[GameScheduler::schedulePress] " <<
+			"ERROR: Received invalid slot: " << slot << endl;
+
+		return false;
+	}
+
+	timers->add(time, onPress, this, slot);
+
+	return true;
+}
+
+// Resume a suspended game
+void GameScheduler::resume (int slot, GameEvent event) {
+	// The deadline no longer applies once something else resumes the game
+	timers->cancel(slots[slot].deadlineTimer);
+
+	slots[slot].isWaiting = false;
+	slots[slot].event = event;
+	slots[slot].handle.resume();
+
+	// Clean up games which have ended
+	if (slots[slot].handle.done()) {
+		if (!slots[slot].handle.promise().result) {
+			numFailed++;
+		}
+
+		slots[slot].handle.destroy();
+		slots[slot].handle = NULL;
+		numRunning--;
+	}
+}
+
+// Resume a game whose deadline has passed
+void GameScheduler::onDeadline (void* context, int slot) {
+	GameScheduler* scheduler = (GameScheduler*) context;
+
+	if (scheduler->slots[slot].isWaiting) {
+		scheduler->resume(slot, EVENT_DEADLINE);
+	}
+}
+
+// Resume a simulated game whose button was pressed
+void GameScheduler::onPress (void* context, int slot) {
+	GameScheduler* scheduler = (GameScheduler*) context;
+
+	// Presses are dropped unless the game is listening for them
+	if (scheduler->slots[slot].isWaiting && scheduler->slots[slot].wantsPress) {
+		scheduler->slots[slot].pressTime = scheduler->now();
+		scheduler->resume(slot, EVENT_PRESS);
+	}
+}
+
+// Run games until they have all ended
+bool GameScheduler::run () {
+	double lastPollTime = now();    // Time of the last check of the
+	                                // button, or of the last wake
+
+	while (numRunning > 0) {
+		// Resume games whose deadlines have passed
+		timers->advance(now());
+
+		if (numRunning == 0) {
+			break;
+		}
+
+		// Jump to the next deadline when using virtual time
+		if (usesVirtualTime) {
+			if (timers->isEmpty()) {
+				break;
+			}
+
+			virtualTime = max(virtualTime, timers->nextExpiry());
+
+			continue;
+		}
+
+		// Check the button if a game is waiting for it, otherwise block
+		// until the next deadline
+		if (hardwareSlot >= 0 && slots[hardwareSlot].isWaiting &&
+				slots[hardwareSlot].wantsPress) {
+
+			double pollTime = now();
+			int buttonPress = buttonIsPressed();
+
+			if (buttonPress == -1) {
+				resume(hardwareSlot, EVENT_INPUT_ERROR);
+			} else if (buttonPress == 1) {
+				// Stamp the press halfway between this check and the one
+				// before, which found the button up
+				slots[hardwareSlot].pressTime = 0.5 * (lastPollTime + pollTime);
+				resume(hardwareSlot, EVENT_PRESS);
+			}
+
+			lastPollTime = pollTime;
+		} else {
+			waitForTimers(timers);
+			lastPollTime = now();
+		}
+	}
+
+	// Games which never ended are stuck waiting for input
+	if (numRunning > 0) {
+		sysLog.sysLog << "[GameScheduler::run] " <<
+			"ERROR: " << numRunning << " game(s) stopped without ending" << endl;
+
+		return false;
+	}
+
+	return numFailed == 0;
+}
+
+// Get the number of games which ended in error
+int GameScheduler::getNumFailed () {
+	return numFailed;
+}
+
+// Get the timer wheel holding the games' deadlines
+TimerWheel* GameScheduler::getTimers () {
+	return timers;
+}
+
+// SimulatedPlayer constructor
+SimulatedPlayer::SimulatedPlayer (unsigned seed, double errorStdDev) :
+	generator(seed), reactionError(0, errorStdDev) {}
+
+// Start the player over for a new game
+void SimulatedPlayer::seed (unsigned seed) {
+	generator.seed(seed);
+	reactionError.reset();
+}
+
+// Get how long after the start of a level the player presses, aiming for
+// the middle of the window stepsToPass light durations in
+double SimulatedPlayer::pressDelay (int stepsToPass, double timePerLight) {
+	double delay = (stepsToPass + 0.5) * timePerLight +
+		reactionError(generator);
+
+	return max(delay, 0.0);
+}
+
+// Decide when to press the button during the level which just started
+bool SimulatedPlayer::planPress (GameContext* context, double levelStartTime) {
+	// Check for null pointer
+	if (context == NULL || context->game == NULL) {
+		sysLog.sysLog << "[SimulatedPlayer::planPress] " <<
+			"ERROR: Received null pointer" << endl;
+
+		return false;
+	}
+
+	GameData* game = context->game;
+
+	// Find how many steps it takes for the light to reach the position
+	// at which a press passes the level
+	int passingPosition;
+	int stepsToPass;
+
+	if (game->isMovingRight) {
+		passingPosition = TARGET_INDEX + 1;
+		stepsToPass = (passingPosition - game->currentLightPosition +
+			TOTAL_NUM_LIGHTS) % TOTAL_NUM_LIGHTS;
+	} else {
+		passingPosition = TARGET_INDEX - 1;
+		stepsToPass = (game->currentLightPosition - passingPosition +
+			TOTAL_NUM_LIGHTS) % TOTAL_NUM_LIGHTS;
+	}
+
+	// Aim for the middle of the window in which the light is there
+	double pressTime = levelStartTime +
+		pressDelay(stepsToPass, game->timePerLight);
+
+	return context->scheduler->schedulePress(context->slot, pressTime);
+}
+
+// ------- [Functions for the game scheduler classes end here] --------- //
+
+
+
+// ------- [Functions for the input recording classes begin here] ------- //
+
+// InputRecorder constructor
+InputRecorder::InputRecorder () {
+	fileDescriptor = -1;
+	lastRound = 0;
+}
+
+// InputRecorder deconstructor
+InputRecorder::~InputRecorder () {
+	close();
+}
+
+// Add an unsigned LEB128 varint to the entries of the current game
+void InputRecorder::putVarint (unsigned long long value) {
+	while (value >= 0x80) {
+		buffer.push_back((unsigned char) (value | 0x80));
+		value >>= 7;
+	}
+
+	buffer.push_back((unsigned char) value);
+}
+
+// Add a press or stop to the entries of the current game
+void InputRecorder::recordEvent (RecordingTag type, int round, int step,
+		double offset, int position) {
+	putVarint(type);
+	putVarint(round - lastRound);
+	putVarint(step);
+
+	// Zigzag-encode the offset, since a press stamped between two checks
+	// of the button may come slightly before the step it was judged in
+	long long microseconds = llround(offset * 1e6);
+
+	putVarint((microseconds >= 0) ?
+		(2 * (unsigned long long) microseconds) :
+		(2 * (unsigned long long) -microseconds - 1));
+
+	if (type == RECORDING_PRESS) {
+		putVarint(position);
+	}
+
+	lastRound = round;
+}
+
+// Open a recording for appending, starting it if it is empty
+bool InputRecorder::open (const char* fileName) {
+	sysLog.sysLog << "[InputRecorder::open] " <<
+		"Entered function" << endl;
+
+	// Check for null pointer
+	if (fileName == NULL) {
+		sysLog.sysLog << "[InputRecorder::open] " <<
+			"ERROR: Null pointer found" << endl;
+
+		return false;
+	}
+
+	close();
+
+	fileDescriptor = ::open(fileName, O_WRONLY | O_APPEND | O_CREAT |
+		O_CLOEXEC, 0644);
+
+	// Check if file could be opened
+	if (fileDescriptor < 0) {
+		sysLog.sysLog << "[InputRecorder::open] " <<
+			"ERROR: \"" << fileName << "\" could not be opened" << endl;
+
+		return false;
+	}
+
+	// Start a new recording with its magic number and layout
+	if (lseek(fileDescriptor, 0, SEEK_END) == 0) {
+		unsigned int magic = RECORDING_MAGIC;
+
+		buffer.assign((unsigned char*) &magic,
+			(unsigned char*) &magic + sizeof(magic));
+		putVarint(RECORDING_VERSION);
+
+		if (write(fileDescriptor, buffer.data(), buffer.size()) !=
+				(ssize_t) buffer.size()) {
+			sysLog.sysLog << "[InputRecorder::open] " <<
+				"ERROR: \"" << fileName << "\" could not be started" << endl;
+
+			close();
+
+			return false;
+		}
+	}
+
+	buffer.clear();
+
+	return true;
+}
+
+// Close the recording, dropping a game which has not ended
+void InputRecorder::close () {
+	if (fileDescriptor >= 0) {
+		::close(fileDescriptor);
+		fileDescriptor = -1;
+	}
+
+	buffer.clear();
+}
+
+// Determine whether games are being recorded
+bool InputRecorder::isOpen () {
+	return fileDescriptor >= 0;
+}
+
+// Start recording a game played at the current difficulty
+void InputRecorder::startGame (unsigned int seed, long long startTime) {
+	buffer.clear();
+	lastRound = 0;
+
+	putVarint(RECORDING_GAME);
+	putVarint(seed);
+	putVarint(startTime);
+	putVarint(llround(gameDifficulty.timePerLevel * 1e6));
+	putVarint(llround(gameDifficulty.initialTimePerLight * 1e6));
+	putVarint(llround(gameDifficulty.scalingTimePerLight * 1e6));
+	putVarint(gameDifficulty.initialNumLives);
+	putVarint(scoresPrecision);
+}
+
+// Record a press made offset seconds after the given light step of the
+// given round, and the position it was judged at
+void InputRecorder::recordPress (int round, int step, double offset,
+		int position) {
+	recordEvent(RECORDING_PRESS, round, step, offset, position);
+}
+
+// Record the game being stopped offset seconds after the given light step
+void InputRecorder::recordStop (int round, int step, double offset) {
+	recordEvent(RECORDING_STOP, round, step, offset, 0);
+}
+
+// Record the outcome of the game and append the game to the recording
+bool InputRecorder::endGame (int level, int presses, int livesLost) {
+	// Check for a recording which is not open
+	if (fileDescriptor < 0) {
+		return false;
+	}
+
+	putVarint(RECORDING_GAME_END);
+	putVarint(level);
+	putVarint(presses);
+	putVarint(livesLost);
+
+	bool isWritten = write(fileDescriptor, buffer.data(), buffer.size()) ==
+		(ssize_t) buffer.size();
+
+	sysLog.sysLog << "[InputRecorder::endGame] " <<
+		((isWritten) ? ("Recorded ") : ("ERROR: Could not record ")) <<
+		buffer.size() << " byte(s)" << endl;
+
+	buffer.clear();
+
+	return isWritten;
+}
+
+// InputReplayer constructor
+InputReplayer::InputReplayer () {
+	readOffset = 0;
+	nextEvent = 0;
+	nextCheck = 0;
+	isStopped = false;
+	numMismatches = 0;
+	hasSameOutcome = false;
+}
+
+// Read an unsigned LEB128 varint, returning false at the end of the file
+bool InputReplayer::getVarint (unsigned long long& value) {
+	value = 0;
+
+	for (int shift = 0; shift < 64 && readOffset < contents.size();
+			shift += 7) {
+		unsigned char byte = contents[readOffset++];
+
+		value |= (unsigned long long) (byte & 0x7F) << shift;
+
+		if ((byte & 0x80) == 0) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// Load a whole recording and check that it is one
+bool InputReplayer::open (const char* fileName) {
+	ifstream inFile(fileName, ios::binary);
+	unsigned int magic = 0;
+	unsigned long long version = 0;
+
+	// Check if file could be opened
+	if (!inFile.is_open()) {
+		cerr << "[InputReplayer::open] ERROR: \"" << fileName <<
+			"\" could not be opened" << endl;
+
+		return false;
+	}
+
+	contents.assign(istreambuf_iterator<char>(inFile),
+		istreambuf_iterator<char>());
+
+	if (contents.size() >= sizeof(magic)) {
+		memcpy(&magic, contents.data(), sizeof(magic));
+	}
+
+	readOffset = sizeof(magic);
+
+	if (magic != RECORDING_MAGIC || !getVarint(version) ||
+			version != RECORDING_VERSION) {
+		cerr << "[InputReplayer::open] ERROR: \"" << fileName <<
+			"\" is not a recording this version can play" << endl;
+
+		return false;
+	}
+
+	return true;
+}
+
+// Read the next game of the recording, returning false once there are no
+// more whole games
+bool InputReplayer::readGame (RecordedGame* game) {
+	unsigned long long tag, value[7];
+	int round = 0;
+
+	game->events.clear();
+
+	if (!getVarint(tag) || tag != RECORDING_GAME) {
+		return false;
+	}
+
+	for (int i = 0; i < 7; i++) {
+		if (!getVarint(value[i])) {
+			return false;
+		}
+	}
+
+	game->seed = value[0];
+	game->startTime = value[1];
+	game->difficulty.timePerLevel = value[2] / 1e6;
+	game->difficulty.initialTimePerLight = value[3] / 1e6;
+	game->difficulty.scalingTimePerLight = value[4] / 1e6;
+	game->difficulty.initialNumLives = value[5];
+	game->scoresPrecision = value[6];
+
+	// Read presses and stops until the end of the game
+	while (getVarint(tag)) {
+		if (tag == RECORDING_GAME_END) {
+			if (!getVarint(value[0]) || !getVarint(value[1]) ||
+					!getVarint(value[2])) {
+				return false;
+			}
+
+			game->level = value[0];
+			game->presses = value[1];
+			game->livesLost = value[2];
+
+			return true;
+		}
+
+		if (tag != RECORDING_PRESS && tag != RECORDING_STOP) {
+			return false;
+		}
+
+		RecordedEvent event;
+
+		if (!getVarint(value[0]) || !getVarint(value[1]) ||
+				!getVarint(value[2]) || (tag == RECORDING_PRESS &&
+				!getVarint(value[3]))) {
+			return false;
+		}
+
+		round += value[0];
+		event.type = (RecordingTag) tag;
+		event.round = round;
+		event.step = value[1];
+		event.offset = (value[2] % 2 == 0) ?
+			((int) (value[2] / 2)) : (-(int) (value[2] / 2) - 1);
+		event.position = (tag == RECORDING_PRESS) ? ((int) value[3]) : (-1);
+		game->events.push_back(event);
+	}
+
+	return false;
+}
+
+// Start playing back a game
+void InputReplayer::startGame (const RecordedGame& game) {
+	current = game;
+	nextEvent = 0;
+	nextCheck = 0;
+	isStopped = false;
+	numMismatches = 0;
+	hasSameOutcome = false;
+}
+
+// Schedule the presses due in the light step the game has just taken
+void InputReplayer::onLightStep (GameContext* context, int round,
+		int step) {
+	while (nextEvent < current.events.size() &&
+			current.events[nextEvent].round == round &&
+			current.events[nextEvent].step == step) {
+		RecordedEvent& event = current.events[nextEvent++];
+
+		if (event.type == RECORDING_STOP) {
+			isStopped = true;
+		} else {
+			// Deliver the press within the step it was judged in, even if
+			// it was stamped before the step or the game woke up late
+			double deadline = min(context->game->lightDeadline,
+				context->game->levelDeadline) - REPLAY_PRESS_MARGIN;
+			double pressTime = context->scheduler->now() +
+				max(event.offset / 1e6, 0.0);
+
+			context->scheduler->schedulePress(context->slot,
+				min(pressTime, deadline));
+		}
+	}
+
+	// Drop events which can no longer happen, so that one press which
+	// lands elsewhere does not hold up the rest
+	while (nextEvent < current.events.size() &&
+			current.events[nextEvent].round < round) {
+		nextEvent++;
+	}
+}
+
+// Compare the position a press was judged at with the recorded one, and
+// get the recorded time of the press after its light step
+double InputReplayer::checkPress (int position) {
+	while (nextCheck < current.events.size() &&
+			current.events[nextCheck].type != RECORDING_PRESS) {
+		nextCheck++;
+	}
+
+	if (nextCheck >= current.events.size()) {
+		numMismatches++;
+
+		return 0;
+	}
+
+	RecordedEvent& event = current.events[nextCheck++];
+
+	if (event.position != position) {
+		numMismatches++;
+	}
+
+	return event.offset / 1e6;
+}
+
+// Compare the outcome of the game with the recorded one
+void InputReplayer::endGame (int level, int presses, int livesLost) {
+	hasSameOutcome = (level == current.level &&
+		presses == current.presses && livesLost == current.livesLost);
+}
+
+// Determine whether the recorded game was stopped by now
+bool InputReplayer::stopRequested () {
+	return isStopped;
+}
+
+// Determine whether every press and the outcome of the game matched
+bool InputReplayer::matches () {
+	return numMismatches == 0 && hasSameOutcome;
+}
+
+// Get the number of presses of the current game which did not match
+int InputReplayer::getNumMismatches () {
+	return numMismatches;
+}
+
+// Get the size of the recording in bytes
+size_t InputReplayer::getSize () {
+	return contents.size();
+}
+
+// -------- [Functions for the input recording classes end here] -------- //
+
+
+
+// ------- [Functions for the batch simulator class begin here] -------- //
+
+// BatchSimulator constructor
+BatchSimulator::BatchSimulator (DifficultyConfig config, double errorStdDev,
+		int numGames, unsigned seed) {
+
+	this->config      = config;
+	this->numGames    = max(numGames, 0);
+	this->numBlocks   =
+		(this->numGames + SIMULATION_LANES - 1) / SIMULATION_LANES;
+
+	players.assign(SIMULATION_LANES, SimulatedPlayer(seed, errorStdDev));
+	randomState.resize(numBlocks);
+	playerSeed.resize(numBlocks);
+	currentLevel.resize(numBlocks);
+	numLivesRemaining.resize(numBlocks);
+	currentLightPosition.resize(numBlocks);
+	isMovingRight.resize(numBlocks);
+	timePerLight.resize(numBlocks);
+	sessionTime.resize(numBlocks);
+	timesPressed.resize(numBlocks);
+	livesLost.resize(numBlocks);
+
+	// Start every game as reset() would, leaving the padding after the
+	// last game without lives
+	std::mt19937 seeder(seed);
+
+	for (int block = 0; block < numBlocks; block++) {
+		for (int lane = 0; lane < SIMULATION_LANES; lane++) {
+			bool isGame = block * SIMULATION_LANES + lane < this->numGames;
+
+			randomState[block][lane]          = seeder() | 1;
+			playerSeed[block][lane]           = seeder();
+			currentLevel[block][lane]         = 0;
+			numLivesRemaining[block][lane]    =
+				(isGame) ? (config.initialNumLives) : (0);
+			currentLightPosition[block][lane] = 0;
+			isMovingRight[block][lane]        = 0;
+			timePerLight[block][lane]         = config.initialTimePerLight;
+			sessionTime[block][lane]          = 0;
+			timesPressed[block][lane]         = 0;
+			livesLost[block][lane]            = 0;
+		}
+	}
+}
+
+// Get the next random numbers of a block (xorshift32 in every lane)
+UintLanes BatchSimulator::nextRandom (int block) {
+	UintLanes state = randomState[block];
+
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+
+	randomState[block] = state;
+
+	return state;
+}
+
+// Play one level of every running game in a block, returning whether
+// any game in the block was still running
+bool BatchSimulator::playLevel (int block) {
+	// Stop games which never run out of lives at the level cap
+	IntLanes isRunning = (numLivesRemaining[block] > 0) &
+		(currentLevel[block] < MAX_SIMULATED_LEVELS);
+	bool anyRunning = false;
+
+	for (int lane = 0; lane < SIMULATION_LANES; lane++) {
+		anyRunning = anyRunning || isRunning[lane];
+	}
+
+	if (!anyRunning) {
+		return false;
+	}
+
+	IntLanes zero = {};
+
+	// Pick a direction and starting position as setRandomDirection does
+	IntLanes movingRight = __builtin_convertvector(nextRandom(block) & 1u,
+		IntLanes) != 0;
+	IntLanes start = (movingRight) ?
+		(zero) : (zero + (TOTAL_NUM_LIGHTS - 1));
+
+	// Find the position at which a press passes the level, and how many
+	// steps the light takes to get there
+	IntLanes passingPosition = (movingRight) ?
+		(zero + (TARGET_INDEX + 1)) : (zero + (TARGET_INDEX - 1));
+	IntLanes stepsToPass = (movingRight) ?
+		((passingPosition - start + TOTAL_NUM_LIGHTS) % TOTAL_NUM_LIGHTS) :
+		((start - passingPosition + TOTAL_NUM_LIGHTS) % TOTAL_NUM_LIGHTS);
+
+	// Each lane's player decides when to press
+	DoubleLanes lightTime = timePerLight[block];
+	DoubleLanes pressTime = {};
+	DoubleLanes noTime = {};
+
+	for (int lane = 0; lane < SIMULATION_LANES; lane++) {
+		if (isRunning[lane]) {
+			pressTime[lane] = players[lane].pressDelay(stepsToPass[lane],
+				lightTime[lane]);
+		}
+	}
+
+	// Presses after the level ran out never happen
+	IntLanes pressed = __builtin_convertvector(
+		pressTime < (double) config.timePerLevel, IntLanes);
+
+	// The light steps each time a light duration passes, so find where
+	// updateLightPosition has moved it to by the time of the press
+	DoubleLanes stepCount = pressTime / lightTime;
+
+	stepCount = (stepCount < 1e9) ? (stepCount) : (noTime + 1e9);
+
+	IntLanes steps = __builtin_convertvector(stepCount, IntLanes) %
+		TOTAL_NUM_LIGHTS;
+	IntLanes position = (movingRight) ?
+		((start + steps) % TOTAL_NUM_LIGHTS) :
+		((start - steps + TOTAL_NUM_LIGHTS) % TOTAL_NUM_LIGHTS);
+
+	// Check the target as playGame does
+	IntLanes passed = isRunning & pressed & (position == passingPosition);
+	IntLanes failed = isRunning & ~passed;
+
+	// Add the time spent in the level, the pause after it and the flash
+	// for passing it
+	LongLanes isRunningWide = __builtin_convertvector(isRunning, LongLanes);
+	LongLanes pressedWide   = __builtin_convertvector(pressed, LongLanes);
+	LongLanes passedWide    = __builtin_convertvector(passed, LongLanes);
+	DoubleLanes levelTime = (pressedWide) ?
+		(pressTime) : (noTime + config.timePerLevel);
+
+	levelTime += DEFAULT_PAUSE_TIME;
+	levelTime += (passedWide) ? (noTime + DEFAULT_PAUSE_TIME) : (noTime);
+
+	sessionTime[block] += (isRunningWide) ? (levelTime) : (noTime);
+
+	// Update the games, with masks being -1 in lanes where they hold
+	timesPressed[block]      -= isRunning & pressed;
+	currentLevel[block]      -= passed;
+	numLivesRemaining[block] += failed;
+	livesLost[block]         -= failed;
+
+	// Speed up passed levels as updateLightDuration does, rounding the
+	// duration to the float GameData keeps it in
+	DoubleLanes scaledTime = __builtin_convertvector(
+		__builtin_convertvector(lightTime * config.scalingTimePerLight,
+		FloatLanes), DoubleLanes);
+
+	scaledTime = (scaledTime < (double) MIN_TIME_PER_LIGHT) ?
+		(noTime + MIN_TIME_PER_LIGHT) : (scaledTime);
+
+	timePerLight[block] = (passedWide) ? (scaledTime) : (lightTime);
+
+	currentLightPosition[block] = (isRunning) ?
+		(position) : (currentLightPosition[block]);
+	isMovingRight[block] = (isRunning) ?
+		(movingRight & 1) : (isMovingRight[block]);
+
+	return true;
+}
+
+// Play every game until it runs out of lives or reaches the level cap
+void BatchSimulator::run () {
+	for (int block = 0; block < numBlocks; block++) {
+		for (int lane = 0; lane < SIMULATION_LANES; lane++) {
+			players[lane].seed(playerSeed[block][lane]);
+		}
+
+		while (playLevel(block));
+	}
+}
+
+// Get the number of games being simulated
+int BatchSimulator::getNumGames () {
+	return numGames;
+}
+
+// Get the level a game reached
+int BatchSimulator::getLevelReached (int game) {
+	return currentLevel[game / SIMULATION_LANES][game % SIMULATION_LANES];
+}
+
+// Get the length of a game in seconds
+double BatchSimulator::getSessionTime (int game) {
+	return sessionTime[game / SIMULATION_LANES][game % SIMULATION_LANES];
+}
+
+// Get the number of times the button was pressed in a game
+int BatchSimulator::getTimesPressed (int game) {
+	return timesPressed[game / SIMULATION_LANES][game % SIMULATION_LANES];
+}
+
+// Get the number of lives lost in a game
+int BatchSimulator::getLivesLost (int game) {
+	return livesLost[game / SIMULATION_LANES][game % SIMULATION_LANES];
+}
+
+// -------- [Functions for the batch simulator class end here] --------- //
+
+
+
+// ------ [Functions for the work-stealing pool class begin here] ------ //
+
+// WorkStealingPool constructor
+WorkStealingPool::WorkStealingPool (int numWorkers) {
+	// Use every core if no number of workers is given
+	if (numWorkers <= 0) {
+		numWorkers = std::thread::hardware_concurrency();
+	}
+
+	this->numWorkers = max(numWorkers, 1);
+	this->queues     = new WorkerQueue[this->numWorkers];
+	this->function   = NULL;
+	this->context    = NULL;
+	this->numStolen  = 0;
+}
+
+// WorkStealingPool deconstructor
+WorkStealingPool::~WorkStealingPool () {
+	delete[] queues;
+	queues = NULL;
+}
+
+// Take a task from the worker's own queue, or steal one
+bool WorkStealingPool::takeTask (int worker, int& task) {
+	// Take the most recently queued task of the worker's own queue
+	{
+		std::lock_guard<std::mutex> guard(queues[worker].lock);
+
+		if (!queues[worker].tasks.empty()) {
+			task = queues[worker].tasks.back();
+			queues[worker].tasks.pop_back();
+
+			return true;
+		}
+	}
+
+	// Steal the oldest task of another worker
+	for (int i = 1; i < numWorkers; i++) {
+		WorkerQueue& victim = queues[(worker + i) % numWorkers];
+		std::lock_guard<std::mutex> guard(victim.lock);
+
+		if (!victim.tasks.empty()) {
+			task = victim.tasks.front();
+			victim.tasks.pop_front();
+			numStolen++;
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// Run tasks until there are none left in any queue
+void WorkStealingPool::work (WorkStealingPool* pool, int worker) {
+	int task;
+
+	while (pool->takeTask(worker, task)) {
+		pool->function(pool->context, task);
+	}
+}
+
+// Run the given number of tasks and wait for all of them to finish
+void WorkStealingPool::run (int numTasks, PoolTask function, void* context) {
+	sysLog.sysLog << "[WorkStealingPool::run] " <<
+		"Running " << numTasks << " task(s) on " << numWorkers <<
+		" worker(s)" << endl;
+
+	this->function = function;
+	this->context  = context;
+
+	// Deal the tasks out to the workers
+	for (int task = 0; task < numTasks; task++) {
+		queues[task % numWorkers].tasks.push_back(task);
+	}
+
+	// The calling thread works as worker 0
+	vector<std::thread> threads;
+
+	for (int worker = 1; worker < numWorkers; worker++) {
+		threads.push_back(std::thread(work, this, worker));
+	}
+
+	work(this, 0);
+
+	for (size_t i = 0; i < threads.size(); i++) {
+		threads[i].join();
+	}
+}
+
+// Get the number of threads running tasks
+int WorkStealingPool::getNumWorkers () {
+	return numWorkers;
+}
+
+// Get the number of tasks which were stolen
+int WorkStealingPool::getNumStolen () {
+	return numStolen;
+}
+
+// ------- [Functions for the work-stealing pool class end here] ------- //
+
+
+
+// -------- [Functions for interfacing with hardware begin here] ------- //
+
+// Export every pin which is not exported yet, returning the number of
+// pins exported or -1 on errors
+int exportPins() {
+	int numExported = 0;
+	int fileDescriptor = -1;
+
+	for (int i = 0; i < TOTAL_NUM_PINS; i++) {
+		if (systemPins[i]->isActivated()) {
+			continue;
+		}
+
+		// Open the export file once for all the pins
+		if (fileDescriptor < 0) {
+			fileDescriptor = open(GPIO_EXPORT, O_WRONLY);
+
+			if (fileDescriptor < 0) {
+				sysLog.sysLog << "[exportPins] " <<
+					"ERROR: Could not open \"" << GPIO_EXPORT << "\"" << endl;
+
+				return -1;
+			}
+		}
+
+		// The kernel takes one pin per write
+		string pinID = to_string(PIN_IDS[i]);
+
+		if (write(fileDescriptor, pinID.c_str(), pinID.size()) !=
+				(ssize_t) pinID.size()) {
+			sysLog.sysLog << "[exportPins] " <<
+				"ERROR: Could not export pin " << PIN_IDS[i] << endl;
+
+			close(fileDescriptor);
+
+			return -1;
+		}
+
+		numExported++;
+	}
+
+	if (fileDescriptor >= 0) {
+		close(fileDescriptor);
+	}
+
+	return numExported;
+}
+
+// Wait until the attribute files of every pin can be used, waking on
+// inotify events rather than retrying. Kernels which do not report new
+// sysfs entries are covered by rechecking every GPIO_RECHECK_INTERVAL.
+bool waitForPins(double timeout) {
+	int notifier = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	bool isWatched[TOTAL_NUM_PINS] = {false};
+	const unsigned int EVENTS = IN_CREATE | IN_MOVED_TO | IN_ATTRIB;
+	double deadline = monotonicTime() + timeout;
+
+	if (notifier < 0) {
+		sysLog.sysLog << "[waitForPins] " <<
+			"Warning: inotify is not available" << endl;
+	} else {
+		inotify_add_watch(notifier, GPIO_ROOT, EVENTS);
+	}
+
+	while (true) {
+		int numPending = 0;
+
+		// Watch the directories of exported pins before checking their
+		// files, so no change is missed in between
+		for (int i = 0; i < TOTAL_NUM_PINS; i++) {
+			if (notifier >= 0 && !isWatched[i] && systemPins[i]->isActivated()) {
+				isWatched[i] = inotify_add_watch(notifier,
+					systemPins[i]->getDirectoryName(), EVENTS) >= 0;
+			}
+		}
+
+		for (int i = 0; i < TOTAL_NUM_PINS; i++) {
+			if (!systemPins[i]->isReady(i == TOTAL_NUM_PINS - 1)) {
+				numPending++;
+			}
+		}
+
+		if (numPending == 0) {
+			break;
+		}
+
+		double remaining = deadline - monotonicTime();
+
+		if (remaining <= 0) {
+			sysLog.sysLog << "[waitForPins] " <<
+				"ERROR: " << numPending << " pin(s) did not become ready" << endl;
+
+			if (notifier >= 0) {
+				close(notifier);
+			}
+
+			return false;
+		}
+
+		// Sleep until something changes
+		if (notifier >= 0) {
+			pollfd notification = {notifier, POLLIN, 0};
+			char events[4096];
+
+			poll(&notification, 1,
+				ceil(min(remaining, GPIO_RECHECK_INTERVAL) * 1000));
+
+			while (read(notifier, events, sizeof(events)) > 0) {
+			}
+		} else {
+			sleep((float) min(remaining, GPIO_RECHECK_INTERVAL));
+		}
+	}
+
+	if (notifier >= 0) {
+		close(notifier);
+	}
+
+	return true;
+}
+
+// Structure for holding the results of configuring the pins
+struct PinSetup {
+	int results[TOTAL_NUM_PINS];    // Result of GPIOHandler::configure
+};
+
+// Configure a single pin, for running on the work-stealing pool
+void configurePin (void* context, int task) {
+	PinSetup* setup = (PinSetup*) context;
+
+	// Set first nine pins as output for LEDs and the last pin as input
+	// from the button
+	setup->results[task] = systemPins[task]->configure(
+		task == TOTAL_NUM_PINS - 1);
+}
+
+// Export a pin outside the strip, wait for it and set it up as an input
+// or as an output which is off, returning NULL on errors
+GPIOHandler* exportPin(int pinID, bool isInput) {
+	GPIOHandler* pin = new GPIOHandler(pinID);
+	double deadline = monotonicTime() + GPIO_READY_TIMEOUT;
+
+	if (!pin->activate()) {
+		sysLog.sysLog << "[exportPin] " <<
+			"ERROR: Pin " << pinID << " could not be exported" << endl;
+
+		delete pin;
+
+		return NULL;
+	}
+
+	// Wait for the kernel to set up the attribute files of the pin
+	while (!pin->isReady(isInput) && monotonicTime() < deadline) {
+		sleep((float) GPIO_RECHECK_INTERVAL);
+	}
+
+	if (pin->configure(isInput) < 0 || (!isInput && !pin->setState(false))) {
+		sysLog.sysLog << "[exportPin] " <<
+			"ERROR: Pin " << pinID << " could not be set up" << endl;
+
+		pin->deactivate();
+		delete pin;
+
+		return NULL;
+	}
+
+	return pin;
+}
+
+// Set up the GPIO pins
+// Export, wait for and configure every pin, reporting how long each
+// phase took
+bool setUpPins() {
+	double startTime = monotonicTime();
+
+	// Export every pin in one pass
+	int numExported = exportPins();
+
+	if (numExported < 0) {
+		sysLog.sysLog << "[setUpPins] " <<
+			"ERROR: Could not export pins" << endl;
+
+		return false;
+	}
+
+	double exportTime = monotonicTime();
+
+	// Wait for the kernel and udev to set up the pins
+	if (!waitForPins(GPIO_READY_TIMEOUT)) {
+		sysLog.sysLog << "[setUpPins] " <<
+			"ERROR: Pins did not become ready" << endl;
+
+		return false;
+	}
+
+	double readyTime = monotonicTime();
+
+	// Configure the pins concurrently, skipping any which are already
+	// configured
+	PinSetup setup;
+	WorkStealingPool pool(TOTAL_NUM_PINS);
+	int numConfigured = 0;
+
+	pool.run(TOTAL_NUM_PINS, configurePin, &setup);
+
+	for (int i = 0; i < TOTAL_NUM_PINS; i++) {
+		if (setup.results[i] < 0) {
+			sysLog.sysLog << "[setUpPins] " <<
+				"ERROR: Could not set pin " << PIN_IDS[i] << " to " <<
+				((i == TOTAL_NUM_PINS - 1) ? ("input") : ("output")) << endl;
+
+			return false;
+		}
+
+		numConfigured += setup.results[i];
+	}
+
+	double configureTime = monotonicTime();
+
+	sysLog.sysLog << "[setUpPins] " <<
+		"Pins set up in " << (configureTime - startTime) * 1000 << " ms: " <<
+		"exported " << numExported << " in " <<
+		(exportTime - startTime) * 1000 << " ms, waited " <<
+		(readyTime - exportTime) * 1000 << " ms, configured " <<
+		numConfigured << " (skipped " << TOTAL_NUM_PINS - numConfigured <<
+		") in " << (configureTime - readyTime) * 1000 << " ms" << endl;
+
+	return true;
+}
+
+bool initialize(Statistics* stats, GameData* game, bool isWarmStart) {
+	sysLog.sysLog << "[initialize] " <<
+		"Entered function" << endl;
+
+	// Check for null pointers
+	if (stats == NULL || game == NULL) {
+		sysLog.sysLog << "[initialize] " <<
+			"ERROR: Received null pointer" << endl;
+
+		return false;
+	}
+
+	// Set up GPIO pins
+	sysLog.sysLog << "[initialize] " <<
+		"Setting up GPIO pins" << endl;
+
+	double startTime = monotonicTime();
+
+	for (int i = 0; i < TOTAL_NUM_PINS; i++) {
+		delete systemPins[i];
+		systemPins[i] = new GPIOHandler(PIN_IDS[i]);
+	}
+
+	// Pins left configured by a warm exit only need their value files
+	// opened
+	bool isResumed = isWarmStart;
+
+	for (int i = 0; i < TOTAL_NUM_PINS && isResumed; i++) {
+		isResumed = systemPins[i]->isReady(i == TOTAL_NUM_PINS - 1) &&
+			(i == TOTAL_NUM_PINS - 1 ||
+				systemPins[i]->getValueFileDescriptor() >= 0);
+	}
+
+	if (isResumed) {
+		sysLog.sysLog << "[initialize] " <<
+			"Resumed pins in " << (monotonicTime() - startTime) * 1000 <<
+			" ms" << endl;
+	} else if (!setUpPins()) {
+		return false;
+	}
+
+	// Write frames to the lights, only writing the pins which change
+	if (!lightOutput.open(lightBackend)) {
+		sysLog.sysLog << "[initialize] " <<
+			"ERROR: Could not set up light output" << endl;
+
+		return false;
+	}
+
+	// Dim the lights with a trail if asked to
+	if (pwmFrequency > 0 &&
+			!softwarePWM.start(&lightOutput, pwmFrequency, PWM_TRAIL_TIME)) {
+		sysLog.sysLog << "[initialize] " <<
+			"ERROR: Could not start software PWM" << endl;
+
+		return false;
+	}
+
+	// Show the level and high score if asked to
+	if (showsScores && !segmentDisplay.open(SEGMENT_PIN_IDS, DIGIT_PIN_IDS)) {
+		sysLog.sysLog << "[initialize] " <<
+			"ERROR: Could not set up score display" << endl;
+
+		return false;
+	}
+
+	// Sleep on the button's edge interrupt while idle
+	if (!buttonWaiter.open(systemPins[TOTAL_NUM_PINS - 1])) {
+		sysLog.sysLog << "[initialize] " <<
+			"ERROR: Could not set up button waiter" << endl;
+
+		return false;
+	}
+
+	// Listen to the buttons of both players if asked to
+	if (playsHeadToHead && !dualButtons.open(systemPins[TOTAL_NUM_PINS - 1],
+			SECOND_BUTTON_PIN_ID)) {
+		sysLog.sysLog << "[initialize] " <<
+			"ERROR: Could not set up the second button" << endl;
+
+		return false;
+	}
+
+	// Initialize stats and game, unless they were resumed from a snapshot
+	if (!isWarmStart) {
+		stats->highScore       = 0;
+		stats->totalTimePlayed = 0;
+		stats->timesPressed    = 0;
+		stats->totalLivesLost  = 0;
+		stats->journalSequence = 0;
+		stats->precisionHighScore = 0;
+
+		game->timePerLevel      = gameDifficulty.timePerLevel;
+		game->timePerLight      = gameDifficulty.initialTimePerLight;
+		game->currentLevel      = 0;
+		game->numLivesRemaining = gameDifficulty.initialNumLives;
+		game->isMovingRight     = false;
+	}
+
+	game->levelDeadline     = 0;
+	game->lightDeadline     = 0;
+	game->lightStates       = NULL;
+	game->leaderboardRecord = -1;
+	game->precisionScore    = 0;
+	game->randomState       = (unsigned int) time(NULL);
+
+	return true;
+}
+
+// Ask hardware if the button is pressed
+int buttonIsPressed() {
+	const int BUTTON_GPIO_PIN_ID = TOTAL_NUM_PINS - 1;
+	bool isOn = false;
+
+	/*sysLog.sysLog << "[buttonIsPressed] " <<
+		"Entered function" << endl;*/
+
+	// Error check
+	if (!systemPins[BUTTON_GPIO_PIN_ID]->getState(isOn)) {
+		sysLog.sysLog << "[buttonIsPressed] " <<
+			"ERROR: Could not get button state" << endl;
+
+		return -1;
+	}
+
+	// Check for button press, which is logged on every poll while the
+	// button is held
+	if (isOn) {
+		static LogLimit pressedLimit("[buttonIsPressed] ", "button pressed");
+
+		if (pressedLimit.allow()) {
+			sysLog.sysLog << "[buttonIsPressed] " <<
+				"Button is pressed" << endl;
+		}
+
+		return 1;
+	}
+
+	return 0;
+}
+
+// Decide whether to try the button again after it could not be read. A
+// read may fail while a pin is briefly unavailable, so failures are
+// retried until they have lasted MAX_INPUT_OUTAGE seconds. An
+// outageStartTime below 0 means the last read went through.
+bool retryInput(const char* prefix, double* outageStartTime, double time) {
+	static LogLimit outageLimit("[retryInput] ", "button outage");
+
+	if (*outageStartTime < 0) {
+		if (outageLimit.allow()) {
+			sysLog.sysLog << prefix <<
+				"ERROR: Button state could not be detected - retrying" <<
+				endl;
+		}
+
+		*outageStartTime = time;
+	}
+
+	if (time - *outageStartTime > MAX_INPUT_OUTAGE) {
+		sysLog.sysLog << prefix <<
+			"ERROR: Button state could not be detected for " <<
+			time - *outageStartTime << " second(s) - giving up" << endl;
+
+		return false;
+	}
+
+	return true;
+}
+
+// Note that the button can be read again after an outage
+void endInputOutage(const char* prefix, double* outageStartTime,
+		double time) {
+	static LogLimit recoveryLimit("[endInputOutage] ", "button recovery");
+
+	if (*outageStartTime < 0) {
+		return;
+	}
+
+	if (recoveryLimit.allow()) {
+		sysLog.sysLog << prefix <<
+			"Button state detected again after " <<
+			time - *outageStartTime << " second(s)" << endl;
+	}
+
+	*outageStartTime = -1;
+}
+
+// Update which lights are on/off
+bool updateLightStrip(const bool* lightStates) {
+	static LogLimit enteredLimit("[updateLightStrip] ", "function entry");
+
+	if (enteredLimit.allow()) {
+		sysLog.sysLog << "[updateLightStrip] " <<
+			"Entered function" << endl;
+	}
+
+	// Let the software PWM show the frame if it is dimming the lights
+	if (softwarePWM.isStarted()) {
+		softwarePWM.setLights(lightStates);
+
+		return true;
+	}
+
+	// Write the lights which changed
+	if (!lightOutput.commit(lightStates)) {
+		sysLog.sysLog << "[updateLightStrip] " <<
+			"ERROR: Light strip could not be updated" << endl;
+
+		return false;
+	}
+
+	return true;
+}
+
+// Light the current position and its mirror image, which is the light of
+// the second player in a head-to-head game
+bool updateMirroredLightStrip(GameData* game) {
+	bool lightStates[TOTAL_NUM_LIGHTS];
+
+	for (int i = 0; i < TOTAL_NUM_LIGHTS; i++) {
+		lightStates[i] = (i == game->currentLightPosition ||
+			i == TOTAL_NUM_LIGHTS - 1 - game->currentLightPosition);
+	}
+
+	return updateLightStrip(lightStates);
+}
+
+// Clean up the GPIO pins
+void deinitialize(bool keepsPinsExported) {
+	sysLog.sysLog << "[deinitialize] " <<
+		"Entered function" << endl;
+
+	softwarePWM.stop();
+	segmentDisplay.close();
+	lightOutput.close();
+	dualButtons.close();
+	buttonWaiter.close();
+
+	if (gpioFaults.isLoaded()) {
+		gpioFaults.report(sysLog.sysLog, "[deinitialize] ");
+	}
+
+	// Clean up GPIO pins
+	sysLog.sysLog << "[deinitialize] " <<
+		"Cleaning up GPIO pins" << endl;
+
+	for (int i = 0; i < TOTAL_NUM_PINS; i++) {
+		// Turn off lights
+		if (i < TOTAL_NUM_LIGHTS) {
+			if (!systemPins[i]->setState(false)) {
+				sysLog.sysLog << "[deinitialize] " <<
+					"WARNING: Failed to turn off light" <<
+					PIN_IDS[i] << endl;
+			}
+		}
+
+		// Deactivate pin, unless a warm restart will use it
+		if (!keepsPinsExported && !systemPins[i]->deactivate()) {
+			sysLog.sysLog << "[deinitialize] " <<
+				"WARNING: Failed to activate deactivate pin " <<
+				PIN_IDS[i] << endl;
+		}
+
+		delete systemPins[i];
+		systemPins[i] = NULL;
+	}
+}
+
+// --------- [Functions for interfacing with hardware end here] -------- //
+
+
+
+// ----------- [Functions for file input/output begin here] ------------ //
+
+// Compute the CRC-32 of a block of memory
+unsigned int computeChecksum(const void* data, size_t length) {
+	static unsigned int table[256];
+	static bool hasTable = false;
+
+	// Build the lookup table the first time
+	if (!hasTable) {
+		for (unsigned int i = 0; i < 256; i++) {
+			unsigned int entry = i;
+
+			for (int bit = 0; bit < 8; bit++) {
+				entry = (entry & 1) ? (0xEDB88320 ^ (entry >> 1)) : (entry >> 1);
+			}
+
+			table[i] = entry;
+		}
+
+		hasTable = true;
+	}
+
+	const unsigned char* bytes = (const unsigned char*) data;
+	unsigned int crc = 0xFFFFFFFF;
+
+	for (size_t i = 0; i < length; i++) {
+		crc = table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+	}
+
+	return ~crc;
+}
+
+// Reads a line in the file
+void parseline (char line[], Statistics* stats, int tracker) {
+	enum States {HIGHSCORE, PLAYTIME, TIMESPRESSED, LIVESLOST,
+		JOURNALSEQUENCE, PRECISIONHIGHSCORE};
+	States state = HIGHSCORE;
+
+	sysLog.sysLog << "[parseline] " <<
+		"Entered function" << endl;
+
+	if (tracker == 0) {
+		state = HIGHSCORE;
+	} else if (tracker == 1) {
+		state = PLAYTIME;
+	} else if (tracker == 2) {
+		state = TIMESPRESSED;
+	} else if (tracker == 3) {
+		state = LIVESLOST;
+	} else if (tracker == 4) {
+		state = JOURNALSEQUENCE;
+	} else if (tracker == 5) {
+		state = PRECISIONHIGHSCORE;
+	}
+
+	switch (state) {
+		case HIGHSCORE:
+			sysLog.sysLog << "[parseline] " <<
+				"Setting high score to " << atoi(line) << endl;
+
+			stats->highScore = atoi(line);
+
+			break;
+
+		case PLAYTIME:
+			sysLog.sysLog << "[parseline] " <<
+				"Setting total time played to " << atof(line) << endl;
+
+			stats->totalTimePlayed = atof(line);
+
+			break;
+
+		case TIMESPRESSED:
+			sysLog.sysLog << "[parseline] " <<
+				"Setting number of times played to " << atoi(line) << endl;
+
+			stats->timesPressed = atoi(line);
+
+			break;
+
+		case LIVESLOST:
+			sysLog.sysLog << "[parseline] " <<
+				"Setting number of times lost to " << atoi(line) << endl;
+
+			stats->totalLivesLost = atoi(line);
+
+			break;
+
+		case JOURNALSEQUENCE:
+			sysLog.sysLog << "[parseline] " <<
+				"Setting last journal record to " << strtoull(line, NULL, 10) <<
+				endl;
+
+			stats->journalSequence = strtoull(line, NULL, 10);
+
+			break;
+
+		case PRECISIONHIGHSCORE:
+			sysLog.sysLog << "[parseline] " <<
+				"Setting precision high score to " << atoi(line) << endl;
+
+			stats->precisionHighScore = atoi(line);
+
+			break;
+	}
+}
+
+// Read statistics from file
+bool readStats(Statistics* stats) {
+	const char* fileName = STAT_FILE;
+
+	sysLog.sysLog << "[readStats] " <<
+		"Entered function" << endl;
+
+	// Check for null pointers
+	if (fileName == NULL || stats == NULL) {
+		sysLog.sysLog <<
+			"[readStats] ERROR: Null pointer found" << endl;
+		return false;
+	}
+
+	std::ifstream inFile;
+	inFile.open(fileName);
+
+	// Check if file could be opened
+	if (!inFile.is_open()) {
+		sysLog.sysLog <<
+			"[readStats] ERROR: Input file could not be opened" << endl;
+		return false;
+	}
+
+	// Read data from file
+	char line[MAX_LINE_LENGTH];
+	int counter = 0;
+
+	// Parse each line, allowing files written before the journal
+	// sequence and the precision high score were added
+	while (counter < 6 && inFile.getline(line, MAX_LINE_LENGTH)) {
+		parseline(line, stats, counter);
+		counter++;
+	}
+
+	if (counter < 4) {
+		sysLog.sysLog <<
+			"[readStats] ERROR: File ended after " << counter <<
+			" line(s)" << endl;
+		return false;
+	}
+
+	sysLog.sysLog << "[readStats] " <<
+		"Successfully read statistics from file" << endl;
+
+	return true;
+}
+
+/*
+	Writes the following statistics:
+	highscore
+	total time played
+	number of times button was clicked
+	number of lives lost
+	last journal record included
+	precision high score
+*/
+
+bool writeStats(Statistics* stats) {
+	const char* fileName = STAT_FILE;
+	const char* tempFileName = STAT_TEMP_FILE;
+
+	sysLog.sysLog << "[writeStats] " <<
+		"Entered function" << endl;
+
+	char contents[6 * MAX_LINE_LENGTH];
+	int length = snprintf(contents, sizeof(contents),
+		"%d\n%g\n%d\n%d\n%llu\n%d\n", stats->highScore,
+		stats->totalTimePlayed, stats->timesPressed, stats->totalLivesLost,
+		stats->journalSequence, stats->precisionHighScore);
+
+	// Write a new file next to the old one so that a crash leaves one of
+	// them whole
+	int outFile = open(tempFileName, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+	// Check if file could be opened
+	if (outFile < 0) {
+		sysLog.sysLog << "[writeStats] " <<
+			"Output file could not be opened" << endl;
+
+		return false;
+	}
+
+	// Writing to file
+	bool isWritten = write(outFile, contents, length) == length &&
+		fsync(outFile) == 0;
+
+	// Closing file
+	close(outFile);
+
+	// Replace the old file
+	if (!isWritten || rename(tempFileName, fileName) != 0) {
+		sysLog.sysLog << "[writeStats] " <<
+			"Output file could not be written" << endl;
+
+		return false;
+	}
+
+	sysLog.sysLog << "[writeStats] " <<
+		"Successfully wrote statistics to file" << endl;
+
+	return true;
+}
+
+
+// Get the identifier of the current boot, so that state from an earlier
+// boot is not trusted
+bool getBootID(char* output, size_t length) {
+	memset(output, 0, length);
+
+	int fileDescriptor = open(BOOT_ID_FILE, O_RDONLY);
+
+	if (fileDescriptor < 0) {
+		return false;
+	}
+
+	ssize_t numRead = read(fileDescriptor, output, length - 1);
+	close(fileDescriptor);
+
+	return numRead > 0;
+}
+
+// Write what a warm restart needs, leaving the pins exported
+bool writeSnapshot(Statistics* stats, GameData* game) {
+	sysLog.sysLog << "[writeSnapshot] " <<
+		"Entered function" << endl;
+
+	// Check for null pointers
+	if (stats == NULL || game == NULL) {
+		sysLog.sysLog << "[writeSnapshot] " <<
+			"ERROR: Received null pointer" << endl;
+
+		return false;
+	}
+
+	WarmSnapshot snapshot;
+
+	// Clear the padding so the checksum only depends on the contents
+	memset(&snapshot, 0, sizeof(snapshot));
+	snapshot.magic        = SNAPSHOT_MAGIC;
+	snapshot.version      = SNAPSHOT_VERSION;
+	snapshot.ownerProcess = getpid();
+	getBootID(snapshot.bootID, sizeof(snapshot.bootID));
+
+	for (int i = 0; i < TOTAL_NUM_PINS; i++) {
+		snapshot.pinIDs[i]     = PIN_IDS[i];
+		snapshot.pinIsInput[i] = (i == TOTAL_NUM_PINS - 1);
+	}
+
+	snapshot.stats                = *stats;
+	snapshot.timePerLevel         = game->timePerLevel;
+	snapshot.timePerLight         = game->timePerLight;
+	snapshot.currentLevel         = game->currentLevel;
+	snapshot.numLivesRemaining    = game->numLivesRemaining;
+	snapshot.currentLightPosition = game->currentLightPosition;
+	snapshot.isMovingRight        = game->isMovingRight;
+	snapshot.checksum = computeChecksum(
+		(const char*) &snapshot + sizeof(snapshot.checksum),
+		sizeof(snapshot) - sizeof(snapshot.checksum));
+
+	// Write a new file and rename it over the old one
+	int outFile = open(SNAPSHOT_TEMP_FILE, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+	if (outFile < 0) {
+		sysLog.sysLog << "[writeSnapshot] " <<
+			"ERROR: Snapshot file could not be opened" << endl;
+
+		return false;
+	}
+
+	bool isWritten = write(outFile, &snapshot, sizeof(snapshot)) ==
+		(ssize_t) sizeof(snapshot) && fsync(outFile) == 0;
+
+	close(outFile);
+
+	if (!isWritten || rename(SNAPSHOT_TEMP_FILE, SNAPSHOT_FILE) != 0) {
+		sysLog.sysLog << "[writeSnapshot] " <<
+			"ERROR: Snapshot file could not be written" << endl;
+
+		return false;
+	}
+
+	return true;
+}
+
+// Read and remove the snapshot left by a warm exit, returning false if
+// there is none or it cannot be trusted
+bool readSnapshot(Statistics* stats, GameData* game) {
+	sysLog.sysLog << "[readSnapshot] " <<
+		"Entered function" << endl;
+
+	// Check for null pointers
+	if (stats == NULL || game == NULL) {
+		sysLog.sysLog << "[readSnapshot] " <<
+			"ERROR: Received null pointer" << endl;
+
+		return false;
+	}
+
+	WarmSnapshot snapshot;
+	int inFile = open(SNAPSHOT_FILE, O_RDONLY);
+
+	if (inFile < 0) {
+		sysLog.sysLog << "[readSnapshot] " <<
+			"No snapshot to resume from" << endl;
+
+		return false;
+	}
+
+	bool isRead = read(inFile, &snapshot, sizeof(snapshot)) ==
+		(ssize_t) sizeof(snapshot);
+
+	close(inFile);
+
+	// A snapshot is only used once, so later crashes start cold
+	unlink(SNAPSHOT_FILE);
+
+	// Check that the snapshot is whole and from this build
+	if (!isRead || snapshot.magic != SNAPSHOT_MAGIC ||
+			snapshot.version != SNAPSHOT_VERSION ||
+			snapshot.checksum != computeChecksum(
+				(const char*) &snapshot + sizeof(snapshot.checksum),
+				sizeof(snapshot) - sizeof(snapshot.checksum))) {
+		sysLog.sysLog << "[readSnapshot] " <<
+			"WARNING: Snapshot is corrupted" << endl;
+
+		return false;
+	}
+
+	// Check that the pins were left exported during this boot
+	char bootID[sizeof(snapshot.bootID)];
+
+	if (!getBootID(bootID, sizeof(bootID)) ||
+			strcmp(bootID, snapshot.bootID) != 0) {
+		sysLog.sysLog << "[readSnapshot] " <<
+			"Snapshot is from an earlier boot" << endl;
+
+		return false;
+	}
+
+	// Check that the pins are the ones this build uses
+	for (int i = 0; i < TOTAL_NUM_PINS; i++) {
+		if (snapshot.pinIDs[i] != PIN_IDS[i] ||
+				snapshot.pinIsInput[i] != (i == TOTAL_NUM_PINS - 1)) {
+			sysLog.sysLog << "[readSnapshot] " <<
+				"Snapshot is for different pins" << endl;
+
+			return false;
+		}
+	}
+
+	// Check that no other process still owns the pins
+	if (snapshot.ownerProcess != getpid() &&
+			kill(snapshot.ownerProcess, 0) == 0) {
+		sysLog.sysLog << "[readSnapshot] " <<
+			"WARNING: Process " << snapshot.ownerProcess <<
+			" still owns the pins" << endl;
+
+		return false;
+	}
+
+	*stats = snapshot.stats;
+	game->timePerLevel         = snapshot.timePerLevel;
+	game->timePerLight         = snapshot.timePerLight;
+	game->currentLevel         = snapshot.currentLevel;
+	game->numLivesRemaining    = snapshot.numLivesRemaining;
+	game->currentLightPosition = snapshot.currentLightPosition;
+	game->isMovingRight        = snapshot.isMovingRight;
+
+	sysLog.sysLog << "[readSnapshot] " <<
+		"Resuming from snapshot of process " << snapshot.ownerProcess << endl;
+
+	return true;
+}
+
+// ------------ [Functions for file input/output end here] ------------- //
+
+
+
+// --------- [Functions for calculating statistics begin here] --------- //
+
+// Update high score
+bool highScoreFunc(Statistics* stats, GameData* game) {
+	// Check for null pointers
+	if (game == NULL || stats == NULL) {
+		sysLog.sysLog << "[highScoreFunc] " <<
+			"ERROR: Received null pointer" << endl;
+
+		return false;
+	}
+
+	// Update high score
+	if (game->currentLevel > stats->highScore) {
+		sysLog.sysLog << "[highScoreFunc] " <<
+			"Updating highscore from " << stats->highScore <<
+			" to " << game->currentLevel << endl;
+
+		stats->highScore = game->currentLevel;
+	}
+
+	// Update precision high score
+	if (game->precisionScore > stats->precisionHighScore) {
+		sysLog.sysLog << "[highScoreFunc] " <<
+			"Updating precision high score from " <<
+			stats->precisionHighScore << " to " << game->precisionScore << endl;
+
+		stats->precisionHighScore = game->precisionScore;
+	}
+
+	// Keep the score of the session in the leaderboard up to date
+	if (game->leaderboardRecord >= 0 && game->currentLevel >
+			leaderboard.getScore(game->leaderboardRecord) &&
+			!leaderboard.updateScore(game->leaderboardRecord,
+				game->currentLevel)) {
+		sysLog.sysLog << "[highScoreFunc] " <<
+			"ERROR: Leaderboard could not be updated" << endl;
+
+		return false;
+	}
+
+	return true;
+}
+
+// Update total time played
+bool playTime(Statistics* stats, float seconds) {
+	// Check for null pointer
+	if (stats == NULL) {
+		sysLog.sysLog << "[playTime] " <<
+			"ERROR: Received null pointer" << endl;
+
+		return false;
+	}
+
+	sysLog.sysLog << "[playTime] " <<
+		"Incrementing total play time by " << seconds << endl;
+
+	stats->totalTimePlayed += seconds;
+
+	return true;
+}
+
+// Find how early (negative) or late (positive) a press was, in seconds,
+// relative to the middle of the window in which a press passes the level
+float pressTimingError(GameData* game, double pressTime) {
+	int passingPosition = (game->isMovingRight) ?
+		(TARGET_INDEX + 1) : (TARGET_INDEX - 1);
+
+	// Count the steps the light has taken past the passing position,
+	// going back instead if that is closer
+	int stepsPast = (game->isMovingRight) ?
+		(game->currentLightPosition - passingPosition) :
+		(passingPosition - game->currentLightPosition);
+
+	stepsPast = (stepsPast + TOTAL_NUM_LIGHTS) % TOTAL_NUM_LIGHTS;
+
+	if (stepsPast > TOTAL_NUM_LIGHTS / 2) {
+		stepsPast -= TOTAL_NUM_LIGHTS;
+	}
+
+	double windowMiddle = game->lightDeadline - 0.5 * game->timePerLight;
+
+	return stepsPast * game->timePerLight + (pressTime - windowMiddle);
+}
+
+// Determine whether a player's press at the given light position passes a
+// round of a head-to-head game. The second player's light is the mirror
+// image of the first's, moving the other way.
+bool pressPassesHeadToHead(int player, int position, bool isMovingRight) {
+	if (player == 1) {
+		position = TOTAL_NUM_LIGHTS - 1 - position;
+		isMovingRight = !isMovingRight;
+	}
+
+	return (isMovingRight) ?
+		(position == TARGET_INDEX + 1) : (position == TARGET_INDEX - 1);
+}
+
+// Grade a press in precision mode by how long after the light entered the
+// passing position it was stamped. The light moved to its current position
+// at stepTime and to the one before at previousStepTime, so a press
+// stamped before the light moved is judged on where the light was then.
+// The windows of the better grades shrink with the time per light, so
+// that they keep their meaning in the fastest levels.
+PressGrade gradePress(GameData* game, double pressTime, double stepTime,
+		double previousStepTime, double* timingError) {
+	int position = game->currentLightPosition;
+	double entryTime = stepTime;
+	int passingPosition = (game->isMovingRight) ?
+		(TARGET_INDEX + 1) : (TARGET_INDEX - 1);
+
+	if (pressTime < stepTime) {
+		position = (game->isMovingRight) ?
+			((position + TOTAL_NUM_LIGHTS - 1) % TOTAL_NUM_LIGHTS) :
+			((position + 1) % TOTAL_NUM_LIGHTS);
+		entryTime = previousStepTime;
+	}
+
+	*timingError = pressTime - entryTime;
+
+	if (position != passingPosition) {
+		return GRADE_MISS;
+	}
+
+	if (*timingError <= min(PERFECT_PRESS_TIME,
+			(double) (PERFECT_PRESS_FRACTION * game->timePerLight))) {
+		return GRADE_PERFECT;
+	}
+
+	if (*timingError <= min(GREAT_PRESS_TIME,
+			(double) (GREAT_PRESS_FRACTION * game->timePerLight))) {
+		return GRADE_GREAT;
+	}
+
+	return GRADE_OK;
+}
+
+// ---------- [Functions for calculating statistics end here] ---------- //
+
+
+
+// ----------- [Functions for changing game data begin here] ----------- //
+
+// Get a direction from the game's seeded generator, so that a recording
+// of the game can replay it
+bool setRandomDirection(GameData* game) {
+	// Check for null pointer
+	if (game == NULL) {
+		sysLog.sysLog <<
+			"[setRandomDirection] ERROR: Null pointer found" << endl;
+
+		return false;
+	}
+
+	// Step the game's linear congruential generator, using a high bit
+	// since the low bits repeat quickly
+	game->randomState = game->randomState * 1664525u + 1013904223u;
+
+	bool isMovingRight = ((game->randomState >> 16) & 1) == 0;
+
+	// Set direction
+	game->isMovingRight = isMovingRight;
+	sysLog.sysLog <<
+		"[setRandomDirection] Direction set to " <<
+		((isMovingRight) ? ("right") : ("left")) << endl;
+
+	// Set position according to direction
+	if (isMovingRight) {
+		game->currentLightPosition = 0;
+	} else {
+		game->currentLightPosition = TOTAL_NUM_LIGHTS - 1;
+	}
+
+	sysLog.sysLog <<
+		"[setRandomDirection] Position set to " <<
+		(game->currentLightPosition) << endl;
+
+	return true;
+}
+
+// Move the light to its next position (cyclic)
+bool updateLightPosition(GameData* game) {
+	// Check for null pointer
+	if (game == NULL) {
+		sysLog.sysLog <<
+			"[updateLightPosition] ERROR: Null pointer found" << endl;
+		return false;
+	}
+
+	// Move current light to the right
+	if (game->isMovingRight) {
+		game->currentLightPosition += 1;
+		game->currentLightPosition %= TOTAL_NUM_LIGHTS;
+
+		static LogLimit rightLimit("[updateLightPosition] ", "right move");
+
+		if (rightLimit.allow()) {
+			sysLog.sysLog <<
+				"[updateLightPosition] Light moved to the right" << endl;
+		}
+
+	// Move current light to the left
+	} else {
+		game->currentLightPosition += TOTAL_NUM_LIGHTS - 1;
+		game->currentLightPosition %= TOTAL_NUM_LIGHTS;
+
+		static LogLimit leftLimit("[updateLightPosition] ", "left move");
+
+		if (leftLimit.allow()) {
+			sysLog.sysLog <<
+				"[updateLightPosition] Light moved to the left" << endl;
+		}
+	}
+
+	// Update lightStates array
+	for (int i = 0; i < TOTAL_NUM_LIGHTS; i++) {
+		game->lightStates[i] = (i == game->currentLightPosition);
+	}
+
+	return true;
+}
+
+// Update the length of time for which a light is on
+bool updateLightDuration(GameData* game) {
+	// Check for null pointer
+	if (game == NULL) {
+		sysLog.sysLog <<
+			"[updateLightDuration] ERROR: Null pointer found" << endl;
+
+		return false;
+	}
+
+	game->timePerLight = max(game->timePerLight *
+		gameDifficulty.scalingTimePerLight, MIN_TIME_PER_LIGHT);
+
+	sysLog.sysLog <<
+		"[updateLightDuration] Light duration set to " <<
+		game->timePerLight << endl;
+
+	return true;
+}
+
+// Turn off every light in the lightStates array
+void clearLightStates (GameData* game) {
+	// Initialize array if it does not already exist
+	if (game->lightStates == NULL) {
+		game->lightStates = new bool[TOTAL_NUM_LIGHTS];
+
+		sysLog.sysLog <<
+			"[clearLightStates] Initialized lightStates array" << endl;
+	}
+
+	// Clear array
+	for (int i = 0; i < TOTAL_NUM_LIGHTS; i++) {
+		game->lightStates[i] = false;
+	}
+}
+
+bool clearLights (GameData* game) {
+	clearLightStates(game);
+
+	// Turn off lights
+	if (!updateLightStrip(game->lightStates)) {
+		return false;
+	}
+
+	sysLog.sysLog <<
+		"[clearLights] Cleared lightStates array" << endl;
+
+	return true;
+}
+
+// Reset the game data without touching the hardware
+bool resetGameData(GameData* game) {
+	// Check for null pointer
+	if (game == NULL) {
+		sysLog.sysLog <<
+			"[resetGameData] ERROR: Null pointer found" << endl;
+
+		return false;
+	}
+
+	game->timePerLevel  = gameDifficulty.timePerLevel;
+	game->timePerLight  = gameDifficulty.initialTimePerLight;
+	game->levelDeadline = 0;
+	game->lightDeadline = 0;
+	game->currentLevel  = 0;
+	game->numLivesRemaining = gameDifficulty.initialNumLives;
+	game->leaderboardRecord = -1;
+	game->precisionScore = 0;
+
+	clearLightStates(game);
+
+	return true;
+}
+
+// Reset the game
+bool reset(GameData* game) {
+	// Check for null pointer
+	if (!resetGameData(game)) {
+		sysLog.sysLog <<
+			"[reset] ERROR: Null pointer found" << endl;
+
+		return false;
+	}
+
+	// Clear light array
+
+	sysLog.sysLog << "[reset] " <<
+		"Clearing light array" << endl;
+
+	if (!clearLights(game)) {
+		sysLog.sysLog << "[reset] " <<
+			"ERROR: Light array could not be cleared" << endl;
+
+		return false;
+	}
+
+	// Update light strip
+	sysLog.sysLog << "[reset] " <<
+		"Update light strip" << endl;
+
+	if (!updateLightStrip(game->lightStates)) {
+		sysLog.sysLog << "[reset] " <<
+			"ERROR: Light strip could not be updated" << endl;
+
+		return false;
+	}
+
+	return true;
+}
+
+// Turn all lights on or off
+bool setAllLights (bool isOn) {
+	bool lightStates[TOTAL_NUM_LIGHTS];
+
+	for (int i = 0; i < TOTAL_NUM_LIGHTS; i++) {
+		lightStates[i] = isOn;
+	}
+
+	if (!updateLightStrip(lightStates)) {
+		sysLog.sysLog << "[setAllLights] " <<
+			"ERROR: Could not turn " << ((isOn) ? ("on") : ("off")) <<
+			" light(s)" << endl;
+
+		return false;
+	}
+
+	return true;
+}
+
+// ------------ [Functions for changing game data end here] ------------ //
+
+
+
+// ----------- [Functions for handling game logic begin here] ---------- //
+
+// Get the time in seconds from a clock which never jumps
+double monotonicTime () {
+	timespec currentTime;
+
+	clock_gettime(CLOCK_MONOTONIC, &currentTime);
+
+	return currentTime.tv_sec + currentTime.tv_nsec / 1e9;
+}
+
+// Get the CPU time in seconds used by every thread of the process
+double processCPUTime () {
+	timespec currentTime;
+
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &currentTime);
+
+	return currentTime.tv_sec + currentTime.tv_nsec / 1e9;
+}
+
+// Do nothing for some number of seconds
+void sleep (float seconds) {
+	Timer* t = new Timer;
+	t->setStopTime(seconds);
+
+	sysLog.sysLog <<
+		"[sleep] Sleeping for " << seconds << " second(s)" << endl;
+
+	// Block until the timer wheel has something to do
+	while (!t->isFinished()) {
+		waitForTimers(&systemTimers);
+	}
+
+	sysLog.sysLog <<
+		"[sleep] Woke up after " << seconds << " second(s)" << endl;
+
+	delete t;
+}
+
+// Sleep until the given monotonic time without the timer wheel, for
+// threads which keep their own deadlines
+void sleepUntil (double time) {
+	timespec deadline;
+
+	deadline.tv_sec = (time_t) time;
+	deadline.tv_nsec = (long) ((time - deadline.tv_sec) * 1e9);
+
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) ==
+			EINTR) {
+	}
+}
+
+// Do nothing until the button is pressed
+bool gameLoopIdle(Statistics* stats, GameData* game) {
+	sysLog.sysLog <<
+		"[gameLoopIdle] Entered gameLoopIdle state" << endl;
+
+	// Check for null pointer
+	if (stats == NULL) {
+		sysLog.sysLog <<
+			"[gameLoopIdle] ERROR: Null pointer found" << endl;
+
+		return false;
+	}
+
+	Timer* t = new Timer;
+
+	sysLog.sysLog <<
+		"[gameLoopIdle] Waiting for button press" << endl;
+
+	t->setStopTime(MAX_IDLE_TIME);
+
+	int buttonPress = 0;
+	double outageStartTime = -1;
+
+	while (buttonPress != 1 && !t->isFinished()) {
+		// Get button press
+		buttonPress = buttonIsPressed();
+
+		// Try a failed read again, as the pins may recover
+		if (buttonPress == -1) {
+			double time = monotonicTime();
+
+			if (!retryInput("[gameLoopIdle] ", &outageStartTime, time)) {
+				delete t;
+
+				return false;
+			}
+
+			sleepUntil(time + BUTTON_RECHECK_INTERVAL / 1000.0);
+		} else if (outageStartTime >= 0) {
+			endInputOutage("[gameLoopIdle] ", &outageStartTime,
+				monotonicTime());
+		}
+	};
+
+	if (!t->isFinished()) {
+		delete t;
+
+		sysLog.sysLog << "[gameLoopIdle] " <<
+			"Button press detected - exiting idle state" << endl;
+
+		return true;
+	} else {
+		delete t;
+
+		sysLog.sysLog <<
+			"[gameLoopIdle] The button was not pressed for " <<
+			MAX_IDLE_TIME << " second(s) - exiting game" << endl;
+
+		return false;
+	}
+}
+
+// Wait without a time limit for the button or a control command
+bool gameLoopWait () {
+	sysLog.sysLog <<
+		"[gameLoopWait] Waiting for button press or start command" << endl;
+
+	// Stopping a game has no meaning while idle
+	controlServer.clearStopRequest();
+
+	double outageStartTime = -1;
+
+	while (true) {
+		// Check for commands
+		if (controlServer.shutdownRequested()) {
+			sysLog.sysLog << "[gameLoopWait] " <<
+				"Shutdown requested - exiting game" << endl;
+
+			return false;
+		}
+
+		if (controlServer.takeStartRequest()) {
+			sysLog.sysLog << "[gameLoopWait] " <<
+				"Start requested - exiting idle state" << endl;
+
+			return true;
+		}
+
+		// Sleep until a command arrives or the button is pressed
+		WakeReason reason = buttonWaiter.wait(INFINITY,
+			controlServer.getWakeFileDescriptor());
+
+		// Try a failed read again, as the pins may recover
+		if (reason == WAKE_ERROR) {
+			double time = monotonicTime();
+
+			if (!retryInput("[gameLoopWait] ", &outageStartTime, time)) {
+				return false;
+			}
+
+			sleepUntil(time + BUTTON_RECHECK_INTERVAL / 1000.0);
+
+			continue;
+		}
+
+		endInputOutage("[gameLoopWait] ", &outageStartTime, monotonicTime());
+
+		if (reason == WAKE_PRESS) {
+			sysLog.sysLog << "[gameLoopWait] " <<
+				"Button press detected - exiting idle state" << endl;
+
+			return true;
+		}
+
+		controlServer.clearWake();
+	}
+}
+
+// Play the attract animation until the button is pressed, a start command
+// arrives or the game has been idle for idleTime seconds. An idleTime of
+// 0 plays until a press or a command.
+bool gameLoopAttract (float idleTime) {
+	AnimationPlayer attract;
+	bool result = false;
+
+	sysLog.sysLog << "[gameLoopAttract] " <<
+		"Playing attract animation" << endl;
+
+	// Stopping a game has no meaning while idle
+	controlServer.clearStopRequest();
+
+	double startTime = monotonicTime();
+	double startCPUTime = processCPUTime();
+	double idleDeadline = (idleTime > 0) ? (startTime + idleTime) : (INFINITY);
+	double outageStartTime = -1;
+
+	attract.start(&ATTRACT_ANIMATION, startTime, true, true);
+
+	while (true) {
+		// Check for commands
+		if (controlServer.shutdownRequested()) {
+			sysLog.sysLog << "[gameLoopAttract] " <<
+				"Shutdown requested - exiting game" << endl;
+
+			break;
+		}
+
+		if (controlServer.takeStartRequest()) {
+			sysLog.sysLog << "[gameLoopAttract] " <<
+				"Start requested - exiting idle state" << endl;
+
+			result = true;
+
+			break;
+		}
+
+		// Show the frame which is due
+		if (attract.step(monotonicTime()) < 0) {
+			break;
+		}
+
+		WakeReason reason = buttonWaiter.wait(min(attract.getDeadline(),
+			idleDeadline), controlServer.getWakeFileDescriptor());
+
+		// Try a failed read again, as the pins may recover
+		if (reason == WAKE_ERROR) {
+			double time = monotonicTime();
+
+			if (!retryInput("[gameLoopAttract] ", &outageStartTime, time)) {
+				break;
+			}
+
+			sleepUntil(time + BUTTON_RECHECK_INTERVAL / 1000.0);
+
+			continue;
+		}
+
+		endInputOutage("[gameLoopAttract] ", &outageStartTime,
+			monotonicTime());
+
+		if (reason == WAKE_PRESS) {
+			sysLog.sysLog << "[gameLoopAttract] " <<
+				"Button press detected - exiting idle state" << endl;
+
+			result = true;
+
+			break;
+		} else if (reason == WAKE_COMMAND) {
+			controlServer.clearWake();
+		} else if (monotonicTime() >= idleDeadline) {
+			sysLog.sysLog <<
+				"[gameLoopAttract] The button was not pressed for " <<
+				idleTime << " second(s) - exiting game" << endl;
+
+			break;
+		}
+	}
+
+	double elapsedTime = monotonicTime() - startTime;
+
+	sysLog.sysLog << "[gameLoopAttract] " <<
+		"Showed " << attract.getNumFramesShown() << " frame(s), skipped " <<
+		attract.getNumFramesSkipped() << ", in " << elapsedTime <<
+		" second(s) using " << 100 * (processCPUTime() - startCPUTime) /
+		max(elapsedTime, 1e-9) << "% of a CPU" << endl;
+
+	setAllLights(false);
+
+	return result;
+}
+
+// Suspend a game until the given time
+GameAwaiter waitUntil (GameContext* context, double deadline) {
+	GameAwaiter awaiter = {context->scheduler, context->slot, deadline, false};
+
+	return awaiter;
+}
+
+// Suspend a game until the given time or until the button is pressed
+GameAwaiter waitForPress (GameContext* context, double deadline) {
+	GameAwaiter awaiter = {context->scheduler, context->slot, deadline, true};
+
+	return awaiter;
+}
+
+// Play a single game as a coroutine
+GameTask playGame(GameContext* context) {
+	sysLog.sysLog <<
+		"[playGame] Entered playGame state" << endl;
+
+	// Check for null pointers
+	if (context == NULL || context->stats == NULL || context->game == NULL) {
+		sysLog.sysLog <<
+			"[playGame] ERROR: Null pointer detected" << endl;
+
+		co_return false;
+	}
+
+	GameScheduler* scheduler = context->scheduler;
+	Statistics* stats = context->stats;
+	GameData* game = context->game;
+	StatsJournal* journal = context->journal;
+	double gameStartTime = scheduler->now();
+	int initialHighScore = stats->highScore;
+	AnimationPlayer animation;  // Player of the effects between levels
+	int animationState = 0;
+	double stepTime = 0;        // Time the light moved to its position
+	double previousStepTime = 0; // Time it moved to the one before
+	int round = 0;              // Number of levels played in this game
+	int step = 0;               // Number of light steps in this level
+	double outageStartTime = -1; // Time the button stopped being read
+	int initialPresses = stats->timesPressed;
+	int initialLivesLost = stats->totalLivesLost;
+
+	// Start the record of the session
+	SessionRecord session;
+
+	session.startTime = time(NULL);
+	session.presses   = stats->timesPressed;
+	session.livesLost = stats->totalLivesLost;
+
+	for (int level = 0; level < MAX_HISTORY_LEVELS; level++) {
+		session.timePerLight[level] = NAN;
+	}
+
+	publishEvent(context, STREAM_GAME_STARTED, 0);
+
+	if (context->display != NULL) {
+		context->display->showScores(game->currentLevel, stats->highScore);
+	}
+
+	bool isStopped = false;
+
+	sysLog.sysLog <<
+		"[playGame] Entering life loop" << endl;
+
+	// Loop until there are no lives remaining
+	while (game->numLivesRemaining > 0 && !isStopped) {
+		bool passedLevel = true;
+
+		sysLog.sysLog <<
+			"[playGame] Entering passedLevel loop" << endl;
+
+		// Loop through levels until the level is failed
+		while (passedLevel && !isStopped) {
+			bool levelEnded = false;
+			passedLevel = false;
+
+			// Clear lights array
+			sysLog.sysLog << "[playGame] " <<
+				"Clear lights array" << endl;
+
+			clearLightStates(game);
+
+			sysLog.sysLog <<
+				"[playGame] Set random direction" << endl;
+			setRandomDirection(game);
+
+			// Handle errors in updating light strip
+			if (context->usesHardware && !updateLightStrip(game->lightStates)) {
+				sysLog.sysLog << "[playGame] " <<
+					"ERROR: Light could not be set" << endl;
+
+				co_return false;
+			}
+
+			// Set initial deadlines
+			sysLog.sysLog <<
+				"[playGame] Setting level and light deadlines" << endl;
+
+			double levelStartTime = scheduler->now();
+			game->lightDeadline = levelStartTime + game->timePerLight;
+			stepTime = levelStartTime;
+			previousStepTime = levelStartTime;
+
+			if (game->currentLevel < MAX_HISTORY_LEVELS) {
+				session.timePerLight[game->currentLevel] = game->timePerLight;
+			}
+			game->levelDeadline = levelStartTime + game->timePerLevel;
+
+			// Let a simulated player decide when to press
+			if (context->player != NULL) {
+				context->player->planPress(context, levelStartTime);
+			}
+
+			step = 0;
+
+			if (context->replayer != NULL) {
+				context->replayer->onLightStep(context, round, step);
+			}
+
+			if (context->sharedState != NULL) {
+				context->sharedState->publish(stats, game, true);
+			}
+
+			// Loop through lights until the level is finished
+			sysLog.sysLog <<
+				"[playGame] Entering light-update loop" << endl;
+
+			while (!levelEnded) {
+				GameEvent event = co_await waitForPress(context,
+					min(game->lightDeadline, game->levelDeadline));
+
+				// Try a failed read again, as the pins may recover
+				if (event == EVENT_INPUT_ERROR) {
+					if (!retryInput("[playGame] ", &outageStartTime,
+							scheduler->now())) {
+						co_return false;
+					}
+
+					co_await waitUntil(context, min(scheduler->now() +
+						BUTTON_RECHECK_INTERVAL / 1000.0,
+						min(game->lightDeadline, game->levelDeadline)));
+
+					continue;
+				}
+
+				// A deadline does not read the button, so check that the
+				// pins have recovered before ending an outage
+				if (event == EVENT_PRESS ||
+						(outageStartTime >= 0 && buttonIsPressed() != -1)) {
+					endInputOutage("[playGame] ", &outageStartTime,
+						scheduler->now());
+				}
+
+				// End the game early if the control socket asked to
+				if ((context->control != NULL &&
+						context->control->stopRequested()) ||
+						(context->replayer != NULL &&
+						context->replayer->stopRequested())) {
+					sysLog.sysLog << "[playGame] " <<
+						"Stop requested - ending game" << endl;
+
+					isStopped = true;
+
+					if (context->recorder != NULL) {
+						context->recorder->recordStop(round, step,
+							scheduler->now() - stepTime);
+					}
+
+					break;
+				}
+
+				// Update lights if it is time to update the lights
+				if (scheduler->now() >= game->lightDeadline) {
+					updateLightPosition(game);
+
+					// Handle errors in updating light strip
+					if (context->usesHardware &&
+							!updateLightStrip(game->lightStates)) {
+						sysLog.sysLog << "[playGame] " <<
+							"ERROR: Light could not be set" << endl;
+
+						co_return false;
+					}
+
+					static LogLimit stepLimit("[playGame] ", "light step");
+
+					if (stepLimit.allow()) {
+						sysLog.sysLog <<
+							"[playGame] Updating light position" << endl;
+					}
+
+					previousStepTime = stepTime;
+					stepTime = scheduler->now();
+					game->lightDeadline = stepTime + game->timePerLight;
+					step++;
+					publishEvent(context, STREAM_LIGHT_STEP,
+						game->currentLightPosition);
+
+					if (context->replayer != NULL) {
+						context->replayer->onLightStep(context, round, step);
+					}
+
+					if (context->sharedState != NULL) {
+						context->sharedState->publish(stats, game, true);
+					}
+				}
+
+				// Handle button press
+				if (event == EVENT_PRESS) {
+					double pressTime = scheduler->lastPressTime(context->slot);
+					bool isPassing;
+
+					sysLog.sysLog <<
+						"[playGame] Button press detected" << endl;
+
+					// Record the press against the light step it is judged
+					// in, and take a replayed press's stamp from the recording
+					if (context->recorder != NULL) {
+						context->recorder->recordPress(round, step,
+							pressTime - stepTime, game->currentLightPosition);
+					}
+
+					if (context->replayer != NULL) {
+						pressTime = stepTime + context->replayer->checkPress(
+							game->currentLightPosition);
+					}
+
+					stats->timesPressed++;
+					publishEvent(context, STREAM_PRESS,
+						game->currentLightPosition);
+
+					if (journal != NULL) {
+						journal->recordPress();
+					}
+
+					if (context->sketches != NULL) {
+						context->sketches->recordPress(game->currentLevel,
+							game->isMovingRight,
+							pressTimingError(game, pressTime));
+					}
+
+					// Grade the press by its timing in precision mode
+					if (scoresPrecision) {
+						double timingError = 0;
+						PressGrade grade = gradePress(game, pressTime,
+							stepTime, previousStepTime, &timingError);
+
+						isPassing = (grade != GRADE_MISS);
+						game->precisionScore += PRESS_GRADE_POINTS[grade];
+
+						sysLog.sysLog << "[playGame] " <<
+							PRESS_GRADE_NAMES[grade] << " press " <<
+							timingError * 1000 << " ms after the light " <<
+							"entered its position - precision score " <<
+							game->precisionScore << endl;
+					} else {
+						isPassing = (game->isMovingRight &&
+							game->currentLightPosition == TARGET_INDEX + 1) ||
+							(!game->isMovingRight &&
+							game->currentLightPosition == TARGET_INDEX - 1);
+					}
+
+					// Signify that the game has failed if the
+					// incorrect light is on
+					if (!isPassing) {
+
+						sysLog.sysLog <<
+							"[playGame] Incorrect position detected: " <<
+							game->currentLightPosition << ", expecting " <<
+							TARGET_INDEX << endl;
+
+						passedLevel = false;
+						stats->totalLivesLost++;
+
+						if (journal != NULL) {
+							journal->recordLifeLost();
+						}
+					} else {
+						passedLevel = true;
+					}
+
+					levelEnded = true;
+
+				// Level has failed if time runs out
+				} else if (scheduler->now() >= game->levelDeadline) {
+					levelEnded = true;
+					passedLevel = false;
+					stats->totalLivesLost++;
+
+					if (journal != NULL) {
+						journal->recordLifeLost();
+					}
+				}
+			}
+
+			sysLog.sysLog <<
+				"[playGame] Exiting light-update loop" << endl;
+
+			round++;
+
+			if (isStopped) {
+				break;
+			}
+
+			if (context->sharedState != NULL) {
+				context->sharedState->publish(stats, game, true);
+			}
+
+			// Pause for a moment, blinking the target if the level failed
+			sysLog.sysLog <<
+				"[playGame] Pausing for " <<
+				DEFAULT_PAUSE_TIME << " second(s)" << endl;
+
+			if (passedLevel) {
+				co_await waitUntil(context,
+					scheduler->now() + DEFAULT_PAUSE_TIME);
+			} else {
+				animation.start(&LOSE_ANIMATION, scheduler->now(), false,
+					context->usesHardware);
+
+				while ((animationState = animation.step(scheduler->now())) > 0) {
+					co_await waitUntil(context, animation.getDeadline());
+				}
+
+				if (animationState < 0) {
+					sysLog.sysLog << "[playGame] " <<
+						"ERROR: Lose animation could not be played" << endl;
+
+					co_return false;
+				}
+			}
+
+			// Make the level's records durable while nothing is moving
+			if (journal != NULL) {
+				journal->sync();
+			}
+
+			//Check if passedLevel
+			if (passedLevel) {
+				// Play an animation to indicate success
+				sysLog.sysLog << "[playGame] " <<
+					"Play level-up animation to indicate success" << endl;
+
+				animation.start(&LEVEL_UP_ANIMATION, scheduler->now(), false,
+					context->usesHardware);
+
+				while ((animationState = animation.step(scheduler->now())) > 0) {
+					co_await waitUntil(context, animation.getDeadline());
+				}
+
+				if (animationState < 0) {
+					sysLog.sysLog << "[playGame] " <<
+						"ERROR: Level-up animation could not be played" << endl;
+
+					co_return false;
+				}
+
+				sysLog.sysLog <<
+					"[playGame] Level passed" << endl;
+
+				// Speed up level
+				sysLog.sysLog <<
+					"[playGame] Speed up level" << endl;
+				updateLightDuration(game);
+
+				// Update current level
+				game->currentLevel++;
+				sysLog.sysLog <<
+					"[playGame] Current level set to "
+					<< game->currentLevel << endl;
+				publishEvent(context, STREAM_LEVEL_PASSED, game->currentLevel);
+
+				// Stop games without a person at the button at the level
+				// cap, as a player who never misses would play forever
+				if (!context->usesHardware &&
+						game->currentLevel >= MAX_SIMULATED_LEVELS) {
+					sysLog.sysLog << "[playGame] " <<
+						"Level cap reached - ending game" << endl;
+
+					isStopped = true;
+				}
+
+				// Update high score and session score
+				int previousHighScore = stats->highScore;
+				int previousPrecisionHighScore = stats->precisionHighScore;
+
+				// Check for errors
+				if (!highScoreFunc(stats, game)) {
+					sysLog.sysLog << "[playGame] " <<
+						"ERROR: High score could not be updated" << endl;
+
+					co_return false;
+				}
+
+				if (stats->highScore != previousHighScore) {
+					publishEvent(context, STREAM_HIGH_SCORE, stats->highScore);
+
+					if (journal != NULL) {
+						journal->recordHighScore(stats->highScore);
+					}
+				}
+
+				if (stats->precisionHighScore != previousPrecisionHighScore &&
+						journal != NULL) {
+					journal->recordPrecisionHighScore(
+						stats->precisionHighScore);
+				}
+
+				if (context->sharedState != NULL) {
+					context->sharedState->publish(stats, game, true);
+				}
+
+				if (context->display != NULL) {
+					context->display->showScores(game->currentLevel,
+						stats->highScore);
+				}
+			}
+		}
+
+		sysLog.sysLog <<
+			"[playGame] Exiting passedLevel loop" << endl;
+
+		if (isStopped) {
+			break;
+		}
+
+		// Decrement number of lives
+		game->numLivesRemaining -= 1;
+
+		sysLog.sysLog <<
+			"[playGame] Number of lives set to " <<
+			game->numLivesRemaining << endl;
+		publishEvent(context, STREAM_LIFE_LOST, game->numLivesRemaining);
+
+		if (context->sharedState != NULL) {
+			context->sharedState->publish(stats, game, true);
+		}
+	}
+
+	sysLog.sysLog <<
+		"[playGame] Exiting life loop" << endl;
+	sysLog.sysLog <<
+		"[playGame] Game ended with final score "
+		<< game->currentLevel << endl;
+
+	if (scoresPrecision) {
+		sysLog.sysLog <<
+			"[playGame] Game ended with precision score " <<
+			game->precisionScore << endl;
+	}
+	publishEvent(context, STREAM_GAME_ENDED, game->currentLevel);
+
+	// Close the recording of the game, or compare it with the recording
+	if (context->recorder != NULL) {
+		context->recorder->endGame(game->currentLevel,
+			stats->timesPressed - initialPresses,
+			stats->totalLivesLost - initialLivesLost);
+	}
+
+	if (context->replayer != NULL) {
+		context->replayer->endGame(game->currentLevel,
+			stats->timesPressed - initialPresses,
+			stats->totalLivesLost - initialLivesLost);
+	}
+
+	// Add the length of the game to the statistics
+	float gameTime = scheduler->now() - gameStartTime;
+
+	playTime(stats, gameTime);
+
+	if (journal != NULL) {
+		journal->recordPlayTime(gameTime);
+
+		// Fold the journal into the statistics file once it has grown
+		if (journal->needsCompaction()) {
+			journal->compact(stats);
+		} else {
+			journal->sync();
+		}
+	}
+
+	if (game->leaderboardRecord >= 0) {
+		leaderboard.sync();
+	}
+
+	// Add the record of the session to the history
+	if (context->history != NULL) {
+		session.duration  = gameTime;
+		session.level     = game->currentLevel;
+		session.presses   = stats->timesPressed - session.presses;
+		session.livesLost = stats->totalLivesLost - session.livesLost;
+
+		if (!context->history->append(session)) {
+			sysLog.sysLog << "[playGame] " <<
+				"Warning: Session could not be added to the history" << endl;
+		}
+	}
+
+	// Celebrate a new high score, or flash the lights at the end of the game
+	if (context->usesHardware) {
+		animation.start((stats->highScore > initialHighScore) ?
+			(&WIN_ANIMATION) : (&FLASH_ANIMATION), scheduler->now(), false,
+			true);
+
+		while ((animationState = animation.step(scheduler->now())) > 0) {
+			co_await waitUntil(context, animation.getDeadline());
+		}
+
+		if (animationState < 0) {
+			sysLog.sysLog << "[playGame] " <<
+				"ERROR: Game-over animation could not be played" << endl;
+
+			co_return false;
+		}
+	}
+
+	// Reset game
+	sysLog.sysLog << "[playGame] " <<
+		"Resetting game" << endl;
+
+	if ((context->usesHardware && !reset(game)) ||
+			(!context->usesHardware && !resetGameData(game))) {
+		sysLog.sysLog << "[playGame] " <<
+			"ERROR: Game could not be reset" << endl;
+
+		co_return false;
+	}
+
+	if (context->sharedState != NULL) {
+		context->sharedState->publish(stats, game, false);
+		context->sharedState->publishLeaderboard(&leaderboard);
+	}
+
+	if (context->display != NULL) {
+		context->display->showScores(game->currentLevel, stats->highScore);
+	}
+
+	co_return true;
+}
+
+// Publish an event of a game to the event stream, if it has one
+void publishEvent(GameContext* context, StreamEventType type, int value) {
+	if (context->events != NULL) {
+		context->events->publish(type, value, context->scheduler->now());
+	}
+}
+
+// Play the game
+bool gameLoopPlay(Statistics* stats, GameData* game) {
+	sysLog.sysLog <<
+		"[gameLoopPlay] Entered gameLoopPlay state" << endl;
+
+	// Check for null pointers
+	if (stats == NULL || game == NULL) {
+		sysLog.sysLog <<
+			"[gameLoopPlay] ERROR: Null pointer detected" << endl;
+
+		return false;
+	}
+
+	// Run the game on a scheduler which follows the real clock and the
+	// button
+	GameScheduler scheduler(false);
+	GameContext context = {&scheduler, -1, stats, game, true, NULL,
+		&statsJournal, &reactionSketches, &sessionHistory, &sharedState,
+		&gameEvents, &controlServer,
+		(segmentDisplay.isOpen()) ? (&segmentDisplay) : (NULL),
+		(inputRecorder.isOpen()) ? (&inputRecorder) : (NULL), NULL};
+
+	// Seed the directions of the levels, so that a recording of the game
+	// can replay it
+	game->randomState = std::random_device()();
+
+	if (inputRecorder.isOpen()) {
+		inputRecorder.startGame(game->randomState, time(NULL));
+	}
+
+	// Record the session in the leaderboard
+	game->leaderboardRecord = leaderboard.addSession(playerName, time(NULL));
+
+	context.slot = scheduler.spawn(playGame(&context));
+	scheduler.setHardwareSlot(context.slot);
+
+	if (!scheduler.run()) {
+		sysLog.sysLog << "[gameLoopPlay] " <<
+			"ERROR: Game ended in error" << endl;
+
+		return false;
+	}
+
+	// Keep the press timing of the game
+	if (!reactionSketches.write(SKETCH_FILE)) {
+		sysLog.sysLog << "[gameLoopPlay] " <<
+			"Warning: Press timing could not be saved" << endl;
+	}
+
+	return true;
+}
+
+// Play a head-to-head game, in which two players race to press as their
+// lights, mirror images of each other on the shared strip, pass the target
+bool gameLoopHeadToHead(GameData* game) {
+	sysLog.sysLog <<
+		"[gameLoopHeadToHead] Entered gameLoopHeadToHead state" << endl;
+
+	// Check for null pointer
+	if (game == NULL) {
+		sysLog.sysLog <<
+			"[gameLoopHeadToHead] ERROR: Null pointer detected" << endl;
+
+		return false;
+	}
+
+	// Check for the second button
+	if (!dualButtons.isOpen()) {
+		sysLog.sysLog << "[gameLoopHeadToHead] " <<
+			"ERROR: The second button is not set up" << endl;
+
+		return false;
+	}
+
+	int roundsWon[NUM_PLAYERS];
+	int livesRemaining[NUM_PLAYERS];
+	ButtonEdge edges[NUM_PLAYERS];
+	int numSameFrame = 0;       // Number of frames both players pressed in
+	double totalMargin = 0;     // Time between the presses in those frames
+	double gameStartTime = monotonicTime();
+
+	for (int player = 0; player < NUM_PLAYERS; player++) {
+		roundsWon[player] = 0;
+		livesRemaining[player] = gameDifficulty.initialNumLives;
+	}
+
+	segmentDisplay.showScores(0, 0);
+
+	// Loop until a player has won enough rounds or has no lives remaining
+	while (livesRemaining[0] > 0 && livesRemaining[1] > 0 &&
+			max(roundsWon[0], roundsWon[1]) < HEAD_TO_HEAD_ROUNDS &&
+			!controlServer.stopRequested()) {
+		int winner = -1;
+		bool roundEnded = false;
+
+		// Ignore presses made between rounds
+		dualButtons.collect(edges);
+
+		clearLightStates(game);
+		setRandomDirection(game);
+
+		if (!updateMirroredLightStrip(game)) {
+			sysLog.sysLog << "[gameLoopHeadToHead] " <<
+				"ERROR: Light could not be set" << endl;
+
+			return false;
+		}
+
+		int previousPosition = game->currentLightPosition;
+		double stepTime = monotonicTime();
+
+		game->lightDeadline = stepTime + game->timePerLight;
+		game->levelDeadline = stepTime + game->timePerLevel;
+
+		while (!roundEnded) {
+			double remaining = min(game->lightDeadline, game->levelDeadline) -
+				monotonicTime();
+
+			// Sleep until a button is pressed or the light is due to move
+			if (remaining > 0) {
+				timespec timeout = {(time_t) remaining,
+					(long) ((remaining - floor(remaining)) * 1e9)};
+				pollfd edgeEvent = {dualButtons.getEdgeFileDescriptor(),
+					POLLIN, 0};
+
+				if (ppoll(&edgeEvent, 1, &timeout, NULL) < 0 &&
+						errno != EINTR) {
+					sysLog.sysLog << "[gameLoopHeadToHead] " <<
+						"ERROR: Buttons could not be waited for" << endl;
+
+					return false;
+				}
+			}
+
+			// Move the lights if it is time to, remembering when they moved
+			// so that presses stamped before then are judged on the old
+			// position
+			if (monotonicTime() >= game->lightDeadline) {
+				previousPosition = game->currentLightPosition;
+				stepTime = monotonicTime();
+				updateLightPosition(game);
+
+				if (!updateMirroredLightStrip(game)) {
+					sysLog.sysLog << "[gameLoopHeadToHead] " <<
+						"ERROR: Light could not be set" << endl;
+
+					return false;
+				}
+
+				game->lightDeadline = stepTime + game->timePerLight;
+			}
+
+			int numEdges = dualButtons.collect(edges);
+
+			// Give the other player the rest of the frame to press, so that
+			// presses close together are judged in the order they happened
+			if (numEdges == 1) {
+				sleepUntil(edges[0].time + HEAD_TO_HEAD_FRAME_TIME);
+				numEdges += dualButtons.collect(edges + 1);
+
+				if (numEdges == NUM_PLAYERS && edges[1].time < edges[0].time) {
+					swap(edges[0], edges[1]);
+				}
+			}
+
+			if (numEdges == NUM_PLAYERS) {
+				numSameFrame++;
+				totalMargin += edges[1].time - edges[0].time;
+
+				sysLog.sysLog << "[gameLoopHeadToHead] " <<
+					"Both players pressed in one frame - player " <<
+					edges[0].player + 1 << " was first by " <<
+					(edges[1].time - edges[0].time) * 1000 << " ms" << endl;
+			}
+
+			// Judge the presses in the order in which they happened
+			for (int i = 0; i < numEdges; i++) {
+				int player = edges[i].player;
+				int position = (edges[i].time < stepTime) ?
+					(previousPosition) : (game->currentLightPosition);
+
+				playerStats[player].timesPressed++;
+
+				if (!pressPassesHeadToHead(player, position,
+						game->isMovingRight)) {
+					sysLog.sysLog << "[gameLoopHeadToHead] " <<
+						"Player " << player + 1 << " pressed at the " <<
+						"incorrect position: " << position << endl;
+
+					livesRemaining[player]--;
+					playerStats[player].totalLivesLost++;
+
+					if (livesRemaining[player] == 0) {
+						roundEnded = true;
+					}
+
+				// Only the first press which passes wins the round
+				} else if (winner < 0) {
+					winner = player;
+					roundEnded = true;
+				}
+			}
+
+			// Nobody wins the round if time runs out
+			if (monotonicTime() >= game->levelDeadline) {
+				roundEnded = true;
+			}
+		}
+
+		if (winner >= 0) {
+			roundsWon[winner]++;
+			playerStats[winner].highScore =
+				max(playerStats[winner].highScore, roundsWon[winner]);
+
+			sysLog.sysLog << "[gameLoopHeadToHead] " <<
+				"Player " << winner + 1 << " won the round - score " <<
+				roundsWon[0] << " to " << roundsWon[1] << endl;
+
+			updateLightDuration(game);
+			segmentDisplay.showScores(roundsWon[0], roundsWon[1]);
+		}
+
+		// Light the winner's half of the strip for a moment
+		for (int i = 0; i < TOTAL_NUM_LIGHTS; i++) {
+			game->lightStates[i] = (winner == 0 && i < TARGET_INDEX) ||
+				(winner == 1 && i > TARGET_INDEX);
+		}
+
+		if (!updateLightStrip(game->lightStates)) {
+			sysLog.sysLog << "[gameLoopHeadToHead] " <<
+				"ERROR: Light could not be set" << endl;
+
+			return false;
+		}
+
+		sleep(DEFAULT_PAUSE_TIME);
+	}
+
+	float gameTime = monotonicTime() - gameStartTime;
+
+	sysLog.sysLog << "[gameLoopHeadToHead] " <<
+		"Game ended with a score of " << roundsWon[0] << " to " <<
+		roundsWon[1] << ", " << numSameFrame << " frame(s) pressed by " <<
+		"both players " << ((numSameFrame > 0) ?
+			(totalMargin / numSameFrame * 1000) : (0)) << " ms apart " <<
+		"on average" << endl;
+
+	for (int player = 0; player < NUM_PLAYERS; player++) {
+		playTime(&playerStats[player], gameTime);
+
+		sysLog.sysLog << "[gameLoopHeadToHead] " <<
+			"Player " << player + 1 << ": " <<
+			playerStats[player].timesPressed << " press(es), " <<
+			playerStats[player].totalLivesLost << " lives lost, " <<
+			"best score " << playerStats[player].highScore << endl;
+	}
+
+	dualButtons.logStatistics();
+
+	// Reset game
+	if (!reset(game)) {
+		sysLog.sysLog << "[gameLoopHeadToHead] " <<
+			"ERROR: Game could not be reset" << endl;
+
+		return false;
+	}
+
+	return true;
+}
+
+// Simulate many games with synthetic players on a single thread
+bool simulateGames(int numGames, double errorStdDev,
+		const char* recordingFile) {
+	// Structure for holding the data of a single simulated game
+	struct SimulatedGame {
+		GameContext context;
+		Statistics  stats;
+		GameData    game;
+	};
+
+	sysLog.sysLog << "[simulateGames] " <<
+		"Simulating " << numGames << " game(s)" << endl;
+
+	// Check for invalid arguments
+	if (numGames <= 0 || errorStdDev < 0) {
+		sysLog.sysLog << "[simulateGames] " <<
+			"ERROR: Received invalid arguments" << endl;
+
+		return false;
+	}
+
+	// Record the games' input if asked to
+	if (recordingFile != NULL && !inputRecorder.open(recordingFile)) {
+		cerr << "[simulateGames] ERROR: Could not open \"" << recordingFile <<
+			"\"" << endl;
+
+		return false;
+	}
+
+	GameScheduler scheduler(true);
+	SimulatedPlayer player(time(NULL), errorStdDev);
+	std::mt19937 seeder(time(NULL) + 1);
+	vector<SimulatedGame> games(numGames);
+	ReactionSketches sketches;
+
+	// Set up and run games without logging every step of every game
+	sysLog.setEnabled(false);
+
+	for (int i = 0; i < numGames; i++) {
+		SimulatedGame& simulated = games[i];
+
+		simulated.stats.highScore       = 0;
+		simulated.stats.totalTimePlayed = 0;
+		simulated.stats.timesPressed    = 0;
+		simulated.stats.totalLivesLost  = 0;
+		simulated.stats.journalSequence = 0;
+		simulated.stats.precisionHighScore = 0;
+
+		simulated.game.lightStates   = NULL;
+		simulated.game.isMovingRight = false;
+		simulated.game.randomState   = seeder();
+		resetGameData(&simulated.game);
+
+		InputRecorder* recorder = (recordingFile != NULL) ?
+			(&inputRecorder) : (NULL);
+		GameContext context = {&scheduler, -1, &simulated.stats,
+			&simulated.game, false, &player, NULL, &sketches, NULL, NULL,
+			NULL, NULL, NULL, recorder, NULL};
+
+		simulated.context = context;
+	}
+
+	double startTime = monotonicTime();
+	bool succeeded = true;
+
+	// A recording holds one game at a time, so recorded games are played
+	// one after another rather than all at once
+	if (recordingFile != NULL) {
+		for (int i = 0; i < numGames; i++) {
+			inputRecorder.startGame(games[i].game.randomState, time(NULL));
+			games[i].context.slot = scheduler.spawn(playGame(&games[i].context));
+			succeeded = scheduler.run() && succeeded;
+		}
+
+		inputRecorder.close();
+	} else {
+		for (int i = 0; i < numGames; i++) {
+			games[i].context.slot = scheduler.spawn(playGame(&games[i].context));
+		}
+
+		succeeded = scheduler.run();
+	}
+
+	sysLog.setEnabled(true);
+
+	double elapsedTime = monotonicTime() - startTime;
+
+	// Summarize the levels reached
+	vector<int> levelCounts;
+	double totalLevels = 0;
+
+	for (int i = 0; i < numGames; i++) {
+		int level = games[i].stats.highScore;
+
+		if (level >= (int) levelCounts.size()) {
+			levelCounts.resize(level + 1, 0);
+		}
+
+		levelCounts[level]++;
+		totalLevels += level;
+
+		delete[] games[i].game.lightStates;
+	}
+
+	cout << "Simulated " << numGames << " game(s) in " << elapsedTime <<
+		" second(s) (" << numGames / elapsedTime << " games/second)" << endl;
+	cout << "Average level reached: " << totalLevels / numGames << endl;
+
+	for (size_t level = 0; level < levelCounts.size(); level++) {
+		cout << "Level " << level << ": " << levelCounts[level] << endl;
+	}
+
+	// Report how accurate the synthetic presses were
+	sketches.report(cout);
+
+	// Report how many deadlines expired together
+	TimerWheel* timers = scheduler.getTimers();
+
+	cout << "Timers expired: " << timers->getTotalExpired() <<
+		" (at most " << timers->getMaxExpiriesPerTick() << " per tick)" << endl;
+
+	for (int i = 1; i <= MAX_TRACKED_EXPIRIES; i++) {
+		if (timers->getTickExpiryCount(i) > 0) {
+			cout << "Ticks with " << i <<
+				((i == MAX_TRACKED_EXPIRIES) ? ("+") : ("")) <<
+				" expiries: " << timers->getTickExpiryCount(i) << endl;
+		}
+	}
+
+	sysLog.sysLog << "[simulateGames] " <<
+		scheduler.getNumFailed() << " game(s) ended in error" << endl;
+
+	return succeeded;
+}
+
+// Replay the games of an input recording in virtual time, and check that
+// each one ends as it did when it was played
+bool replayGames(const char* fileName) {
+	InputReplayer replayer;
+	RecordedGame recorded;
+	int numGames = 0;
+	int numMatched = 0;
+	double totalGameTime = 0;
+	double totalElapsedTime = 0;
+
+	// Check for a readable recording
+	if (!replayer.open(fileName)) {
+		return false;
+	}
+
+	sysLog.setEnabled(false);
+
+	while (replayer.readGame(&recorded)) {
+		Statistics stats;
+		GameData game;
+
+		// Play the game with the settings it was recorded with
+		gameDifficulty = recorded.difficulty;
+		scoresPrecision = recorded.scoresPrecision;
+
+		stats.highScore          = 0;
+		stats.totalTimePlayed    = 0;
+		stats.timesPressed       = 0;
+		stats.totalLivesLost     = 0;
+		stats.journalSequence    = 0;
+		stats.precisionHighScore = 0;
+
+		game.lightStates   = NULL;
+		game.isMovingRight = false;
+		game.randomState   = recorded.seed;
+		resetGameData(&game);
+
+		GameScheduler scheduler(true);
+		GameContext context = {&scheduler, -1, &stats, &game, false, NULL,
+			NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, &replayer};
+
+		replayer.startGame(recorded);
+
+		double startTime = monotonicTime();
+
+		context.slot = scheduler.spawn(playGame(&context));
+
+		bool succeeded = scheduler.run();
+
+		totalElapsedTime += monotonicTime() - startTime;
+		totalGameTime += stats.totalTimePlayed;
+		numGames++;
+
+		if (succeeded && replayer.matches()) {
+			numMatched++;
+		} else {
+			cout << "Game " << numGames << " diverged: level " <<
+				game.currentLevel << " (recorded " << recorded.level <<
+				"), " << stats.timesPressed << " press(es) (recorded " <<
+				recorded.presses << "), " << stats.totalLivesLost <<
+				" lives lost (recorded " << recorded.livesLost << "), " <<
+				replayer.getNumMismatches() << " press(es) judged elsewhere" <<
+				endl;
+		}
+	}
+
+	sysLog.setEnabled(true);
+
+	// Summarize the replay
+	cout << "Games replayed: " << numGames << endl;
+	cout << "Games matched: " << numMatched << endl;
+	cout << "Game time: " << totalGameTime << " s in " <<
+		totalElapsedTime * 1000 << " ms (" <<
+		((totalElapsedTime > 0) ? (totalGameTime / totalElapsedTime) : (0)) <<
+		"x real time)" << endl;
+	cout << "Recording size: " << replayer.getSize() << " bytes (" <<
+		((totalGameTime > 0) ?
+		(replayer.getSize() * 3600 / totalGameTime) : (0)) <<
+		" bytes per hour of play)" << endl;
+
+	return numMatched == numGames;
+}
+
+// Get the difficulty given by the global constants
+DifficultyConfig defaultDifficulty () {
+	DifficultyConfig config;
+
+	config.timePerLevel        = TIME_PER_LEVEL;
+	config.initialTimePerLight = INITIAL_TIME_PER_LIGHT;
+	config.scalingTimePerLight = SCALING_TIME_PER_LIGHT;
+	config.initialNumLives     = INITIAL_NUM_LIVES;
+
+	return config;
+}
+
+// Simulate many games with the vectorized batch simulator
+bool batchSimulateGames(int numGames, double errorStdDev) {
+	sysLog.sysLog << "[batchSimulateGames] " <<
+		"Simulating " << numGames << " game(s)" << endl;
+
+	// Check for invalid arguments
+	if (numGames <= 0 || errorStdDev < 0) {
+		sysLog.sysLog << "[batchSimulateGames] " <<
+			"ERROR: Received invalid arguments" << endl;
+
+		return false;
+	}
+
+	BatchSimulator simulator(defaultDifficulty(), errorStdDev, numGames,
+		time(NULL));
+
+	double startTime = monotonicTime();
+	simulator.run();
+	double elapsedTime = monotonicTime() - startTime;
+
+	// Summarize the levels reached
+	vector<long long> levelCounts;
+	double totalLevels = 0;
+
+	for (int i = 0; i < numGames; i++) {
+		int level = simulator.getLevelReached(i);
+
+		if (level >= (int) levelCounts.size()) {
+			levelCounts.resize(level + 1, 0);
+		}
+
+		levelCounts[level]++;
+		totalLevels += level;
+	}
+
+	cout << "Simulated " << numGames << " game(s) in " << elapsedTime <<
+		" second(s) (" << numGames / elapsedTime << " games/second)" << endl;
+	cout << "Average level reached: " << totalLevels / numGames << endl;
+
+	for (size_t level = 0; level < levelCounts.size(); level++) {
+		cout << "Level " << level << ": " << levelCounts[level] << endl;
+	}
 
 	return true;
 }
 
-// Helper function for GPIOHandler::concatenate
-// Get number of characters in a string
-int GPIOHandler::getLength (const char* string) {
-	sysLog.sysLog << "[GPIOHandler::getLength] " <<
-		"Entered function" << endl;
+// Structure for holding the results of simulating part of a sweep
+struct SweepChunk {
+	int      config;            // Index of the configuration played
+	int      numGames;          // Number of games in the chunk
+	unsigned seed;              // Seed for the chunk's players
+	double   totalLevels;       // Sum of the levels reached
+	double   totalSessionTime;  // Sum of the lengths of the games
+	double   totalLivesLost;    // Sum of the lives lost
+	double   totalTimesPressed; // Sum of the button presses
+};
 
-	// Check for null array
-	if (string == NULL) {
-		sysLog.sysLog << "[GPIOHandler::getLength] " <<
-			"ERROR: Received null string" << endl;
+// Structure for holding everything the tasks of a sweep need
+struct SweepContext {
+	vector<DifficultyConfig>* configs;
+	vector<SweepChunk>* chunks;
+	float errorStdDev;
+};
 
-		return -1;
+// Parse a range given as "start:end:step" or as a single value
+bool parseSweepRange(const char* text, vector<float>& values) {
+	float start;
+	float end;
+	float step;
+	int   numParsed = sscanf(text, "%f:%f:%f", &start, &end, &step);
+
+	values.clear();
+
+	if (numParsed == 1) {
+		values.push_back(start);
+
+		return true;
 	}
 
-	int length = 0;
+	// Check for an invalid range
+	if (numParsed != 3 || step <= 0 || end < start) {
+		sysLog.sysLog << "[parseSweepRange] " <<
+			"ERROR: Invalid range \"" << text << "\"" << endl;
 
-	// Count number of non-null characters
-	while (string[length] != 0) {
-		length++;
+		return false;
 	}
 
-	sysLog.sysLog << "[GPIOHandler::getLength] " <<
-		"Received string of " << length << " characters" << endl;
+	int numValues = floor((end - start) / step + 1e-4) + 1;
 
-	return length;
+	for (int i = 0; i < numValues; i++) {
+		values.push_back(start + i * step);
+	}
+
+	return true;
 }
 
-// Helper function for GPIOHandler constructor
-// Concatenate strings
-bool GPIOHandler::concatenate (const char* string1,
-		const char* string2, char*& output) {
+// Simulate one chunk of a sweep
+void runSweepChunk (void* context, int task) {
+	SweepContext* sweep = (SweepContext*) context;
+	SweepChunk& chunk = (*sweep->chunks)[task];
 
-	sysLog.sysLog << "[GPIOHandler::concatenate] " <<
+	BatchSimulator simulator((*sweep->configs)[chunk.config],
+		sweep->errorStdDev, chunk.numGames, chunk.seed);
+
+	simulator.run();
+
+	for (int i = 0; i < chunk.numGames; i++) {
+		chunk.totalLevels       += simulator.getLevelReached(i);
+		chunk.totalSessionTime  += simulator.getSessionTime(i);
+		chunk.totalLivesLost    += simulator.getLivesLost(i);
+		chunk.totalTimesPressed += simulator.getTimesPressed(i);
+	}
+}
+
+// Check that games played by a player who never misses stop exactly at
+// the level cap
+bool checkLevelCap () {
+	BatchSimulator simulator(defaultDifficulty(), 0, SIMULATION_LANES, 1);
+
+	simulator.run();
+
+	for (int i = 0; i < simulator.getNumGames(); i++) {
+		if (simulator.getLevelReached(i) != MAX_SIMULATED_LEVELS) {
+			cerr << "[checkLevelCap] ERROR: A player who never misses " <<
+				"stopped at level " << simulator.getLevelReached(i) <<
+				" rather than " << MAX_SIMULATED_LEVELS << endl;
+
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Simulate games over a grid of difficulty settings and write a CSV of
+// the expected results for each one
+bool sweepDifficulty(int argc, const char* const argv[]) {
+	const int GAMES_PER_CHUNK = 4096;
+
+	DifficultyConfig defaults = defaultDifficulty();
+	vector<float> lightTimes(1, defaults.initialTimePerLight);
+	vector<float> scalings(1, defaults.scalingTimePerLight);
+	vector<float> levelTimes(1, defaults.timePerLevel);
+	vector<float> lives(1, defaults.initialNumLives);
+	int   numGames    = 100000;
+	int   numWorkers  = 0;
+	float errorStdDev = 0.04;
+	const char* outputFileName = NULL;
+
+	sysLog.sysLog << "[sweepDifficulty] " <<
 		"Entered function" << endl;
 
-	int outputStringIndex = 0;
-	int inputStringIndex  = 0;
+	// Parse arguments
+	for (int i = 0; i < argc; i += 2) {
+		bool isValid = true;
 
-	// Check for null pointers
-	if (string1 == NULL || string2 == NULL) {
-		sysLog.sysLog << "[GPIOHandler::concatenate] " <<
-			"ERROR: Received null string" << endl;
+		// Check for an option without a value
+		if (i + 1 == argc) {
+			cerr << "[sweepDifficulty] ERROR: Missing value for \"" <<
+				argv[i] << "\"" << endl;
+
+			return false;
+		}
+
+		if (strcmp(argv[i], "--light") == 0) {
+			isValid = parseSweepRange(argv[i + 1], lightTimes);
+		} else if (strcmp(argv[i], "--scaling") == 0) {
+			isValid = parseSweepRange(argv[i + 1], scalings);
+		} else if (strcmp(argv[i], "--level") == 0) {
+			isValid = parseSweepRange(argv[i + 1], levelTimes);
+		} else if (strcmp(argv[i], "--lives") == 0) {
+			isValid = parseSweepRange(argv[i + 1], lives);
+		} else if (strcmp(argv[i], "--games") == 0) {
+			numGames = atoi(argv[i + 1]);
+		} else if (strcmp(argv[i], "--error") == 0) {
+			errorStdDev = atof(argv[i + 1]);
+		} else if (strcmp(argv[i], "--threads") == 0) {
+			numWorkers = atoi(argv[i + 1]);
+		} else if (strcmp(argv[i], "--output") == 0) {
+			outputFileName = argv[i + 1];
+		} else {
+			isValid = false;
+		}
+
+		if (!isValid) {
+			cerr << "[sweepDifficulty] ERROR: Invalid argument \"" <<
+				argv[i] << "\"" << endl;
+
+			return false;
+		}
+	}
+
+	if (numGames <= 0 || errorStdDev < 0) {
+		cerr << "[sweepDifficulty] ERROR: Invalid number of games or error" <<
+			endl;
 
 		return false;
 	}
 
-	int length = getLength(string1) + getLength(string2) + 1;
+	// Light durations must shrink as levels are passed, or a game could
+	// only end at the level cap
+	for (size_t i = 0; i < scalings.size(); i++) {
+		if (scalings[i] <= 0 || scalings[i] >= 1) {
+			cerr << "[sweepDifficulty] ERROR: Scaling must be between 0 " <<
+				"and 1" << endl;
 
-	output = new char[length];
+			return false;
+		}
+	}
 
-	// Copy string1 into outputString
-	while (string1[inputStringIndex] != 0) {
-		output[outputStringIndex] = string1[inputStringIndex];
-		outputStringIndex++;
-		inputStringIndex ++;
+	for (size_t i = 0; i < lightTimes.size(); i++) {
+		if (lightTimes[i] <= 0) {
+			cerr << "[sweepDifficulty] ERROR: Invalid light duration" << endl;
+
+			return false;
+		}
 	}
 
-	inputStringIndex = 0;
+	for (size_t i = 0; i < levelTimes.size(); i++) {
+		if (levelTimes[i] <= 0) {
+			cerr << "[sweepDifficulty] ERROR: Invalid level duration" << endl;
 
-	// Copy string2 into outputString
-	while (string2[inputStringIndex] != 0) {
-		output[outputStringIndex] = string2[inputStringIndex];
-		outputStringIndex++;
-		inputStringIndex ++;
+			return false;
+		}
 	}
 
-	// Null-terminate the string
-	output[outputStringIndex] = 0;
+	for (size_t i = 0; i < lives.size(); i++) {
+		if (lives[i] < 1) {
+			cerr << "[sweepDifficulty] ERROR: Invalid number of lives" << endl;
 
-	sysLog.sysLog << "[GPIOHandler::concatenate] " <<
-		"Concatenated string: \"" << output << "\"" << endl;
+			return false;
+		}
+	}
+
+	// Check that a player who never misses plays to the level cap, so
+	// games are only ended by the rules and not by rounding
+	if (!checkLevelCap()) {
+		return false;
+	}
+
+	// Build every combination of the settings
+	vector<DifficultyConfig> configs;
+
+	for (size_t a = 0; a < lightTimes.size(); a++) {
+		for (size_t b = 0; b < scalings.size(); b++) {
+			for (size_t c = 0; c < levelTimes.size(); c++) {
+				for (size_t d = 0; d < lives.size(); d++) {
+					DifficultyConfig config;
+
+					config.initialTimePerLight = lightTimes[a];
+					config.scalingTimePerLight = scalings[b];
+					config.timePerLevel        = levelTimes[c];
+					config.initialNumLives     = (int) lives[d];
+
+					configs.push_back(config);
+				}
+			}
+		}
+	}
+
+	// Split each configuration's games into chunks
+	vector<SweepChunk> chunks;
+	std::mt19937 seeder(time(NULL));
+
+	for (size_t config = 0; config < configs.size(); config++) {
+		for (int first = 0; first < numGames; first += GAMES_PER_CHUNK) {
+			SweepChunk chunk = {(int) config,
+				min(GAMES_PER_CHUNK, numGames - first), (unsigned) seeder(),
+				0, 0, 0, 0};
+
+			chunks.push_back(chunk);
+		}
+	}
+
+	// Simulate the chunks on every core
+	SweepContext context = {&configs, &chunks, errorStdDev};
+	WorkStealingPool pool(numWorkers);
+
+	double startTime = monotonicTime();
+	pool.run(chunks.size(), runSweepChunk, &context);
+	double elapsedTime = monotonicTime() - startTime;
+
+	// Add up the chunks of each configuration
+	vector<SweepChunk> totals(configs.size());
+
+	for (size_t config = 0; config < configs.size(); config++) {
+		SweepChunk empty = {(int) config, 0, 0, 0, 0, 0, 0};
+
+		totals[config] = empty;
+	}
+
+	for (size_t i = 0; i < chunks.size(); i++) {
+		SweepChunk& total = totals[chunks[i].config];
+
+		total.numGames          += chunks[i].numGames;
+		total.totalLevels       += chunks[i].totalLevels;
+		total.totalSessionTime  += chunks[i].totalSessionTime;
+		total.totalLivesLost    += chunks[i].totalLivesLost;
+		total.totalTimesPressed += chunks[i].totalTimesPressed;
+	}
+
+	// Write the results
+	ofstream outFile;
+
+	if (outputFileName != NULL) {
+		outFile.open(outputFileName);
+
+		if (!outFile.is_open()) {
+			cerr << "[sweepDifficulty] ERROR: Could not open \"" <<
+				outputFileName << "\"" << endl;
+
+			return false;
+		}
+	}
+
+	ostream& output = (outputFileName != NULL) ? (outFile) : (cout);
+
+	output << "initial_time_per_light,scaling_time_per_light," <<
+		"time_per_level,initial_num_lives,games,expected_high_score," <<
+		"expected_session_seconds,expected_lives_lost," <<
+		"expected_presses" << endl;
+
+	for (size_t config = 0; config < configs.size(); config++) {
+		SweepChunk& total = totals[config];
+
+		output << configs[config].initialTimePerLight << "," <<
+			configs[config].scalingTimePerLight << "," <<
+			configs[config].timePerLevel << "," <<
+			configs[config].initialNumLives << "," <<
+			total.numGames << "," <<
+			total.totalLevels / total.numGames << "," <<
+			total.totalSessionTime / total.numGames << "," <<
+			total.totalLivesLost / total.numGames << "," <<
+			total.totalTimesPressed / total.numGames << endl;
+	}
+
+	cerr << "Swept " << configs.size() << " configuration(s) of " <<
+		numGames << " game(s) in " << elapsedTime << " second(s) on " <<
+		pool.getNumWorkers() << " worker(s), " << pool.getNumStolen() <<
+		" chunk(s) stolen" << endl;
 
 	return true;
 }
 
-// GPIOHandler constructor given pinID
-GPIOHandler::GPIOHandler (int pinID) {
-	sysLog.sysLog << "[GPIOHandler::GPIOHandler] " <<
-		"Entered constructor" << endl;
+// Print the press timing spread from the sketch file, merged with the
+// sketch files of other cabinets
+bool printAccuracy(int numFiles, const char* const fileNames[]) {
+	ReactionSketches sketches;
 
-	this->valueFileName = NULL;
-	char* idString;
+	sketches.read(SKETCH_FILE);
 
-	// Handle invalid ID
-	if (!stringFromInt(pinID, idString) ||
-			!concatenate(GPIO_DIRECTORY, idString, this->directoryName)) {
+	for (int i = 0; i < numFiles; i++) {
+		if (!sketches.read(fileNames[i])) {
+			cerr << "[printAccuracy] ERROR: Could not read \"" <<
+				fileNames[i] << "\"" << endl;
 
-		sysLog.sysLog << "[GPIOHandler::GPIOHandler] " <<
-			"ERROR: Received invalid pinID: " << pinID << endl;
+			return false;
+		}
+	}
 
-		this->pinID = -1;
-	} else {
+	sketches.report(cout);
 
-		this->pinID = pinID;
+	return true;
+}
+
+// Merge the sketch files of other cabinets into the sketch file
+bool mergeSketches(int numFiles, const char* const fileNames[]) {
+	ReactionSketches sketches;
+
+	sketches.read(SKETCH_FILE);
+
+	for (int i = 0; i < numFiles; i++) {
+		if (!sketches.read(fileNames[i])) {
+			cerr << "[mergeSketches] ERROR: Could not read \"" <<
+				fileNames[i] << "\"" << endl;
+
+			return false;
+		}
 	}
+
+	return sketches.write(SKETCH_FILE);
 }
 
-// Default GPIOHandler constructor
-GPIOHandler::GPIOHandler () {
-	sysLog.sysLog << "[GPIOHandler::GPIOHandler] " <<
-		"Entered constructor" << endl;
+// Parse a date given as YYYY-MM-DD into local Unix time
+bool parseHistoryDate(const char* text, double* time) {
+	struct tm date;
 
-	this->pinID = -1;
-	this->directoryName = NULL;
-	this->valueFileName = NULL;
+	memset(&date, 0, sizeof(date));
+
+	if (strptime(text, "%Y-%m-%d", &date) == NULL) {
+		cerr << "[parseHistoryDate] ERROR: Invalid date: " << text << endl;
+
+		return false;
+	}
+
+	date.tm_isdst = -1;
+	*time = mktime(&date);
+
+	return true;
 }
 
-// GPIOHandler deconstructor
-GPIOHandler::~GPIOHandler () {
-	delete directoryName;
-	directoryName = NULL;
-	delete valueFileName;
-	valueFileName = NULL;
-	pinID = -1;
+// Find the column with the given name
+int findHistoryColumn(const char* name) {
+	const char* names[HISTORY_TIME_PER_LIGHT] =
+		{"start", "duration", "level", "presses", "lives"};
 
-	if (inFile.is_open()) {
-		inFile.close();
+	for (int column = 0; column < HISTORY_TIME_PER_LIGHT; column++) {
+		if (strcmp(name, names[column]) == 0) {
+			return column;
+		}
 	}
 
-	if (outFile.is_open()) {
-		outFile.close();
+	// Time per light is named by level, as in "light3"
+	if (strncmp(name, "light", 5) == 0 && name[5] != '\0') {
+		int level = atoi(name + 5);
+
+		if (level >= 0 && level < MAX_HISTORY_LEVELS) {
+			return HISTORY_TIME_PER_LIGHT + level;
+		}
 	}
+
+	return -1;
 }
 
-// Activate GPIO pin
-bool GPIOHandler::activate () {
-	sysLog.sysLog << "[GPIOHandler::activate] " <<
-		"Entered function" << endl;
+// Aggregate a column of the session history, optionally grouped by the
+// time the sessions started
+bool queryHistory(int argc, const char* const argv[]) {
+	// Structure for holding the aggregate of one group
+	struct HistoryAggregate {
+		int count;
+		double total;
+		double minimum;
+		double maximum;
+	};
 
-	// Check if object is valid
-	if (pinID < 0) {
-		sysLog.sysLog << "[GPIOHandler::activate] " <<
-			"ERROR: Received invalid pinID: " << pinID << endl;
+	const char* fileName = HISTORY_FILE;
+	const char* groupBy = "none";
+	double fromTime = -INFINITY;
+	double toTime = INFINITY;
+	double minLevel = -INFINITY;
+	int column = (argc >= 1) ? (findHistoryColumn(argv[0])) : (-1);
+
+	// Check for invalid column
+	if (column < 0) {
+		cerr << "[queryHistory] ERROR: Expected a column: start, duration, " <<
+			"level, presses, lives or light<level>" << endl;
 
 		return false;
 	}
 
-	// Check if pin has already been activated
-	inFile.open(directoryName);
+	// Parse options
+	for (int i = 1; i + 1 < argc; i += 2) {
+		bool isValid = true;
+
+		if (strcmp(argv[i], "--by") == 0) {
+			groupBy = argv[i + 1];
+		} else if (strcmp(argv[i], "--from") == 0) {
+			isValid = parseHistoryDate(argv[i + 1], &fromTime);
+		} else if (strcmp(argv[i], "--to") == 0) {
+			isValid = parseHistoryDate(argv[i + 1], &toTime);
+		} else if (strcmp(argv[i], "--min-level") == 0) {
+			minLevel = atoi(argv[i + 1]);
+		} else if (strcmp(argv[i], "--file") == 0) {
+			fileName = argv[i + 1];
+		} else {
+			cerr << "[queryHistory] ERROR: Unknown option: " << argv[i] << endl;
+			isValid = false;
+		}
 
-	if (inFile.is_open()) {
-		sysLog.sysLog << "[GPIOHandler::activate] " <<
-			"WARNING: GPIO pin has already been activated" << endl;
+		if (!isValid) {
+			return false;
+		}
+	}
 
-		return true;
+	const char* groupFormat = NULL;
+
+	if (strcmp(groupBy, "hour") == 0) {
+		groupFormat = "%H";
+	} else if (strcmp(groupBy, "weekday") == 0) {
+		groupFormat = "%a";
+	} else if (strcmp(groupBy, "day") == 0) {
+		groupFormat = "%Y-%m-%d";
+	} else if (strcmp(groupBy, "month") == 0) {
+		groupFormat = "%Y-%m";
+	} else if (strcmp(groupBy, "none") != 0) {
+		cerr << "[queryHistory] ERROR: Expected --by hour, weekday, day, " <<
+			"month or none" << endl;
+
+		return false;
 	}
 
-	inFile.close();
-	outFile.open(GPIO_EXPORT);
+	SessionHistory history;
 
-	// Check if export file was successfully opened
-	if (!outFile.is_open()) {
-		sysLog.sysLog << "[GPIOHandler::activate] " <<
-			"ERROR: Could not open \"" << GPIO_EXPORT << "\"" << endl;
+	if (!history.open(fileName, false)) {
+		cerr << "[queryHistory] ERROR: Could not open \"" << fileName << "\"" <<
+			endl;
 
 		return false;
 	}
 
-	// Activate GPIO pin
-	char* stringID;
+	bool filtersTime = (fromTime > -INFINITY || toTime < INFINITY);
+	bool filtersLevel = (minLevel > -INFINITY);
+	map<string, HistoryAggregate> groups;
+	vector<double> values(HISTORY_BLOCK_ROWS);
+	vector<double> startTimes(HISTORY_BLOCK_ROWS);
+	vector<double> levels(HISTORY_BLOCK_ROWS);
+	int numBlocksRead = 0;
 
-	sysLog.sysLog << "[GPIOHandler::activate] " <<
-		"Getting pinID as a string" << endl;
+	for (int block = 0; block < history.getNumBlocks(); block++) {
+		HistoryBlockHeader header;
 
-	// Check for valid pinID
-	if (!stringFromInt(pinID, stringID)) {
-		sysLog.sysLog << "[GPIOHandler::activate] " <<
-			"ERROR: Received invalid pinID " << endl;
+		if (!history.readHeader(block, &header)) {
+			cerr << "[queryHistory] ERROR: Block " << block <<
+				" is corrupted" << endl;
 
-		return false;
+			return false;
+		}
+
+		// Skip blocks which cannot hold a matching session
+		if (header.numRows == 0 || isnan(header.minimum[column]) ||
+				header.maximum[HISTORY_START_TIME] < fromTime ||
+				header.minimum[HISTORY_START_TIME] >= toTime ||
+				header.maximum[HISTORY_LEVEL] < minLevel) {
+			continue;
+		}
+
+		// Read only the columns the query needs
+		int numRows = header.numRows;
+		bool needsStartTimes = (groupFormat != NULL || filtersTime);
+
+		if (!history.readColumn(block, column, numRows, &values[0]) ||
+				(needsStartTimes && !history.readColumn(block,
+					HISTORY_START_TIME, numRows, &startTimes[0])) ||
+				(filtersLevel && !history.readColumn(block, HISTORY_LEVEL,
+					numRows, &levels[0]))) {
+			cerr << "[queryHistory] ERROR: Block " << block <<
+				" could not be read" << endl;
+
+			return false;
+		}
+
+		numBlocksRead++;
+
+		for (int row = 0; row < numRows; row++) {
+			if (isnan(values[row]) ||
+					(filtersTime && (startTimes[row] < fromTime ||
+						startTimes[row] >= toTime)) ||
+					(filtersLevel && levels[row] < minLevel)) {
+				continue;
+			}
+
+			char group[32] = "all";
+
+			if (groupFormat != NULL) {
+				time_t startTime = startTimes[row];
+
+				strftime(group, sizeof(group), groupFormat,
+					localtime(&startTime));
+			}
+
+			HistoryAggregate& aggregate = groups[group];
+
+			if (aggregate.count == 0) {
+				aggregate.minimum = values[row];
+				aggregate.maximum = values[row];
+			}
+
+			aggregate.count++;
+			aggregate.total  += values[row];
+			aggregate.minimum = min(aggregate.minimum, values[row]);
+			aggregate.maximum = max(aggregate.maximum, values[row]);
+		}
+	}
+
+	cout << groupBy << ",sessions,average,minimum,maximum" << endl;
+
+	for (map<string, HistoryAggregate>::iterator group = groups.begin();
+			group != groups.end(); group++) {
+		HistoryAggregate& aggregate = group->second;
+
+		cout << group->first << ',' << aggregate.count << ',' <<
+			aggregate.total / aggregate.count << ',' << aggregate.minimum <<
+			',' << aggregate.maximum << endl;
 	}
 
-	outFile << stringID;
-	outFile.close();
+	cerr << "Read " << numBlocksRead << " of " << history.getNumBlocks() <<
+		" block(s)" << endl;
 
 	return true;
 }
 
-// Deactivate GPIO pin
-bool GPIOHandler::deactivate () {
-	sysLog.sysLog << "[GPIOHandler::deactivate] " <<
-		"Entered function" << endl;
+// Print the state of a running game whenever it changes
+bool watchGame(float interval) {
+	SharedState reader;
+	SharedGameSnapshot snapshot;
+	unsigned int lastSequence = 0;
 
-	// Check if object is valid
-	if (pinID < 0) {
-		sysLog.sysLog << "[GPIOHandler::deactivate] " <<
-			"ERROR: Received invalid pinID: " << pinID << endl;
+	if (!reader.attach(SHARED_STATE_NAME)) {
+		cerr << "[watchGame] ERROR: No game is running" << endl;
 
 		return false;
 	}
 
-	// Check if pin has already been deactivated
-	inFile.open(directoryName);
+	while (reader.snapshot(&snapshot)) {
+		if (snapshot.sequence != lastSequence) {
+			lastSequence = snapshot.sequence;
+
+			cout << ((snapshot.isPlaying) ? ("playing") : ("idle")) <<
+				" level " << snapshot.currentLevel <<
+				" lives " << snapshot.numLivesRemaining <<
+				" light " << snapshot.currentLightPosition <<
+				((snapshot.isMovingRight) ? (" >") : (" <")) <<
+				" | high score " << snapshot.highScore <<
+				" presses " << snapshot.timesPressed <<
+				" lives lost " << snapshot.totalLivesLost;
+
+			for (int i = 0; i < snapshot.numTopScores; i++) {
+				cout << ((i == 0) ? (" | ") : (", ")) <<
+					snapshot.topPlayerNames[i] << ' ' << snapshot.topScores[i];
+			}
 
-	if (!inFile.is_open()) {
-		sysLog.sysLog << "[GPIOHandler::deactivate] " <<
-			"WARNING: GPIO pin has already been deactivated" << endl;
+			cout << endl;
+		}
 
-		return true;
+		usleep(interval * 1000000);
 	}
 
-	inFile.close();
+	return true;
+}
 
-	if (outFile.is_open()) {
-		outFile.close();
-	}
+// Print the events of a running game as they happen
+bool followEvents() {
+	const char* typeNames[NUM_STREAM_EVENT_TYPES] = {"game started",
+		"light step", "press", "level passed", "life lost", "high score",
+		"game ended"};
 
-	outFile.open(GPIO_UNEXPORT);
+	EventRing ring;
 
-	// Check if export file was successfully opened
-	if (!outFile.is_open()) {
-		sysLog.sysLog << "[GPIOHandler::deactivate] " <<
-			"ERROR: Could not open " << GPIO_UNEXPORT << endl;
+	if (!ring.attach(EVENT_RING_NAME)) {
+		cerr << "[followEvents] ERROR: No game is running" << endl;
 
 		return false;
 	}
 
-	// Deactivate GPIO pin
-	char* stringID;
+	EventSubscriber subscriber(&ring, false);
+	StreamEvent event;
 
-	sysLog.sysLog << "[GPIOHandler::deactivate] " <<
-		"Getting pinID as a string" << endl;
+	while (true) {
+		if (!subscriber.poll(&event)) {
+			usleep(1000);
 
-	stringFromInt(pinID, stringID);
-	outFile << stringID;
-	outFile.close();
+			continue;
+		}
+
+		cout << event.sequence << ' ' << event.time << ' ' <<
+			((event.type < NUM_STREAM_EVENT_TYPES) ?
+				(typeNames[event.type]) : ("unknown")) <<
+			' ' << event.value << " (lag " << subscriber.getLag() <<
+			", max lag " << subscriber.getMaxLag() << ", overrun " <<
+			subscriber.getNumOverrun() << ")" << endl;
+	}
 
 	return true;
 }
 
-// Designate GPIO pin to be either input or output
-bool GPIOHandler::setType (bool isInput) {
-	const char* IO_DIRECTION_FILE =
-		"/direction";
+// Take snapshots of the benchmark segment until the writer is done,
+// checking that each holds the fields of a single publish
+void checkSnapshots(SnapshotCheck* check) {
+	SharedGameSnapshot snapshot;
+	unsigned int lastSequence = 0;
+	int lastLevel = 0;
 
-	sysLog.sysLog << "[GPIOHandler::setType] " <<
-		"Entered function" << endl;
+	while (check->isRunning.load(memory_order_acquire)) {
+		if (!check->reader.snapshot(&snapshot)) {
+			break;
+		}
 
-	// Check if object is valid
-	if (pinID < 0) {
-		sysLog.sysLog << "[GPIOHandler::setType] " <<
-			"ERROR: Received invalid pinID: " << pinID << endl;
+		check->numSnapshots++;
 
-		return false;
-	}
+		// Skip the idle state the segment was created with
+		if (!snapshot.isPlaying || snapshot.sequence == lastSequence) {
+			continue;
+		}
 
-	char* directionFileName;
+		int level = snapshot.currentLevel;
+
+		check->numChanged++;
+		lastSequence = snapshot.sequence;
+
+		// Every field of publish k is derived from k, and k only rises
+		if (snapshot.numLivesRemaining != level + 1 ||
+				snapshot.currentLightPosition != level + 2 ||
+				snapshot.highScore != level + 3 ||
+				snapshot.timesPressed != level + 4 ||
+				snapshot.totalLivesLost != level + 5 ||
+				snapshot.isMovingRight != (bool) (level & 1) ||
+				snapshot.totalTimePlayed != (float) (level & 0xffff) ||
+				level < lastLevel) {
+			check->numTorn++;
+		}
 
-	sysLog.sysLog << "[GPIOHandler::setType] " <<
-		"Building path name" << endl;
+		lastLevel = level;
+	}
+}
 
-	// Check if path name was built correctly
-	if (!concatenate(directoryName, IO_DIRECTION_FILE, directionFileName)) {
-		sysLog.sysLog << "[GPIOHandler::setType] " <<
-			"ERROR: Path name could not be built" << endl;
+// Measure how long a publish to the shared state takes while a reader
+// spins on the segment, and check that no snapshot is torn
+bool benchmarkSharedState(int numPublishes) {
+	// Check for invalid argument
+	if (numPublishes <= 0 || numPublishes > INT_MAX - 5) {
+		cerr << "[benchmarkSharedState] ERROR: Invalid number of publishes" <<
+			endl;
 
 		return false;
 	}
 
-	outFile.open(directionFileName);
+	SharedState writer;
+	SnapshotCheck check;
 
-	// Check if file was opened properly
-	if (!outFile.is_open()) {
-		sysLog.sysLog << "[GPIOHandler::setType] " <<
-			"ERROR: IO direction file could not be opened" << endl;
+	if (!writer.create(SHARED_STATE_BENCHMARK_NAME) ||
+			!check.reader.attach(SHARED_STATE_BENCHMARK_NAME)) {
+		cerr << "[benchmarkSharedState] ERROR: Could not set up shared " <<
+			"memory" << endl;
+		writer.close();
+		shm_unlink(SHARED_STATE_BENCHMARK_NAME);
 
 		return false;
 	}
 
-	if (isInput) {
-		outFile << "in";
-	} else {
-		outFile << "out";
+	Statistics stats = {};
+	GameData game = {};
+
+	check.isRunning    = true;
+	check.numSnapshots = 0;
+	check.numChanged   = 0;
+	check.numTorn      = 0;
+
+	std::thread reader(checkSnapshots, &check);
+	double startTime = monotonicTime();
+
+	for (int k = 0; k < numPublishes; k++) {
+		game.currentLevel         = k;
+		game.numLivesRemaining    = k + 1;
+		game.currentLightPosition = k + 2;
+		game.isMovingRight        = k & 1;
+		stats.highScore           = k + 3;
+		stats.timesPressed        = k + 4;
+		stats.totalLivesLost      = k + 5;
+		stats.totalTimePlayed     = k & 0xffff;
+
+		writer.publish(&stats, &game, true);
 	}
 
-	sysLog.sysLog << "[GPIOHandler::setType] " <<
-		"Pin " << pinID << " set to " <<
-		((isInput) ? ("input") : ("output")) << endl;
+	double elapsedTime = monotonicTime() - startTime;
 
-	outFile.close();
+	check.isRunning.store(false, memory_order_release);
+	reader.join();
 
-	return true;
+	check.reader.close();
+	writer.close();
+	shm_unlink(SHARED_STATE_BENCHMARK_NAME);
+
+	cout << numPublishes << " publish(es) in " << elapsedTime <<
+		" second(s): " << elapsedTime / numPublishes * 1e9 <<
+		" ns per publish, " << check.numSnapshots << " snapshot(s) of " <<
+		check.numChanged << " distinct publish(es), " << check.numTorn <<
+		" torn" << endl;
+
+	return check.numTorn == 0;
 }
 
-// Get state of pin
-bool GPIOHandler::getState (bool& isOn) {
-	const char* IO_VALUE_FILE =
-		"/value";
+// Follow the benchmark segment until every event is read or counted as
+// overrun, checking that each event read is the one expected
+void checkEvents(EventCheck* check) {
+	const int EVENTS_PER_PAUSE = 256;
+	const double PAUSE_TIME = 0.0001;
 
-	/*sysLog.sysLog << "[GPIOHandler::getState] " <<
-		"Entered function" << endl;*/
+	EventSubscriber* subscriber = check->subscriber;
+	StreamEvent event;
 
-	// Check if object is valid
-	if (pinID < 0) {
-		sysLog.sysLog << "[GPIOHandler::getState] " <<
-			"ERROR: Received invalid pinID: " << pinID << endl;
+	while (check->numRead + (long long) subscriber->getNumOverrun() <
+			check->numEvents) {
+		if (!subscriber->poll(&event)) {
+			continue;
+		}
 
-		return false;
-	}
+		// Event k holds k as its value and time, and follows any events
+		// lost to being lapped
+		unsigned long long expected = check->numRead +
+			subscriber->getNumOverrun();
 
-	// Build path name
-	if (valueFileName == NULL) {
-		sysLog.sysLog << "[GPIOHandler::getState] " <<
-			"Building path name" << endl;
+		if (event.sequence != expected || event.type != STREAM_LIGHT_STEP ||
+				event.value != (int) event.sequence ||
+				event.time != (double) event.sequence) {
+			check->numTorn++;
+		}
 
-		if (!concatenate(directoryName, IO_VALUE_FILE, valueFileName)) {
-			sysLog.sysLog << "[GPIOHandler::getState] " <<
-				"ERROR: path name could not be built" << endl;
+		check->numRead++;
 
-			return false;
+		if (check->isSlow && check->numRead % EVENTS_PER_PAUSE == 0) {
+			sleepUntil(monotonicTime() + PAUSE_TIME);
 		}
 	}
 
-	this->inFile.close();
-	this->inFile.open(valueFileName);
+	check->numOverrun = subscriber->getNumOverrun();
+	check->maxLag     = subscriber->getMaxLag();
+}
 
-	// Check if file could be opened
-	if (!this->inFile.is_open()) {
-		sysLog.sysLog << "[GPIOHandler::getState] " <<
-			"ERROR: File could not be opened" << endl;
+// Measure how long publishing an event takes while a fast and a slow
+// subscriber follow the ring, and check that both account for every
+// event
+bool benchmarkEvents(int numEvents) {
+	const char* subscriberNames[2] = {"fast", "slow"};
+
+	// Check for invalid argument
+	if (numEvents <= 0) {
+		cerr << "[benchmarkEvents] ERROR: Invalid number of events" << endl;
 
 		return false;
 	}
 
-	// Read value from file
-	char pinState = 0;
+	EventRing writer;
+	EventRing reader;
 
-	// Check if value can be read
-	if (!this->inFile.get(pinState)) {
-		sysLog.sysLog << "[GPIOHandler::getState] " <<
-			"ERROR: Value could not be read" << endl;
+	if (!writer.create(EVENT_RING_BENCHMARK_NAME) ||
+			!reader.attach(EVENT_RING_BENCHMARK_NAME)) {
+		cerr << "[benchmarkEvents] ERROR: Could not set up shared memory" <<
+			endl;
+		writer.close();
+		shm_unlink(EVENT_RING_BENCHMARK_NAME);
 
 		return false;
 	}
 
-	/*sysLog.sysLog << "[GPIOHandler::getState] " <<
-		"Read value \"" << pinState << "\"" << endl;*/
+	// Subscribe before publishing so every event is accounted for
+	EventSubscriber fastSubscriber(&reader, true);
+	EventSubscriber slowSubscriber(&reader, true);
+	EventCheck checks[2];
+	std::thread subscribers[2];
+
+	for (int i = 0; i < 2; i++) {
+		checks[i].subscriber = (i == 0) ? (&fastSubscriber) : (&slowSubscriber);
+		checks[i].numEvents  = numEvents;
+		checks[i].isSlow     = (i == 1);
+		checks[i].numRead    = 0;
+		checks[i].numOverrun = 0;
+		checks[i].numTorn    = 0;
+		checks[i].maxLag     = 0;
+
+		subscribers[i] = std::thread(checkEvents, &checks[i]);
+	}
 
-	isOn = (pinState == '1');
+	double startTime = monotonicTime();
 
-	return true;
-}
+	for (int i = 0; i < numEvents; i++) {
+		writer.publish(STREAM_LIGHT_STEP, i, i);
+	}
 
-// Set state of pin
-bool GPIOHandler::setState (bool isOn) {
-	const char* IO_VALUE_FILE =
-		"/value";
+	double elapsedTime = monotonicTime() - startTime;
+	bool succeeded = true;
 
-	// Check if object is valid
-	if (pinID < 0) {
-		sysLog.sysLog << "[GPIOHandler::setState] " <<
-			"ERROR: Received invalid pinID: " << pinID << endl;
+	for (int i = 0; i < 2; i++) {
+		subscribers[i].join();
+	}
 
-		return false;
+	reader.close();
+	writer.close();
+	shm_unlink(EVENT_RING_BENCHMARK_NAME);
+
+	cout << numEvents << " event(s) in " << elapsedTime << " second(s): " <<
+		elapsedTime / numEvents * 1e9 << " ns per event" << endl;
+
+	for (int i = 0; i < 2; i++) {
+		cout << subscriberNames[i] << " subscriber: " << checks[i].numRead <<
+			" read, " << checks[i].numOverrun << " overrun, " <<
+			checks[i].numTorn << " torn or out of order, max lag " <<
+			checks[i].maxLag << endl;
+
+		succeeded = succeeded && checks[i].numTorn == 0 &&
+			checks[i].numRead + checks[i].numOverrun == numEvents;
 	}
 
-	/*sysLog.sysLog << "[GPIOHandler::setState][Pin " << pinID << "] " <<
-	"Entered function" << endl;*/
+	return succeeded;
+}
 
-	// Build path name
-	if (valueFileName == NULL) {
-		sysLog.sysLog << "[GPIOHandler::setState][Pin " << pinID << "] " <<
-			"Building path name" << endl;
+// Compare how long the output backends take to commit a frame
+bool benchmarkOutput(int numFrames) {
+	const char* backendNames[2] = {"plain writes", "io_uring"};
 
-		if (!concatenate(directoryName, IO_VALUE_FILE, valueFileName)) {
-			sysLog.sysLog << "[GPIOHandler::setState][Pin " << pinID << "] " <<
-				"ERROR: path name could not be built" << endl;
+	// Check for invalid argument
+	if (numFrames <= 0) {
+		cerr << "[benchmarkOutput] ERROR: Invalid number of frames" << endl;
 
-			return false;
-		}
+		return false;
 	}
 
-	// Open output file
-	outFile.close();
-	outFile.open(valueFileName);
+	Statistics stats;
+	GameData game;
 
-	// Check if file could be opened
-	if (!outFile.is_open()) {
-		sysLog.sysLog << "[GPIOHandler::setState][Pin " << pinID << "] " <<
-			"ERROR: File could not be opened" << endl;
+	if (!initialize(&stats, &game, false)) {
+		cerr << "[benchmarkOutput] ERROR: Could not set up GPIO pins" << endl;
 
 		return false;
 	}
 
-	// Set value
-	sysLog.sysLog << "[GPIOHandler::setState][Pin " << pinID << "] " <<
-		"Value set to " << (isOn + 0) << endl;
+	sysLog.setEnabled(false);
 
-	outFile << ((isOn) ? ("1") : ("0"));
+	for (int backend = OUTPUT_PLAIN_WRITES; backend <= OUTPUT_IO_URING;
+			backend++) {
+		if (!lightOutput.open((OutputBackend) backend) ||
+				lightOutput.getBackend() != backend) {
+			cout << backendNames[backend] << ": not available" << endl;
 
-	return true;
-}
+			continue;
+		}
 
-// ---------- [Functions for the GPIOHandler class end here] ----------- //
+		// Frames which change every light, then frames which move one
+		// light, as in the game
+		for (int pattern = 0; pattern < 2; pattern++) {
+			bool lightStates[TOTAL_NUM_LIGHTS];
+			vector<double> latencies(numFrames);
+			bool succeeded = true;
 
+			for (int i = 0; i < TOTAL_NUM_LIGHTS; i++) {
+				lightStates[i] = false;
+			}
 
+			lightOutput.commit(lightStates);
 
-// -------- [Functions for interfacing with hardware begin here] ------- //
+			for (int frame = 0; frame < numFrames && succeeded; frame++) {
+				for (int i = 0; i < TOTAL_NUM_LIGHTS; i++) {
+					lightStates[i] = (pattern == 0) ?
+						(frame % 2 == 0) : (i == frame % TOTAL_NUM_LIGHTS);
+				}
 
-// Set up the GPIO pins
-bool initialize(Statistics* stats, GameData* game) {
-	sysLog.sysLog << "[initialize] " <<
-		"Entered function" << endl;
+				double startTime = monotonicTime();
+				succeeded = lightOutput.commit(lightStates);
+				latencies[frame] = monotonicTime() - startTime;
+			}
 
-	// Check for null pointers
-	if (stats == NULL || game == NULL) {
-		sysLog.sysLog << "[initialize] " <<
-			"ERROR: Received null pointer" << endl;
+			if (!succeeded) {
+				cout << backendNames[backend] << ": frame could not be " <<
+					"committed" << endl;
 
-		return false;
-	}
+				break;
+			}
 
-	// Set up GPIO pins
-	sysLog.sysLog << "[initialize] " <<
-		"Setting up GPIO pins" << endl;
+			sort(latencies.begin(), latencies.end());
 
-	for (int i = 0; i < TOTAL_NUM_PINS; i++) {
-		delete systemPins[i];
-		systemPins[i] = new GPIOHandler(PIN_IDS[i]);
+			double totalLatency = 0;
 
-		if (!systemPins[i]->activate()) {
-			sysLog.sysLog << "[initialize] " <<
-				"Failed to activate pin " << PIN_IDS[i] << endl;
+			for (int frame = 0; frame < numFrames; frame++) {
+				totalLatency += latencies[frame];
+			}
 
-			return false;
+			cout << backendNames[backend] << ", " <<
+				((pattern == 0) ? (TOTAL_NUM_LIGHTS) : (2)) <<
+				" pin(s) per frame: mean " <<
+				totalLatency / numFrames * 1e6 << " us, p50 " <<
+				latencies[numFrames / 2] * 1e6 << " us, p99 " <<
+				latencies[numFrames * 99 / 100] * 1e6 << " us" << endl;
 		}
+	}
+
+	sysLog.setEnabled(true);
+	deinitialize(false);
+
+	return true;
+}
 
-		// Set first nine pins as output for LEDs
-		if (i < TOTAL_NUM_PINS - 1) {
-			sysLog.sysLog << "[initialize] " <<
-				"Setting pin " << PIN_IDS[i] << " to output" << endl;
+// Measure how much CPU time the software PWM takes at several carrier
+// frequencies, with a light moving along the strip and leaving a trail
+bool benchmarkPWM(float seconds) {
+	const int frequencies[] = {100, 200, 400, 800, 1600};
 
-			if (!systemPins[i]->setType(false)) {
-				sysLog.sysLog << "[initialize] " <<
-					"ERROR: Could not set pin " << PIN_IDS[i] <<
-					" to output" << endl;
+	// Check for invalid argument
+	if (seconds <= 0) {
+		cerr << "[benchmarkPWM] ERROR: Invalid duration" << endl;
 
-				return false;
-			}
+		return false;
+	}
 
-			// Set state of pin to false
-			sysLog.sysLog << "[initialize] " <<
-				"Setting state of pin " << PIN_IDS[i] << " to false" << endl;
+	Statistics stats;
+	GameData game;
 
-			if (!systemPins[i]->setState(false)) {
-				sysLog.sysLog << "[initialize] " <<
-					"ERROR: Could not set pin " << PIN_IDS <<
-					" to false";
+	if (!initialize(&stats, &game, false)) {
+		cerr << "[benchmarkPWM] ERROR: Could not set up GPIO pins" << endl;
 
-				return false;
-			}
+		return false;
+	}
 
-		// Set last pin as input from button
-		} else {
-			sysLog.sysLog << "[initialize] " <<
-				"Setting pin " << PIN_IDS[i] << " to input" << endl;
+	for (int frequency : frequencies) {
+		bool lightStates[TOTAL_NUM_LIGHTS] = {false};
+		SoftwarePWM pwm;
 
-			if (!systemPins[i]->setType(true)) {
-				sysLog.sysLog << "[initialize] " <<
-					"ERROR: Could not set pin " << PIN_IDS[i] << " to input" << endl;
+		unsigned long long startWrites = lightOutput.getNumWrites();
+		unsigned long long startCommits = lightOutput.getNumCommits();
+		double startCPUTime = processCPUTime();
+		double startTime = monotonicTime();
 
-				return false;
+		if (!pwm.start(&lightOutput, frequency, PWM_TRAIL_TIME)) {
+			cerr << "[benchmarkPWM] ERROR: Could not start PWM" << endl;
+			deinitialize(false);
+
+			return false;
+		}
+
+		// Move the light as quickly as in the first level
+		for (int step = 0; monotonicTime() - startTime < seconds; step++) {
+			for (int i = 0; i < TOTAL_NUM_LIGHTS; i++) {
+				lightStates[i] = (i == step % TOTAL_NUM_LIGHTS);
 			}
+
+			pwm.setLights(lightStates);
+			usleep(INITIAL_TIME_PER_LIGHT * 1000000);
 		}
-	}
 
-	// Initialize stats
-	stats->highScore       = 0;
-	stats->totalTimePlayed = 0;
-	stats->timesPressed    = 0;
-	stats->totalLivesLost  = 0;
+		pwm.stop();
 
-	// Initialize game
-	game->timePerLevel      = TIME_PER_LEVEL;
-	game->timePerLight      = INITIAL_TIME_PER_LIGHT;
-	game->levelTimer        = NULL;
-	game->lightTimer        = NULL;
-	game->currentLevel      = 0;
-	game->numLivesRemaining = INITIAL_NUM_LIVES;
-	game->lightStates       = NULL;
-	game->isMovingRight     = false;
+		double elapsedTime = monotonicTime() - startTime;
+
+		cout << frequency << " Hz: " <<
+			100 * (processCPUTime() - startCPUTime) / elapsedTime <<
+			"% of a CPU, " << (lightOutput.getNumCommits() - startCommits) /
+			elapsedTime << " commits/s, " << (lightOutput.getNumWrites() -
+			startWrites) / elapsedTime << " pin writes/s, " <<
+			pwm.getNumLatePeriods() << " of " << pwm.getNumPeriods() <<
+			" period(s) late, " << pwm.getNumRebuilds() << " schedule(s)" <<
+			endl;
+	}
+
+	deinitialize(false);
 
 	return true;
 }
 
-// Ask hardware if the button is pressed
-int buttonIsPressed() {
-	const int BUTTON_GPIO_PIN_ID = TOTAL_NUM_PINS - 1;
-	bool isOn = false;
-
-	/*sysLog.sysLog << "[buttonIsPressed] " <<
-		"Entered function" << endl;*/
+// Measure how many frames per second a shift register chain can show
+bool benchmarkShiftRegister(int numLights, int numFrames) {
+	const char* patternNames[3] = {"every light changing",
+		"light stepping along the chain", "random light changing"};
 
-	// Error check
-	if (!systemPins[BUTTON_GPIO_PIN_ID]->getState(isOn)) {
-		sysLog.sysLog << "[buttonIsPressed] " <<
-			"ERROR: Could not get button state" << endl;
+	// Check for invalid arguments
+	if (numLights <= 0 || numLights > MAX_SHIFT_REGISTER_LIGHTS ||
+			numFrames <= 0) {
+		cerr << "[benchmarkShiftRegister] ERROR: Received invalid " <<
+			"arguments" << endl;
 
-		return -1;
+		return false;
 	}
 
-	// Check for button press
-	if (isOn) {
-		sysLog.sysLog << "[buttonIsPressed] " <<
-			"Button is pressed" << endl;
+	ShiftRegisterOutput chain;
 
-		return 1;
-	}
+	if (!chain.open(SHIFT_REGISTER_PIN_IDS, numLights)) {
+		cerr << "[benchmarkShiftRegister] ERROR: Could not set up the " <<
+			"shift register pins" << endl;
 
-	return 0;
-}
+		return false;
+	}
 
-// Update which lights are on/off
-bool updateLightStrip(bool* lightStates) {
-	sysLog.sysLog << "[updateLightStrip] " <<
-		"Entered function" << endl;
+	bool* lightStates = new bool[numLights];
+	std::mt19937 random(time(NULL));
+	bool succeeded = true;
 
-	// Iterate through lights
-	for (int i = 0; i < TOTAL_NUM_LIGHTS; i++) {
-		// Check for errors in changing lights
-		if (!systemPins[i]->setState(lightStates[i])) {
-			sysLog.sysLog << "[updateLightStrip] " <<
-				"ERROR: State of light at pin " << PIN_IDS[i] <<
-				" could not be set" << endl;
+	sysLog.setEnabled(false);
 
-			return false;
+	for (int patternIndex = 0; patternIndex < 3 && succeeded;
+			patternIndex++) {
+		for (int i = 0; i < numLights; i++) {
+			lightStates[i] = false;
 		}
-	}
 
-	return true;
-}
+		chain.commit(lightStates);
 
-// Clean up the GPIO pins
-void deinitialize() {
-	sysLog.sysLog << "[deinitialize] " <<
-		"Entered function" << endl;
+		unsigned long long startFrames = chain.getNumFrames();
+		unsigned long long startBits = chain.getNumBitsShifted();
+		unsigned long long startToggles = chain.getNumToggles();
+		double startTime = monotonicTime();
 
-	// Clean up GPIO pins
-	sysLog.sysLog << "[deinitialize] " <<
-		"Cleaning up GPIO pins" << endl;
+		for (int frame = 0; frame < numFrames && succeeded; frame++) {
+			if (patternIndex == 0) {
+				for (int i = 0; i < numLights; i++) {
+					lightStates[i] = (frame % 2 == 0);
+				}
+			} else if (patternIndex == 1) {
+				for (int i = 0; i < numLights; i++) {
+					lightStates[i] = (i == frame % numLights);
+				}
+			} else {
+				int light = random() % numLights;
 
-	for (int i = 0; i < TOTAL_NUM_PINS; i++) {
-		// Turn off lights
-		if (i < TOTAL_NUM_LIGHTS) {
-			if (!systemPins[i]->setState(false)) {
-				sysLog.sysLog << "[deinitialize] " <<
-					"WARNING: Failed to turn off light" <<
-					PIN_IDS[i] << endl;
+				lightStates[light] = !lightStates[light];
 			}
-		}
 
-		// Deactivate pin
-		if (!systemPins[i]->deactivate()) {
-			sysLog.sysLog << "[deinitialize] " <<
-				"WARNING: Failed to activate deactivate pin " <<
-				PIN_IDS[i] << endl;
+			succeeded = chain.commit(lightStates);
 		}
 
-		delete systemPins[i];
-		systemPins[i] = NULL;
-	}
+		double elapsedTime = monotonicTime() - startTime;
+		double numShown = chain.getNumFrames() - startFrames;
+
+		cout << numLights << " lights, " << patternNames[patternIndex] <<
+			": " << numShown / elapsedTime << " frames/s, " <<
+			(chain.getNumBitsShifted() - startBits) / numShown <<
+			" bits and " << (chain.getNumToggles() - startToggles) / numShown <<
+			" pin writes per frame" << endl;
+	}
+
+	sysLog.setEnabled(true);
+	delete[] lightStates;
+	chain.close();
+
+	if (!succeeded) {
+		cerr << "[benchmarkShiftRegister] ERROR: Frame could not be shown" <<
+			endl;
+	}
+
+	return succeeded;
+}
+// Set the value of an input pin in a stand-in directory tree, replacing
+// the value file so that readers never see it half written
+bool writeStandInValue(const char* fileName, bool isOn) {
+	string tempFileName = string(fileName) + ".tmp";
+	ofstream valueFile(tempFileName.c_str());
+
+	valueFile << ((isOn) ? ("1") : ("0")) << endl;
+	valueFile.close();
+
+	return !valueFile.fail() && rename(tempFileName.c_str(), fileName) == 0;
 }
 
-// --------- [Functions for interfacing with hardware end here] -------- //
+// Press both buttons of a stand-in directory tree many times, a random
+// moment apart, and measure how long each button takes to stamp a press,
+// the skew between the buttons and how often the order of the presses is
+// kept
+bool benchmarkButtons(int numTrials) {
+	const double MAX_GAP = 0.001;       // Longest time between the presses
+	const double CLOSE_CALL = 0.0001;   // Presses closer than this are a
+	                                    // close call
+	const double SETTLE_TIME = 0.02;    // Time given to see a release
 
+	// Check for invalid argument
+	if (numTrials <= 0) {
+		cerr << "[benchmarkButtons] ERROR: Invalid number of trials" << endl;
 
+		return false;
+	}
 
-// ----------- [Functions for file input/output begin here] ------------ //
+	Statistics stats;
+	GameData game;
 
-// Reads a line in the file
-void parseline (char line[], Statistics* stats, int tracker) {
-	int  in = 0;
-	enum States {HIGHSCORE, PLAYTIME, TIMESPRESSED, LIVESLOST};
-	States state = HIGHSCORE;
+	playsHeadToHead = true;
 
-	sysLog.sysLog << "[parseline] " <<
-		"Entered function" << endl;
+	if (!initialize(&stats, &game, false)) {
+		cerr << "[benchmarkButtons] ERROR: Could not set up GPIO pins" << endl;
 
-	if (tracker == 0) {
-		state = HIGHSCORE;
-	} else if (tracker == 1) {
-		state = PLAYTIME;
-	} else if (tracker == 2) {
-		state = TIMESPRESSED;
-	} else if (tracker == 3) {
-		state = LIVESLOST;
+		return false;
 	}
 
-	switch (state) {
-		case HIGHSCORE:
-			sysLog.sysLog << "[parseline] " <<
-				"Setting high score to " << atoi(line) << endl;
-
-			stats->highScore = atoi(line);
+	const char* valueFileNames[NUM_PLAYERS];
+	vector<double> latencies[NUM_PLAYERS];
+	vector<double> skews;
+	std::mt19937 generator(time(NULL));
+	std::uniform_real_distribution<double> gapDistribution(0, MAX_GAP);
+	int numOrdered = 0;
+	int numCloseCalls = 0;
+	int numCloseCallsOrdered = 0;
+	bool isFinished = true;
+
+	for (int player = 0; player < NUM_PLAYERS; player++) {
+		valueFileNames[player] =
+			dualButtons.getButton(player)->getValueFileName();
+	}
 
-			break;
+	sysLog.setEnabled(false);
+
+	for (int trial = 0; trial < numTrials && isFinished; trial++) {
+		ButtonEdge edges[2 * NUM_PLAYERS];
+		double pressTimes[NUM_PLAYERS];
+		double stampTimes[NUM_PLAYERS];
+		int first = trial % NUM_PLAYERS;
+		int second = 1 - first;
+
+		// Press the buttons, alternating which goes first
+		sleepUntil(monotonicTime() + SETTLE_TIME);
+		isFinished = writeStandInValue(valueFileNames[first], true);
+		pressTimes[first] = monotonicTime();
+		sleepUntil(pressTimes[first] + gapDistribution(generator));
+		isFinished = isFinished &&
+			writeStandInValue(valueFileNames[second], true);
+		pressTimes[second] = monotonicTime();
+
+		// Wait for both presses to be stamped
+		int numEdges = 0;
+		double deadline = monotonicTime() + 0.1;
+
+		while (isFinished && numEdges < NUM_PLAYERS &&
+				monotonicTime() < deadline) {
+			pollfd edgeEvent = {dualButtons.getEdgeFileDescriptor(), POLLIN,
+				0};
+
+			poll(&edgeEvent, 1, 10);
+			numEdges += dualButtons.collect(edges + numEdges);
+		}
 
-		case PLAYTIME:
-			sysLog.sysLog << "[parseline] " <<
-				"Setting total time played to " << atof(line) << endl;
+		for (int player = 0; player < NUM_PLAYERS; player++) {
+			isFinished = writeStandInValue(valueFileNames[player], false) &&
+				isFinished;
+		}
 
-			stats->totalTimePlayed = atof(line);
+		if (numEdges != NUM_PLAYERS) {
+			isFinished = false;
+		}
 
+		if (!isFinished) {
 			break;
+		}
 
-		case TIMESPRESSED:
-			sysLog.sysLog << "[parseline] " <<
-				"Setting number of times played to " << atoi(line) << endl;
+		for (int i = 0; i < numEdges; i++) {
+			stampTimes[edges[i].player] = edges[i].time;
+		}
 
-			stats->timesPressed = atoi(line);
+		for (int player = 0; player < NUM_PLAYERS; player++) {
+			latencies[player].push_back(stampTimes[player] -
+				pressTimes[player]);
+		}
 
-			break;
+		skews.push_back(latencies[1].back() - latencies[0].back());
 
-		case LIVESLOST:
-			sysLog.sysLog << "[parseline] " <<
-				"Setting number of times lost to " << atoi(line) << endl;
+		bool isOrdered = (stampTimes[first] < stampTimes[second]);
 
-			stats->totalLivesLost = atoi(line);
+		numOrdered += isOrdered;
 
-			break;
+		if (pressTimes[second] - pressTimes[first] < CLOSE_CALL) {
+			numCloseCalls++;
+			numCloseCallsOrdered += isOrdered;
+		}
 	}
-}
 
-// Read statistics from file
-bool readStats(Statistics* stats) {
-	const char* fileName = STAT_FILE;
+	sysLog.setEnabled(true);
+	deinitialize(false);
+	playsHeadToHead = false;
 
-	sysLog.sysLog << "[readStats] " <<
-		"Entered function" << endl;
+	if (!isFinished) {
+		cerr << "[benchmarkButtons] ERROR: Presses could not be made or " <<
+			"were not stamped - is this a stand-in tree?" << endl;
 
-	// Check for null pointers
-	if (fileName == NULL || stats == NULL) {
-		sysLog.sysLog <<
-			"[readStats] ERROR: Null pointer found" << endl;
 		return false;
 	}
 
-	std::ifstream inFile;
-	inFile.open(fileName);
+	for (int player = 0; player < NUM_PLAYERS; player++) {
+		vector<double>& latency = latencies[player];
 
-	// Check if file could be opened
-	if (!inFile.is_open()) {
-		sysLog.sysLog <<
-			"[readStats] ERROR: Input file could not be opened" << endl;
-		return false;
+		sort(latency.begin(), latency.end());
+
+		cout << "Button " << player + 1 << " press to stamp: p50 " <<
+			latency[latency.size() / 2] * 1e6 << " us, p99 " <<
+			latency[latency.size() * 99 / 100] * 1e6 << " us, max " <<
+			latency.back() * 1e6 << " us" << endl;
 	}
 
-	// Read data from file
-	bool done = false;
-	int fileLineNumber = 0;
-	char* line;
-	int counter = 0;
+	double totalSkew = 0;
 
-	// Parse each line
-	while (counter < 4) {
-		inFile.getline(line, MAX_LINE_LENGTH);
-		parseline(line, stats, counter);
-		counter++;
+	for (size_t i = 0; i < skews.size(); i++) {
+		totalSkew += skews[i];
+		skews[i] = fabs(skews[i]);
 	}
 
-	sysLog.sysLog << "[readStats] " <<
-		"Successfully read statistics from file" << endl;
+	sort(skews.begin(), skews.end());
+
+	cout << "Skew of button 2 behind button 1: mean " <<
+		totalSkew / skews.size() * 1e6 << " us, |skew| p50 " <<
+		skews[skews.size() / 2] * 1e6 << " us, p99 " <<
+		skews[skews.size() * 99 / 100] * 1e6 << " us, max " <<
+		skews.back() * 1e6 << " us" << endl;
+
+	cout << "Order of presses kept in " << numOrdered << " of " <<
+		numTrials << " trial(s), " << numCloseCallsOrdered << " of " <<
+		numCloseCalls << " under " << CLOSE_CALL * 1e6 << " us apart" << endl;
 
 	return true;
 }
 
-/*
-	Writes the following statistics:
-	highscore
-	total time played
-	number of times button was clicked
-	number of lives lost
-*/
 
-bool writeStats(Statistics* stats) {
-	const char* fileName = STAT_FILE;
+// Press the button of a stand-in directory tree at random moments while a
+// game reacts to each press with a new frame of lights, and measure the
+// time from each press to the first change of a light's value file. The
+// percentiles are printed as JSON, so that runs can be compared.
+bool benchmarkLatency(int numTrials) {
+	// Check for invalid argument
+	if (numTrials <= 0) {
+		cerr << "[benchmarkLatency] ERROR: Invalid number of trials" << endl;
 
-	sysLog.sysLog << "[writeStats] " <<
-		"Entered function" << endl;
+		return false;
+	}
 
-	ofstream outFile;
-	outFile.open(fileName);
+	Statistics stats;
+	GameData game;
 
-	// Check if file could be opened
-	if(!outFile.is_open()) {
-		sysLog.sysLog << "[writeStats] " <<
-			"Output file could not be opened" << endl;
+	if (!initialize(&stats, &game, false)) {
+		cerr << "[benchmarkLatency] ERROR: Could not set up GPIO pins" << endl;
 
 		return false;
 	}
 
-	// Writing to file
-	outFile << stats->highScore << endl;
-	outFile << stats->totalTimePlayed << endl;
-	outFile << stats->timesPressed << endl;
-	outFile << stats->totalLivesLost << endl;
-
-	// Closing file
-	outFile.close();
+	LatencyTrials trials;
 
-	sysLog.sysLog << "[writeStats] " <<
-		"Successfully wrote statistics to file" << endl;
+	trials.buttonFileName =
+		systemPins[TOTAL_NUM_PINS - 1]->getValueFileName();
+	trials.notifier = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	trials.numTrials = numTrials;
+	trials.numReleases = 0;
+	trials.reactTimes.resize(numTrials, NAN);
+	trials.numErrors = 0;
+	trials.isFinished = false;
 
-	return true;
-}
+	// Watch the value file of every light for writes
+	bool isWatched = (trials.notifier >= 0 && trials.buttonFileName != NULL);
 
-// ------------ [Functions for file input/output end here] ------------- //
+	for (int i = 0; i < TOTAL_NUM_LIGHTS && isWatched; i++) {
+		const char* valueFileName = systemPins[i]->getValueFileName();
 
+		isWatched = (valueFileName != NULL && inotify_add_watch(
+			trials.notifier, valueFileName, IN_MODIFY) >= 0);
+	}
 
+	if (!isWatched) {
+		cerr << "[benchmarkLatency] ERROR: Lights could not be watched" << endl;
 
-// --------- [Functions for calculating statistics begin here] --------- //
+		if (trials.notifier >= 0) {
+			::close(trials.notifier);
+		}
 
-// Update high score
-bool highScoreFunc(Statistics* stats, GameData* game) {
-	// Check for null pointers
-	if (game == NULL || stats == NULL) {
-		sysLog.sysLog << "[highScoreFunc] " <<
-			"ERROR: Received null pointer" << endl;
+		deinitialize(false);
 
 		return false;
 	}
 
-	// Update high score
-	if (game->currentLevel > stats->highScore) {
-		sysLog.sysLog << "[highScoreFunc] " <<
-			"Updating highscore from " << stats->highScore <<
-			" to " << game->currentLevel << endl;
+	// Run the game on a scheduler which follows the real clock and the
+	// button, as a played game does
+	GameScheduler scheduler(false);
+	GameContext context = {&scheduler, -1, &stats, &game, true, NULL, NULL,
+		NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL};
 
-		stats->highScore = game->currentLevel;
-	}
+	sysLog.setEnabled(false);
 
-	return true;
-}
+	context.slot = scheduler.spawn(reactToPresses(&context, &trials));
+	scheduler.setHardwareSlot(context.slot);
 
-// Update total time played
-bool playTime(Statistics* stats) {
-	// Check for null pointer
-	if (stats == NULL) {
-		sysLog.sysLog << "[playTime] " <<
-			"ERROR: Received null pointer" << endl;
+	std::thread driver(driveLatencyTrials, &trials);
+	bool succeeded = scheduler.run();
+
+	driver.join();
+	sysLog.setEnabled(true);
+
+	::close(trials.notifier);
+	deinitialize(false);
+
+	if (!succeeded || !trials.isFinished) {
+		cerr << "[benchmarkLatency] ERROR: Presses could not be made or " <<
+			"were not answered - is this a stand-in tree?" << endl;
 
 		return false;
 	}
 
-	sysLog.sysLog << "[playTime] " <<
-		"Incrementing total play time by " << clock() << endl;
+	// Split each trial into the time the game took to see the press, and
+	// the time from then until a light changed
+	vector<double> detectLatencies, outputLatencies, totalLatencies;
+
+	for (int trial = 0; trial < numTrials; trial++) {
+		detectLatencies.push_back(trials.reactTimes[trial] -
+			trials.pressTimes[trial]);
+		outputLatencies.push_back(trials.lightTimes[trial] -
+			trials.reactTimes[trial]);
+		totalLatencies.push_back(trials.lightTimes[trial] -
+			trials.pressTimes[trial]);
+	}
 
-	stats->totalTimePlayed += clock();
+	cout << "{" << endl;
+	cout << "  \"trials\": " << numTrials << "," << endl;
+	cout << "  \"errors\": " << trials.numErrors << "," << endl;
+	printLatencyPercentiles("press_to_detect_us", detectLatencies, false);
+	printLatencyPercentiles("detect_to_light_us", outputLatencies, false);
+	printLatencyPercentiles("press_to_light_us", totalLatencies, true);
+	cout << "}" << endl;
 
 	return true;
 }
 
-// ---------- [Functions for calculating statistics end here] ---------- //
+// Press and release the button of a stand-in tree for each trial of the
+// input-to-light benchmark, stamping the press and the first change of a
+// light after it. This runs on its own thread, so it does not log.
+void driveLatencyTrials(LatencyTrials* trials) {
+	const double MIN_GAP = 0.005;       // Shortest time between trials
+	const double MAX_GAP = 0.02;        // Longest time between trials
+	const double TIMEOUT = 1;           // Time given to answer a press
+	const double RELEASE_POLL_TIME = 0.0005;
+	std::mt19937 generator(time(NULL));
+	std::uniform_real_distribution<double> gapDistribution(MIN_GAP, MAX_GAP);
+	char events[4096];
 
+	trials->isFinished = true;
 
+	for (int trial = 0; trial < trials->numTrials && trials->isFinished;
+			trial++) {
+		sleepUntil(monotonicTime() + gapDistribution(generator));
 
-// ----------- [Functions for changing game data begin here] ----------- //
+		// Drop changes to the lights from before the press
+		while (read(trials->notifier, events, sizeof(events)) > 0) {}
 
-// Get a direction "randomly" based on the time the function is called
-bool setRandomDirection(GameData* game) {
-	// Check for null pointer
-	if (game == NULL) {
-		sysLog.sysLog <<
-			"[setRandomDirection] ERROR: Null pointer found" << endl;
+		// Stamp the press before it is written, since the game may see it
+		// before this thread runs again
+		double pressTime = monotonicTime();
+		double lightTime = NAN;
 
-		return false;
-	}
+		if (!writeStandInValue(trials->buttonFileName, true)) {
+			trials->isFinished = false;
 
-	bool isMovingRight = (clock() % 2 == 0);
+			break;
+		}
 
-	// Set direction
-	game->isMovingRight = isMovingRight;
-	sysLog.sysLog <<
-		"[setRandomDirection] Direction set to " <<
-		((isMovingRight) ? ("right") : ("left")) << endl;
+		// Wait for the first change to a light
+		while (isnan(lightTime) && monotonicTime() < pressTime + TIMEOUT) {
+			pollfd lightEvent = {trials->notifier, POLLIN, 0};
 
-	// Set position according to direction
-	if (isMovingRight) {
-		game->currentLightPosition = 0;
-	} else {
-		game->currentLightPosition = TOTAL_NUM_LIGHTS - 1;
-	}
+			if (poll(&lightEvent, 1, 100) > 0 &&
+					read(trials->notifier, events, sizeof(events)) > 0) {
+				lightTime = monotonicTime();
+			}
+		}
 
-	sysLog.sysLog <<
-		"[setRandomDirection] Position set to " <<
-		(game->currentLightPosition) << endl;
+		// Release the button and wait for the game to see it
+		trials->isFinished = !isnan(lightTime) &&
+			writeStandInValue(trials->buttonFileName, false);
 
-	return true;
-}
+		while (trials->isFinished && trials->numReleases <= trial) {
+			if (monotonicTime() >= pressTime + TIMEOUT) {
+				trials->isFinished = false;
+			}
 
-// Move the light to its next position (cyclic)
-bool updateLightPosition(GameData* game) {
-	// Check for null pointer
-	if (game == NULL) {
-		sysLog.sysLog <<
-			"[updateLightPosition] ERROR: Null pointer found" << endl;
-		return false;
+			sleepUntil(monotonicTime() + RELEASE_POLL_TIME);
+		}
+
+		trials->pressTimes.push_back(pressTime);
+		trials->lightTimes.push_back(lightTime);
 	}
+}
 
-	// Move current light to the right
-	if (game->isMovingRight) {
-		game->currentLightPosition += 1;
-		game->currentLightPosition %= TOTAL_NUM_LIGHTS;
+// React to each press of the button with a new frame of lights, moving
+// the light on a step as the game does, for the input-to-light benchmark
+GameTask reactToPresses(GameContext* context, LatencyTrials* trials) {
+	const double TIMEOUT = 1;           // Time to wait for each press
+	const double RELEASE_POLL_TIME = 0.0005;
+	GameScheduler* scheduler = context->scheduler;
+	bool lightStates[TOTAL_NUM_LIGHTS];
 
-		sysLog.sysLog <<
-			"[updateLightPosition] Light moved to the right" << endl;
+	for (int trial = 0; trial < trials->numTrials; trial++) {
+		GameEvent event = co_await waitForPress(context,
+			scheduler->now() + TIMEOUT);
 
-	// Move current light to the left
-	} else {
-		game->currentLightPosition += TOTAL_NUM_LIGHTS - 1;
-		game->currentLightPosition %= TOTAL_NUM_LIGHTS;
+		// Try a failed read again, as the pins may recover
+		if (event == EVENT_INPUT_ERROR) {
+			trials->numErrors++;
+			trial--;
 
-		sysLog.sysLog <<
-			"[updateLightPosition] Light moved to the left" << endl;
-	}
+			continue;
+		}
 
-	// Update lightStates array
-	for (int i = 0; i < TOTAL_NUM_LIGHTS; i++) {
-		game->lightStates[i] = (i == game->currentLightPosition);
-	}
+		// Give up if the press never came
+		if (event != EVENT_PRESS) {
+			co_return false;
+		}
 
-	// Reset light timer
-	game->lightTimer->setStopTime(game->timePerLight);
+		double reactTime = monotonicTime();
 
-	return true;
-}
+		trials->reactTimes[trial] = reactTime;
 
-// Update the length of time for which a light is on
-bool updateLightDuration(GameData* game) {
-	// Check for null pointer
-	if (game == NULL) {
-		sysLog.sysLog <<
-			"[updateLightDuration] ERROR: Null pointer found" << endl;
+		for (int i = 0; i < TOTAL_NUM_LIGHTS; i++) {
+			lightStates[i] = (i == trial % TOTAL_NUM_LIGHTS);
+		}
 
-		return false;
-	}
+		// Write the frame until it goes through
+		while (!updateLightStrip(lightStates)) {
+			trials->numErrors++;
+
+			if (scheduler->now() >= reactTime + TIMEOUT) {
+				co_return false;
+			}
+		}
 
-	game->timePerLight *= SCALING_TIME_PER_LIGHT;
+		// Wait for the button to be released before the next press
+		while (buttonIsPressed() != 0) {
+			co_await waitUntil(context, scheduler->now() + RELEASE_POLL_TIME);
+		}
 
-	sysLog.sysLog <<
-		"[updateLightDuration] Light duration set to " <<
-		game->timePerLight << endl;
+		trials->numReleases++;
+	}
 
-	return true;
+	co_return true;
 }
 
-bool clearLights (GameData* game) {
-	// Initialize array if it does not already exist
-	if (game->lightStates == NULL) {
-		game->lightStates = new bool[TOTAL_NUM_LIGHTS];
+// Print percentiles of latencies in seconds as a JSON object of
+// microseconds
+void printLatencyPercentiles(const char* name, vector<double>& latencies,
+		bool isLast) {
+	const double FRACTIONS[] = {0.5, 0.9, 0.99, 0.999};
+	const char* FRACTION_NAMES[] = {"p50", "p90", "p99", "p999"};
+	double totalLatency = 0;
 
-		sysLog.sysLog <<
-			"[clearLights] Initialized lightStates array" << endl;
+	sort(latencies.begin(), latencies.end());
+
+	for (size_t i = 0; i < latencies.size(); i++) {
+		totalLatency += latencies[i];
 	}
 
-	// Clear array
-	for (int i = 0; i < TOTAL_NUM_LIGHTS; i++) {
-		game->lightStates[i] = false;
+	cout << "  \"" << name << "\": {\"mean\": " <<
+		totalLatency / latencies.size() * 1e6 << ", \"min\": " <<
+		latencies.front() * 1e6;
 
-		// Turn off lights
-		if (!systemPins[i]->setState(false)) {
-			return false;
-		}
+	for (int i = 0; i < 4; i++) {
+		cout << ", \"" << FRACTION_NAMES[i] << "\": " <<
+			latencies[(size_t) (latencies.size() * FRACTIONS[i])] * 1e6;
 	}
 
-	sysLog.sysLog <<
-		"[clearLights] Cleared lightStates array" << endl;
-
-	return true;
+	cout << ", \"max\": " << latencies.back() * 1e6 << "}" <<
+		((isLast) ? ("") : (",")) << endl;
 }
 
-// Reset the game
-bool reset(GameData* game) {
-	// Check for null pointer
-	if (game == NULL) {
-		sysLog.sysLog <<
-			"[reset] ERROR: Null pointer found" << endl;
+// Measure how late the display refreshes are, and whether refreshing it
+// makes the strip's deadlines any later
+bool benchmarkDisplay(float seconds) {
+	const double STEP_TIME = 0.01;  // Time between strip frames
+
+	// Check for invalid argument
+	if (seconds <= 0) {
+		cerr << "[benchmarkDisplay] ERROR: Invalid duration" << endl;
 
 		return false;
 	}
 
-	game->timePerLevel = TIME_PER_LEVEL;
-	game->timePerLight = INITIAL_TIME_PER_LIGHT;
-	game->levelTimer   = new Timer;
-	game->lightTimer   = new Timer;
-	game->currentLevel = 0;
-	game->numLivesRemaining = INITIAL_NUM_LIVES;
-
-	// Clear light array
-
-	sysLog.sysLog << "[reset] " <<
-		"Clearing light array" << endl;
+	Statistics stats;
+	GameData game;
 
-	if (!clearLights(game)) {
-		sysLog.sysLog << "[reset] " <<
-			"ERROR: Light array could not be cleared" << endl;
+	if (!initialize(&stats, &game, false)) {
+		cerr << "[benchmarkDisplay] ERROR: Could not set up GPIO pins" << endl;
 
 		return false;
 	}
 
-	// Update light strip
-	sysLog.sysLog << "[reset] " <<
-		"Update light strip" << endl;
+	SegmentDisplay display;
 
-	if (!updateLightStrip(game->lightStates)) {
-		sysLog.sysLog << "[reset] " <<
-			"ERROR: Light strip could not be updated" << endl;
+	// Step a light along the strip without and then with the display
+	for (int isRefreshing = 0; isRefreshing < 2; isRefreshing++) {
+		if (isRefreshing && !display.open(SEGMENT_PIN_IDS, DIGIT_PIN_IDS)) {
+			cerr << "[benchmarkDisplay] ERROR: Could not set up the " <<
+				"display pins" << endl;
+			deinitialize(false);
 
-		return false;
-	}
+			return false;
+		}
 
-	return true;
-}
+		bool lightStates[TOTAL_NUM_LIGHTS];
+		vector<double> latenesses;
+		double deadline = monotonicTime();
+		double endTime = deadline + seconds;
 
-// Flash lights
-bool flashLights () {
-	bool * lightStates = new bool[TOTAL_NUM_LIGHTS];
+		sysLog.setEnabled(false);
 
-	// Wait DEFAULT_PAUSE_TIME seconds
-	sysLog.sysLog << "[flashLights] " <<
-	"Flashing lights" << endl;
+		for (int step = 0; deadline < endTime; step++) {
+			deadline += STEP_TIME;
+			sleepUntil(deadline);
+			latenesses.push_back(monotonicTime() - deadline);
 
-	// Set all lights to on
-	for (int i = 0; i < TOTAL_NUM_LIGHTS; i++) {
-		lightStates[i] = true;
-	}
+			for (int i = 0; i < TOTAL_NUM_LIGHTS; i++) {
+				lightStates[i] = (i == step % TOTAL_NUM_LIGHTS);
+			}
 
-	if (!updateLightStrip(lightStates)) {
-		sysLog.sysLog << "[flashLights] " <<
-			"ERROR: Could not turn on light(s)" << endl;
+			display.showScores(step / 100 % 100, 42);
+			lightOutput.commit(lightStates);
+		}
+
+		sysLog.setEnabled(true);
+		sort(latenesses.begin(), latenesses.end());
 
-		return false;
+		cout << "Strip deadlines " << ((isRefreshing) ? ("with") :
+			("without")) << " the display: p50 " <<
+			latenesses[latenesses.size() / 2] * 1e6 << " us, p99 " <<
+			latenesses[latenesses.size() * 99 / 100] * 1e6 << " us, max " <<
+			latenesses.back() * 1e6 << " us late" << endl;
 	}
 
-	Timer* t = new Timer;
+	display.close();
 
-	t->setStopTime(DEFAULT_PAUSE_TIME);
+	cout << "Display refreshes at " << DISPLAY_REFRESH_RATE << " Hz: " <<
+		display.getNumRefreshes() << " shown, " << display.getNumSkipped() <<
+		" skipped; p50 " << display.getLatenessPercentile(0.5) * 1e6 <<
+		" us, p99 " << display.getLatenessPercentile(0.99) * 1e6 <<
+		" us, max " << display.getMaxLateness() * 1e6 << " us late" << endl;
 
-	while (!t->isFinished());
+	deinitialize(false);
 
-	// Set all lights to off
-	for (int i = 0; i < TOTAL_NUM_LIGHTS; i++) {
-		lightStates[i] = false;
-	}
+	return true;
+}
 
-	delete t;
+// Step a light along the strip and read the button at a fixed rate, with
+// clean pins and then with the loaded faults, and measure how late the
+// steps are, how long the reads take and how long failures last
+bool benchmarkFaults(float seconds) {
+	const double STEP_TIME = 0.01;  // Time between strip frames
+	const char* passNames[2] = {"Clean pins", "Injected faults"};
 
-	if (!updateLightStrip(lightStates)) {
-		sysLog.sysLog << "[flashLights] " <<
-			"ERROR: Could not turn off light(s)" << endl;
+	// Check for invalid argument
+	if (seconds <= 0) {
+		cerr << "[benchmarkFaults] ERROR: Invalid duration" << endl;
 
 		return false;
 	}
 
-	return true;
-}
+	Statistics stats;
+	GameData game;
 
-// ------------ [Functions for changing game data end here] ------------ //
+	// Set the pins up cleanly, so that the faults only meet the steps
+	gpioFaults.setEnabled(false);
 
+	if (!initialize(&stats, &game, false)) {
+		cerr << "[benchmarkFaults] ERROR: Could not set up GPIO pins" << endl;
 
+		return false;
+	}
 
-// ----------- [Functions for handling game logic begin here] ---------- //
+	int numPasses = (gpioFaults.isLoaded()) ? (2) : (1);
+
+	for (int pass = 0; pass < numPasses; pass++) {
+		bool lightStates[TOTAL_NUM_LIGHTS];
+		vector<double> latenesses;
+		vector<double> readTimes;
+		vector<double> recoveryTimes;
+		int numFailedFrames = 0;
+		int numFailedReads = 0;
+		double frameFailTime = NAN;  // Time the current outage began
+		double readFailTime = NAN;
+		double deadline = monotonicTime();
+		double endTime = deadline + seconds;
+
+		sysLog.setEnabled(false);
+		gpioFaults.setEnabled(pass == 1);
+
+		for (int step = 0; deadline < endTime; step++) {
+			deadline += STEP_TIME;
+			sleepUntil(deadline);
+
+			for (int i = 0; i < TOTAL_NUM_LIGHTS; i++) {
+				lightStates[i] = (i == step % TOTAL_NUM_LIGHTS);
+			}
 
-// Do nothing for some number of seconds
-void sleep (float seconds) {
-	Timer* t = new Timer;
-	t->setStopTime(seconds);
+			bool isWritten = updateLightStrip(lightStates);
+			double writeTime = monotonicTime();
+			bool isRead = (buttonIsPressed() >= 0);
+			double readTime = monotonicTime();
+
+			latenesses.push_back(writeTime - deadline);
+			readTimes.push_back(readTime - writeTime);
+
+			// Time each outage from its first failure to the next success
+			if (!isWritten) {
+				numFailedFrames++;
+				frameFailTime = (isnan(frameFailTime)) ?
+					(writeTime) : (frameFailTime);
+			} else if (!isnan(frameFailTime)) {
+				recoveryTimes.push_back(writeTime - frameFailTime);
+				frameFailTime = NAN;
+			}
 
-	sysLog.sysLog <<
-		"[sleep] Sleeping for " << seconds << " second(s)" << endl;
+			if (!isRead) {
+				numFailedReads++;
+				readFailTime = (isnan(readFailTime)) ?
+					(readTime) : (readFailTime);
+			} else if (!isnan(readFailTime)) {
+				recoveryTimes.push_back(readTime - readFailTime);
+				readFailTime = NAN;
+			}
+		}
 
-	while (!t->isFinished());
+		gpioFaults.setEnabled(false);
+		sysLog.setEnabled(true);
+
+		sort(latenesses.begin(), latenesses.end());
+		sort(readTimes.begin(), readTimes.end());
+		sort(recoveryTimes.begin(), recoveryTimes.end());
+
+		cout << passNames[pass] << ": steps p50 " <<
+			latenesses[latenesses.size() / 2] * 1e6 << " us, p99 " <<
+			latenesses[latenesses.size() * 99 / 100] * 1e6 << " us, max " <<
+			latenesses.back() * 1e6 << " us late; reads p50 " <<
+			readTimes[readTimes.size() / 2] * 1e6 << " us, p99 " <<
+			readTimes[readTimes.size() * 99 / 100] * 1e6 << " us, max " <<
+			readTimes.back() * 1e6 << " us" << endl;
+
+		cout << passNames[pass] << ": " << numFailedFrames << " of " <<
+			latenesses.size() << " frame(s) and " << numFailedReads <<
+			" read(s) failed, " << recoveryTimes.size() << " outage(s)";
+
+		if (!recoveryTimes.empty()) {
+			cout << " recovered in p50 " <<
+				recoveryTimes[recoveryTimes.size() / 2] * 1000 << " ms, max " <<
+				recoveryTimes.back() * 1000 << " ms";
+		}
 
-	sysLog.sysLog <<
-		"[sleep] Woke up after " << seconds << " second(s)" << endl;
+		cout << endl;
+	}
 
-	delete t;
-}
+	if (gpioFaults.isLoaded()) {
+		gpioFaults.report(cout, "");
+	}
 
-// Do nothing until the button is pressed
-bool gameLoopIdle(Statistics* stats, GameData* game) {
-	sysLog.sysLog <<
-		"[gameLoopIdle] Entered gameLoopIdle state" << endl;
+	deinitialize(false);
 
-	// Check for null pointer
-	if (stats == NULL) {
-		sysLog.sysLog <<
-			"[gameLoopIdle] ERROR: Null pointer found" << endl;
+	return true;
+}
 
-		return false;
+// Send a command to a running daemon and print its reply
+bool sendControlCommand(int numWords, const char* const words[]) {
+	sockaddr_un address;
+	string command;
+
+	// Join the words of the command into a single line
+	for (int i = 0; i < numWords; i++) {
+		command += (i == 0) ? ("") : (" ");
+		command += words[i];
 	}
 
-	Timer* t = new Timer;
+	command += "\n";
 
-	sysLog.sysLog <<
-		"[gameLoopIdle] Waiting for button press" << endl;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strncpy(address.sun_path, CONTROL_SOCKET, sizeof(address.sun_path) - 1);
 
-	t->setStopTime(MAX_IDLE_TIME);
+	int client = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
 
-	// Get button press
-	int buttonPress = buttonIsPressed();
+	if (client < 0 ||
+			connect(client, (sockaddr*) &address, sizeof(address)) != 0) {
+		cerr << "[sendControlCommand] ERROR: No daemon is running" << endl;
 
-	// Validate button press
-	if (buttonPress == -1) {
-		sysLog.sysLog << "[gameLoopIdle] " <<
-			"ERROR: Button state could not be detected" << endl;
+		if (client >= 0) {
+			close(client);
+		}
 
 		return false;
 	}
 
-	while (buttonPress != 1 && !t->isFinished()) {
-		// Get button press
-		buttonPress = buttonIsPressed();
+	if (send(client, command.c_str(), command.size(), MSG_NOSIGNAL) < 0) {
+		cerr << "[sendControlCommand] ERROR: Command could not be sent" << endl;
+		close(client);
 
-		// Check if button press was not detected
-		if (buttonPress == -1) {
-			sysLog.sysLog << "[gameLoopIdle] " <<
-				"ERROR: Button state could not be detected" << endl;
+		return false;
+	}
 
-			return false;
-		}
-	};
+	// Print the reply up to the end of its line
+	string reply;
+	char character;
 
-	if (!t->isFinished()) {
-		delete t;
+	while (recv(client, &character, 1, 0) == 1 && character != '\n') {
+		reply += character;
+	}
 
-		sysLog.sysLog << "[gameLoopIdle] " <<
-			"Button press detected - exiting idle state" << endl;
+	close(client);
+	cout << reply << endl;
 
-		return true;
-	} else {
-		delete t;
+	return reply.compare(0, 6, "error:") != 0;
+}
 
-		sysLog.sysLog <<
-			"[gameLoopIdle] The button was not pressed for " <<
-			MAX_IDLE_TIME << " second(s) - exiting game" << endl;
+// Print the best scores in the leaderboard
+bool printLeaderboard(int numScores) {
+	// Check for invalid argument
+	if (numScores <= 0) {
+		cerr << "[printLeaderboard] ERROR: Invalid number of scores" << endl;
 
 		return false;
 	}
-}
-
-// Play the game
-bool gameLoopPlay(Statistics* stats, GameData* game) {
-	sysLog.sysLog <<
-		"[gameLoopPlay] Entered gameLoopPlay state" << endl;
 
-	// Check for null pointers
-	if (stats == NULL || game == NULL) {
-		sysLog.sysLog <<
-			"[gameLoopPlay] ERROR: Null pointer detected" << endl;
+	if (!leaderboard.openReadOnly(LEADERBOARD_FILE)) {
+		cerr << "[printLeaderboard] ERROR: Could not open \"" <<
+			LEADERBOARD_FILE << "\"" << endl;
 
 		return false;
 	}
 
-	sysLog.sysLog <<
-		"[gameLoopPlay] Entering life loop" << endl;
+	vector<LeaderboardRecord> topScores(numScores);
+	int numFound = leaderboard.getTopScores(numScores, &topScores[0]);
 
-	// Loop until there are no lives remaining
-	while (game->numLivesRemaining > 0) {
-		bool passedLevel = true;
+	for (int i = 0; i < numFound; i++) {
+		char date[32];
+		time_t startTime = topScores[i].startTime;
 
-		sysLog.sysLog <<
-			"[gameLoopPlay] Entering passedLevel loop" << endl;
+		strftime(date, sizeof(date), "%Y-%m-%d %H:%M", localtime(&startTime));
 
-		// Loop through levels until the level is failed
-		while (passedLevel) {
-			bool levelEnded = false;
-			passedLevel = false;
+		cout << (i + 1) << ". " << topScores[i].playerName << " - level " <<
+			topScores[i].score << " (" << date << ")" << endl;
+	}
 
-			// Clear lights array
-			sysLog.sysLog << "[gameLoopPlay] " <<
-				"Clear lights array" << endl;
+	cout << leaderboard.getNumRecords() << " session(s) recorded" << endl;
 
-			if (!clearLights(game)) {
-				sysLog.sysLog << "[gameLoopPlay] " <<
-					"ERROR: Could not clear lights array" << endl;
+	leaderboard.close();
 
-				return false;
-			}
+	return true;
+}
 
-			sysLog.sysLog <<
-				"[gameLoopPlay] Set random direction" << endl;
-			setRandomDirection(game);
+// Determine whether an argument selects a mode which runs instead of the
+// game: a simulation, replay, sweep, merge or benchmark
+bool isToolMode (const char* argument) {
+	const char* const TOOL_MODES[] = {
+		"--simulate", "--replay", "--batch-simulate", "--sweep",
+		"--merge-sketches"
+	};
 
-			// Handle errors in updating light strip
-			if (!updateLightStrip(game->lightStates)) {
-				sysLog.sysLog << "[gameLoopPlay] " <<
-					"ERROR: Light could not be set" << endl;
+	if (strncmp(argument, "--benchmark-", strlen("--benchmark-")) == 0) {
+		return true;
+	}
 
-				return false;
-			}
+	for (size_t i = 0; i < sizeof(TOOL_MODES) / sizeof(TOOL_MODES[0]); i++) {
+		if (strcmp(argument, TOOL_MODES[i]) == 0) {
+			return true;
+		}
+	}
 
-			// Set initial timer values
-			sysLog.sysLog <<
-				"[gameLoopPlay] Setting timer stop values" << endl;
+	return false;
+}
 
-			game->lightTimer->setStopTime(game->timePerLight);
-			game->levelTimer->setStopTime(game->timePerLevel);
+// ------------ [Functions for handling game logic end here] ----------- //
 
-			// Loop through lights until the level is finished
-			sysLog.sysLog <<
-				"[gameLoopPlay] Entering light-update loop" << endl;
 
-			while (!levelEnded && !game->levelTimer->isFinished()) {
 
-				// Update lights if it is time to update the lights
-				if (game->lightTimer->isFinished()) {
-					updateLightPosition(game);
+// Set up and run the game:
+int main (const int numArguments, const char* const arguments[]) {
+	const char* faultsFile = NULL;
+	vector<const char*> modeArguments;
+
+	// Take the GPIO faults out of the arguments, so they may come before
+	// or after the mode
+	for (int i = 0; i < numArguments; i++) {
+		if (i > 0 && i + 1 < numArguments &&
+				strcmp(arguments[i], "--faults") == 0) {
+			faultsFile = arguments[i + 1];
+			i++;
+		} else {
+			modeArguments.push_back(arguments[i]);
+		}
+	}
 
-					// Handle errors in updating light strip
-					if (!updateLightStrip(game->lightStates)) {
-						sysLog.sysLog << "[gameLoopPlay] " <<
-						"ERROR: Light could not be set" << endl;
+	const int argc = (int) modeArguments.size();
+	const char* const* argv = modeArguments.data();
 
-						return false;
-					}
+	// Modes which only read what a running game keeps, or talk to a
+	// daemon, run before the log is opened so the game's log is kept
 
-					sysLog.sysLog <<
-						"[gameLoopPlay] Updating light position" << endl;
+	// Send a command to a running daemon if requested
+	if (argc >= 3 && strcmp(argv[1], "--control") == 0) {
+		return (sendControlCommand(argc - 2, argv + 2)) ? (0) : (-1);
+	}
 
-					game->lightTimer->setStopTime(game->timePerLight);
-				}
+	// Follow a running game if requested
+	if (argc >= 2 && strcmp(argv[1], "--watch") == 0) {
+		float interval = (argc >= 3) ? (atof(argv[2])) : (0.05);
 
-				// Check for button press
-				int buttonPress = buttonIsPressed();
+		return (watchGame(interval)) ? (0) : (-1);
+	}
 
-				// Validate button press
-				if (buttonPress == -1) {
-					sysLog.sysLog << "[gameLoopPlay] " <<
-					"ERROR: Button state could not be detected" << endl;
+	// Follow the events of a running game if requested
+	if (argc >= 2 && strcmp(argv[1], "--events") == 0) {
+		return (followEvents()) ? (0) : (-1);
+	}
 
-					return false;
+	// Print the best scores if requested
+	if (argc >= 2 && strcmp(argv[1], "--leaderboard") == 0) {
+		int numScores = (argc >= 3) ? (atoi(argv[2])) : (10);
 
-				// Handle button press
-				} else if (buttonPress == 1) {
-					sysLog.sysLog <<
-						"[gameLoopPlay] Button press detected" << endl;
+		return (printLeaderboard(numScores)) ? (0) : (-1);
+	}
 
-					stats->timesPressed++;
+	// Print the spread of press timing if requested
+	if (argc >= 2 && strcmp(argv[1], "--accuracy") == 0) {
+		return (printAccuracy(argc - 2, argv + 2)) ? (0) : (-1);
+	}
 
-					// Signify that the game has failed if the
-					// incorrect light is on
-					if ((game->isMovingRight && game->currentLightPosition != TARGET_INDEX + 1) ||
-							(!game->isMovingRight && game->currentLightPosition != TARGET_INDEX - 1)) {
+	// Aggregate the session history if requested
+	if (argc >= 2 && strcmp(argv[1], "--query") == 0) {
+		return (queryHistory(argc - 2, argv + 2)) ? (0) : (-1);
+	}
 
-						sysLog.sysLog <<
-							"[gameLoopPlay] Incorrect position detected: " <<
-							game->currentLightPosition << ", expecting " <<
-							TARGET_INDEX << endl;
+	// Modes which run instead of the game keep a log of their own, so a
+	// daemon's log is not replaced while it is running
+	sysLog.open((argc >= 2 && isToolMode(argv[1])) ?
+		(TOOL_LOG_FILE) : (LOG_FILE));
+	sysLog.sysLog << "[main] " <<
+		"Program started" << endl;
 
-						passedLevel = false;
-						stats->totalLivesLost++;
-					} else {
-						passedLevel = true;
-					}
+	// Inject faults into the GPIO pins in every mode if asked to
+	if (faultsFile != NULL && !gpioFaults.load(faultsFile)) {
+		cerr << "[main] ERROR: Could not load GPIO faults from \"" <<
+			faultsFile << "\" - see " << sysLog.getFileName() << endl;
 
-					levelEnded = true;
-				}
+		return -1;
+	}
 
-				// Level has failed if time runs out
-				if (game->levelTimer->isFinished()) {
-					levelEnded = true;
-					passedLevel = false;
-					stats->totalLivesLost++;
-				}
-			}
+	// Simulate games without touching the hardware if requested
+	if (argc >= 3 && strcmp(argv[1], "--simulate") == 0) {
+		double errorStdDev = (argc >= 4) ? (atof(argv[3])) : (0.04);
+		const char* recordingFile = (argc >= 5) ? (argv[4]) : (NULL);
 
-			sysLog.sysLog <<
-				"[gameLoopPlay] Exiting life-update loop" << endl;
+		return (simulateGames(atoi(argv[2]), errorStdDev, recordingFile)) ?
+			(0) : (-1);
+	}
 
-			// Pause for a moment
-			sysLog.sysLog <<
-				"[gameLoopPlay] Sleeping for " <<
-				DEFAULT_PAUSE_TIME << " second(s)" << endl;
+	// Replay an input recording if requested
+	if (argc >= 3 && strcmp(argv[1], "--replay") == 0) {
+		return (replayGames(argv[2])) ? (0) : (-1);
+	}
 
-			sleep(DEFAULT_PAUSE_TIME);
+	// Simulate games with the vectorized batch simulator if requested
+	if (argc >= 3 && strcmp(argv[1], "--batch-simulate") == 0) {
+		double errorStdDev = (argc >= 4) ? (atof(argv[3])) : (0.04);
 
-			//Check if passedLevel
-			if (passedLevel) {
-				// Flash lights
-				sysLog.sysLog << "[gameLoopPlay] " <<
-					"Flash lights to indicate success" << endl;
+		return (batchSimulateGames(atoi(argv[2]), errorStdDev)) ? (0) : (-1);
+	}
 
-				if (!flashLights()) {
-					sysLog.sysLog << "[gameLoopPlay] " <<
-						"ERROR: Lights could not be flashed" << endl;
+	// Sweep the difficulty settings if requested
+	if (argc >= 2 && strcmp(argv[1], "--sweep") == 0) {
+		return (sweepDifficulty(argc - 2, argv + 2)) ? (0) : (-1);
+	}
 
-					return false;
-				}
+	// Merge press timing from other cabinets if requested
+	if (argc >= 3 && strcmp(argv[1], "--merge-sketches") == 0) {
+		return (mergeSketches(argc - 2, argv + 2)) ? (0) : (-1);
+	}
 
-				sysLog.sysLog <<
-					"[gameLoopPlay] Level passed" << endl;
+	// Run the hardware benchmarks in a stand-in GPIO tree, removed on
+	// return, unless the pins are the kernel's
+	StandInTree standInTree;
 
-				// Speed up level
-				sysLog.sysLog <<
-					"[gameLoopPlay] Speed up level" << endl;
-				updateLightDuration(game);
+	// Compare the output backends if requested
+	if (argc >= 2 && strcmp(argv[1], "--benchmark-output") == 0) {
+		int numFrames = (argc >= 3) ? (atoi(argv[2])) : (10000);
 
-				// Update current level
-				game->currentLevel++;
-				sysLog.sysLog <<
-					"[gameLoopPlay] Current level set to "
-					<< game->currentLevel << endl;
+		return (standInTree.enter() && benchmarkOutput(numFrames)) ?
+			(0) : (-1);
+	}
 
-				// Update high score
-				if (game->currentLevel > stats->highScore) {
+	// Measure the speed of a shift register chain if requested
+	if (argc >= 2 && strcmp(argv[1], "--benchmark-shift-register") == 0) {
+		int numLights = (argc >= 3) ?
+			(atoi(argv[2])) : (DEFAULT_SHIFT_REGISTER_LIGHTS);
+		int numFrames = (argc >= 4) ? (atoi(argv[3])) : (2000);
 
-					// Check for errors
-					if (!highScoreFunc(stats, game)) {
-						sysLog.sysLog << "[gameLoopPlay] " <<
-							"ERROR: High score could not be updated" << endl;
+		return (standInTree.enter() &&
+			benchmarkShiftRegister(numLights, numFrames)) ? (0) : (-1);
+	}
 
-						return false;
-					}
-				}
-			}
-		}
+	// Measure the refresh jitter of the score display if requested
+	if (argc >= 2 && strcmp(argv[1], "--benchmark-display") == 0) {
+		float seconds = (argc >= 3) ? (atof(argv[2])) : (2);
 
-		sysLog.sysLog <<
-			"[gameLoopPlay] Exiting passedLevel loop" << endl;
+		return (standInTree.enter() && benchmarkDisplay(seconds)) ?
+			(0) : (-1);
+	}
 
-		// Decrement number of lives
-		game->numLivesRemaining -= 1;
+	// Measure how fairly two buttons are stamped if requested
+	if (argc >= 2 && strcmp(argv[1], "--benchmark-buttons") == 0) {
+		int numTrials = (argc >= 3) ? (atoi(argv[2])) : (500);
 
-		sysLog.sysLog <<
-			"[gameLoopPlay] Number of lives set to " <<
-			game->numLivesRemaining << endl;
+		return (standInTree.enter() && benchmarkButtons(numTrials)) ?
+			(0) : (-1);
 	}
 
-	// Reset game
-	sysLog.sysLog << "[gameLoopPlay] " <<
-		"Resetting game" << endl;
+	// Measure the time from a press to a change of the lights if requested
+	if (argc >= 2 && strcmp(argv[1], "--benchmark-latency") == 0) {
+		int numTrials = (argc >= 3) ? (atoi(argv[2])) : (2000);
 
-	if (!reset(game)) {
-		sysLog.sysLog << "[gameLoopPlay] " <<
-			"ERROR: Game could not be reset" << endl;
+		return (standInTree.enter() && benchmarkLatency(numTrials)) ?
+			(0) : (-1);
+	}
 
-		return false;
+	// Measure the strip and button under injected faults if requested
+	if (argc >= 2 && strcmp(argv[1], "--benchmark-faults") == 0) {
+		float seconds = (argc >= 3) ? (atof(argv[2])) : (5);
+
+		return (standInTree.enter() && benchmarkFaults(seconds)) ?
+			(0) : (-1);
 	}
 
-	sysLog.sysLog <<
-		"[gameLoopPlay] Exiting life loop" << endl;
-	sysLog.sysLog <<
-		"[gameLoopPlay] Game ended with final score "
-		<< game->currentLevel << endl;
+	// Measure the cost of publishing the shared state if requested
+	if (argc >= 2 && strcmp(argv[1], "--benchmark-shared-state") == 0) {
+		int numPublishes = (argc >= 3) ? (atoi(argv[2])) : (20000000);
 
-	return true;
-}
+		return (benchmarkSharedState(numPublishes)) ? (0) : (-1);
+	}
 
-// ------------ [Functions for handling game logic end here] ----------- //
+	// Measure the cost of publishing game events if requested
+	if (argc >= 2 && strcmp(argv[1], "--benchmark-events") == 0) {
+		int numEvents = (argc >= 3) ? (atoi(argv[2])) : (20000000);
 
+		return (benchmarkEvents(numEvents)) ? (0) : (-1);
+	}
 
+	// Measure the cost of the software PWM if requested
+	if (argc >= 2 && strcmp(argv[1], "--benchmark-pwm") == 0) {
+		float seconds = (argc >= 3) ? (atof(argv[2])) : (2);
 
-// Set up and run the game:
-int main (const int argc, const char* const argv[]) {
-	sysLog.sysLog << "[main] " <<
-		"Program started" << endl;
+		return (standInTree.enter() && benchmarkPWM(seconds)) ?
+			(0) : (-1);
+	}
+
+	bool runsAsDaemon = false;
+	bool playsAttract = false;
+	const char* recordingFile = NULL;
+
+	// Parse options for playing the game
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--player") == 0 && i + 1 < argc) {
+			playerName = argv[i + 1];
+			i++;
+		} else if (strcmp(argv[i], "--io-uring") == 0) {
+			lightBackend = OUTPUT_IO_URING;
+		} else if (strcmp(argv[i], "--warm") == 0) {
+			warmRestart = true;
+		} else if (strcmp(argv[i], "--daemon") == 0) {
+			runsAsDaemon = true;
+		} else if (strcmp(argv[i], "--attract") == 0) {
+			playsAttract = true;
+		} else if (strcmp(argv[i], "--shift-register") == 0) {
+			lightBackend = OUTPUT_SHIFT_REGISTER;
+
+			// Take the length of the chain if it is given
+			if (i + 1 < argc && atoi(argv[i + 1]) > 0) {
+				shiftRegisterLength = atoi(argv[i + 1]);
+				i++;
+			}
+		} else if (strcmp(argv[i], "--display") == 0) {
+			showsScores = true;
+		} else if (strcmp(argv[i], "--two-player") == 0) {
+			playsHeadToHead = true;
+		} else if (strcmp(argv[i], "--precision") == 0) {
+			scoresPrecision = true;
+		} else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+			recordingFile = argv[i + 1];
+			i++;
+		} else if (strcmp(argv[i], "--pwm") == 0 && i + 1 < argc) {
+			pwmFrequency = atoi(argv[i + 1]);
+			i++;
+		}
+	}
 
 	Statistics* stats = new Statistics;
 	GameData* game = new GameData;
 
-	if (!initialize(stats, game)) {
+	// Resume from the snapshot of a warm exit if asked to
+	bool isWarmStart = warmRestart && readSnapshot(stats, game);
+
+	if (!initialize(stats, game, isWarmStart)) {
 		sysLog.sysLog << "[main] " <<
 			"ERROR: Could not initialize game - exiting game" << endl;
 
 		return -1;
 	}
 
-	if (!readStats(stats)) {
+	// Load statistics from the statistics file and the journal
+	if (!statsJournal.open(stats, isWarmStart)) {
+		sysLog.sysLog << "[main] " <<
+			"Warning: Could not open statistics journal" << endl;
+	}
+
+	if (!leaderboard.open(LEADERBOARD_FILE)) {
+		sysLog.sysLog << "[main] " <<
+			"Warning: Could not open leaderboard" << endl;
+	}
+
+	reactionSketches.read(SKETCH_FILE);
+
+	if (!sessionHistory.open(HISTORY_FILE, true)) {
+		sysLog.sysLog << "[main] " <<
+			"Warning: Could not open session history" << endl;
+	}
+
+	// Let other processes follow the game
+	if (!gameEvents.create(EVENT_RING_NAME)) {
+		sysLog.sysLog << "[main] " <<
+			"Warning: Could not create event stream" << endl;
+	}
+
+	if (sharedState.create(SHARED_STATE_NAME)) {
+		sharedState.publish(stats, game, false);
+		sharedState.publishLeaderboard(&leaderboard);
+	} else {
+		sysLog.sysLog << "[main] " <<
+			"Warning: Could not create shared state" << endl;
+	}
+
+	// Record the input of each game if asked to
+	if (recordingFile != NULL && !inputRecorder.open(recordingFile)) {
 		sysLog.sysLog << "[main] " <<
-			"Warning: Could not read statistics from file" << endl;
+			"Warning: Could not open input recording" << endl;
 	}
 
+	// Show the high score while waiting for the first game
+	segmentDisplay.showScores(0, stats->highScore);
+
 	sysLog.sysLog << "[main] " <<
 		"Resetting game" << endl;
 
@@ -1587,31 +13273,95 @@ int main (const int argc, const char* const argv[]) {
 		return -1;
 	}
 
-	//Loop while the game has not been idle for MAX_IDLE_TIME
-	sysLog.sysLog << "[main] " <<
-		"Entering gameLoopIdle state" << endl;
+	int exitCode = 0;
 
-	while (gameLoopIdle(stats, game)) {
-		sleep(DEFAULT_PAUSE_TIME);
+	if (runsAsDaemon) {
+		// Take commands until a shutdown is requested, failing so that a
+		// supervisor notices if commands cannot be taken
+		if (!controlServer.open(CONTROL_SOCKET, &sharedState)) {
+			sysLog.sysLog << "[main] " <<
+				"ERROR: Could not open control socket - exiting game" << endl;
+
+			exitCode = -1;
+		}
 
 		sysLog.sysLog << "[main] " <<
-			"Entering gameLoopPlay state" << endl;
+			"Entering gameLoopWait state" << endl;
+
+		while (controlServer.getWakeFileDescriptor() >= 0 &&
+				((playsAttract) ? (gameLoopAttract(0)) : (gameLoopWait()))) {
+			// Apply a difficulty set since the last game
+			if (controlServer.takeDifficulty(&gameDifficulty)) {
+				sysLog.sysLog << "[main] " <<
+					"Difficulty set to " << gameDifficulty.timePerLevel <<
+					" second(s) per level, " <<
+					gameDifficulty.initialTimePerLight <<
+					" second(s) per light, scaling " <<
+					gameDifficulty.scalingTimePerLight << ", " <<
+					gameDifficulty.initialNumLives << " lives" << endl;
+
+				resetGameData(game);
+			}
 
-		gameLoopPlay(stats, game);
-		sleep(DEFAULT_PAUSE_TIME);
+			sleep(DEFAULT_PAUSE_TIME);
+
+			sysLog.sysLog << "[main] " <<
+				"Entering gameLoopPlay state" << endl;
+
+			if (playsHeadToHead) {
+				gameLoopHeadToHead(game);
+			} else {
+				gameLoopPlay(stats, game);
+			}
+
+			sleep(DEFAULT_PAUSE_TIME);
+		}
+
+		controlServer.close();
+	} else {
+		//Loop while the game has not been idle for MAX_IDLE_TIME
+		sysLog.sysLog << "[main] " <<
+			"Entering gameLoopIdle state" << endl;
+
+		while ((playsAttract) ? (gameLoopAttract(MAX_IDLE_TIME)) :
+				(gameLoopIdle(stats, game))) {
+			sleep(DEFAULT_PAUSE_TIME);
+
+			sysLog.sysLog << "[main] " <<
+				"Entering gameLoopPlay state" << endl;
+
+			if (playsHeadToHead) {
+				gameLoopHeadToHead(game);
+			} else {
+				gameLoopPlay(stats, game);
+			}
+
+			sleep(DEFAULT_PAUSE_TIME);
+		}
 	}
 
-	// Calculate total play time
-	playTime(stats);
+	// Fold the journal into the statistics file
+	statsJournal.compact(stats);
+	statsJournal.close();
+	leaderboard.close();
+	sessionHistory.close();
+	sharedState.close();
+	gameEvents.close();
+	inputRecorder.close();
+
+	// Exit game, leaving the pins set up for the next start if asked to
+	if (warmRestart && !writeSnapshot(stats, game)) {
+		sysLog.sysLog << "[main] " <<
+			"WARNING: Could not write snapshot" << endl;
+	}
 
-	// Write statistics to file
-	writeStats(stats);
+	deinitialize(warmRestart);
 
-	// Exit game
-	deinitialize();
+	systemTimers.logStatistics("main");
+	LogLimit::reportAll();
 
 	sysLog.sysLog << "[main] " <<
 		"Exiting game" << endl;
 
-	return 0;
+	return exitCode;
 }